@@ -6,6 +6,7 @@
 #include "physics/ObjectLink.h"
 #include "render/MainWindow.h"
 #include "physics/RigidBody.h"
+#include "physics/SplitBroadphase.h"
 
 #define UPDATES_PER_SECOND 1000
 
@@ -34,6 +35,9 @@ void initGeometry() {
 
     world.addObject(new PhysicsObject(Vector3(),Vector3(),0,false,Shape::tiledFloor(Vector3(),10,1,{0.15,0.15,0.15},C_PURPLE)));
 
+    // The bars are far longer than they are wide, so boxes fit them much better than spheres
+    world.setBroadphase(new SplitBroadphase<BoundingBox>());
+
     RigidBodyModel *barLong = new RectangularPrismModel(5,0.2,0.2);
     RigidBodyModel *barShort = new RectangularPrismModel(3,0.2,0.2);
     RigidBodyModel *cube = new RectangularPrismModel(0.4,0.4,0.4);
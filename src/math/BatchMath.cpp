@@ -0,0 +1,341 @@
+#include "BatchMath.h"
+
+#include <algorithm>
+#include <type_traits>
+
+/*
+ * The SIMD kernels are compiled with per-function target attributes
+ * rather than global compiler flags, so the whole engine can still be
+ * built for the baseline CPU and only the kernels use wider instructions.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BATCHMATH_X86
+#include <immintrin.h>
+
+static_assert(std::is_same<real, float>::value, "The SIMD batch kernels assume real is a float");
+#endif
+
+namespace {
+
+Vector3Stream offset(Vector3Stream s, unsigned int n) { return {s.x + n, s.y + n, s.z + n}; }
+
+/*
+ * Scalar kernels. These are also used for the leftover
+ * elements that don't fill a whole register in the SIMD kernels.
+ */
+namespace scalar {
+
+unsigned int overlapHalfSpace(Vector3 normal, real planeOffset, Vector3Stream centers, const real* radii, unsigned int count, unsigned char* results) {
+    unsigned int touching = 0;
+    for (unsigned int n = 0; n < count; n++) {
+        results[n] = normal.x*centers.x[n] + normal.y*centers.y[n] + normal.z*centers.z[n] - radii[n] <= planeOffset;
+        touching += results[n];
+    }
+    return touching;
+}
+
+void sampleGrid(const SampleGrid& grid, Vector3Stream points, unsigned int count, real* results, Vector3Stream gradients) {
+    real inverse = 1 / grid.cellSize;
+    unsigned int counts[3] = {grid.countX, grid.countY, grid.countZ};
+    unsigned int strideY = grid.countX, strideZ = grid.countX * grid.countY;
+    for (unsigned int n = 0; n < count; n++) {
+        real position[3] = {(points.x[n] - grid.origin.x) * inverse, (points.y[n] - grid.origin.y) * inverse, (points.z[n] - grid.origin.z) * inverse};
+        unsigned int cell[3];
+        real t[3];
+        for (int a = 0; a < 3; a++) {
+            real clamped = std::max((real)0, std::min((real)(counts[a] - 1), position[a]));
+            cell[a] = std::min((unsigned int)clamped, counts[a] - 2);
+            t[a] = clamped - cell[a];
+        }
+        const real* v = grid.values + cell[0] + strideY*cell[1] + strideZ*cell[2];
+
+        // Blend along x, then y, then z, keeping the differences for the gradient
+        real dx00 = v[1] - v[0], dx10 = v[strideY+1] - v[strideY], dx01 = v[strideZ+1] - v[strideZ], dx11 = v[strideZ+strideY+1] - v[strideZ+strideY];
+        real c00 = v[0] + t[0]*dx00, c10 = v[strideY] + t[0]*dx10, c01 = v[strideZ] + t[0]*dx01, c11 = v[strideZ+strideY] + t[0]*dx11;
+        real dy0 = c10 - c00, dy1 = c11 - c01;
+        real c0 = c00 + t[1]*dy0, c1 = c01 + t[1]*dy1;
+        real gx0 = dx00 + t[1]*(dx10 - dx00), gx1 = dx01 + t[1]*(dx11 - dx01);
+        results[n] = c0 + t[2]*(c1 - c0);
+        gradients.x[n] = (gx0 + t[2]*(gx1 - gx0)) * inverse;
+        gradients.y[n] = (dy0 + t[2]*(dy1 - dy0)) * inverse;
+        gradients.z[n] = (c1 - c0) * inverse;
+    }
+}
+
+}
+
+#ifdef BATCHMATH_X86
+
+/*
+ * 4-wide kernels. SSE2 is part of the x86-64 baseline, so these
+ * are available on every 64-bit machine.
+ */
+namespace sse {
+
+#define SSE_TARGET __attribute__((target("sse2")))
+
+struct Vec3Reg { __m128 x, y, z; };
+
+SSE_TARGET inline Vec3Reg load(Vector3Stream s, unsigned int n) { return {_mm_loadu_ps(s.x + n), _mm_loadu_ps(s.y + n), _mm_loadu_ps(s.z + n)}; }
+SSE_TARGET inline void store(Vector3Stream s, unsigned int n, const Vec3Reg& v) { _mm_storeu_ps(s.x + n, v.x); _mm_storeu_ps(s.y + n, v.y); _mm_storeu_ps(s.z + n, v.z); }
+
+SSE_TARGET unsigned int overlapHalfSpace(Vector3 normal, real planeOffset, Vector3Stream centers, const real* radii, unsigned int count, unsigned char* results) {
+    __m128 nx = _mm_set1_ps(normal.x), ny = _mm_set1_ps(normal.y), nz = _mm_set1_ps(normal.z), d = _mm_set1_ps(planeOffset);
+    unsigned int touching = 0, n = 0;
+    for (; n + 4 <= count; n += 4) {
+        Vec3Reg c = load(centers, n);
+        __m128 height = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c.x, nx), _mm_mul_ps(c.y, ny)), _mm_mul_ps(c.z, nz));
+        int mask = _mm_movemask_ps(_mm_cmple_ps(_mm_sub_ps(height, _mm_loadu_ps(radii + n)), d));
+        for (int lane = 0; lane < 4; lane++) { results[n + lane] = (mask >> lane) & 1; }
+        touching += __builtin_popcount(mask);
+    }
+    return touching + scalar::overlapHalfSpace(normal, planeOffset, offset(centers, n), radii + n, count - n, results + n);
+}
+
+SSE_TARGET void sampleGrid(const SampleGrid& grid, Vector3Stream points, unsigned int count, real* results, Vector3Stream gradients) {
+    __m128 inverse = _mm_set1_ps(1 / grid.cellSize), zero = _mm_setzero_ps();
+    __m128 ox = _mm_set1_ps(grid.origin.x), oy = _mm_set1_ps(grid.origin.y), oz = _mm_set1_ps(grid.origin.z);
+    __m128 lastX = _mm_set1_ps(grid.countX - 1), lastY = _mm_set1_ps(grid.countY - 1), lastZ = _mm_set1_ps(grid.countZ - 1);
+    __m128 lastCellX = _mm_set1_ps(grid.countX - 2), lastCellY = _mm_set1_ps(grid.countY - 2), lastCellZ = _mm_set1_ps(grid.countZ - 2);
+    unsigned int strideY = grid.countX, strideZ = grid.countX * grid.countY;
+    const unsigned int corners[8] = {0, 1, strideY, strideY + 1, strideZ, strideZ + 1, strideZ + strideY, strideZ + strideY + 1};
+    unsigned int n = 0;
+    for (; n + 4 <= count; n += 4) {
+        Vec3Reg p = load(points, n);
+        __m128 fx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(p.x, ox), inverse), zero), lastX);
+        __m128 fy = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(p.y, oy), inverse), zero), lastY);
+        __m128 fz = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(p.z, oz), inverse), zero), lastZ);
+        // The positions aren't negative, so truncating floors them
+        __m128 cx = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fx)), lastCellX);
+        __m128 cy = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fy)), lastCellY);
+        __m128 cz = _mm_min_ps(_mm_cvtepi32_ps(_mm_cvttps_epi32(fz)), lastCellZ);
+        __m128 tx = _mm_sub_ps(fx, cx), ty = _mm_sub_ps(fy, cy), tz = _mm_sub_ps(fz, cz);
+
+        // SSE2 has no gather, so fetch each lane's corners one at a time
+        alignas(16) int ix[4], iy[4], iz[4];
+        _mm_store_si128((__m128i*) ix, _mm_cvttps_epi32(cx));
+        _mm_store_si128((__m128i*) iy, _mm_cvttps_epi32(cy));
+        _mm_store_si128((__m128i*) iz, _mm_cvttps_epi32(cz));
+        alignas(16) real values[8][4];
+        for (int lane = 0; lane < 4; lane++) {
+            const real* v = grid.values + ix[lane] + strideY*iy[lane] + strideZ*iz[lane];
+            for (int c = 0; c < 8; c++) { values[c][lane] = v[corners[c]]; }
+        }
+        __m128 c000 = _mm_load_ps(values[0]), c100 = _mm_load_ps(values[1]), c010 = _mm_load_ps(values[2]), c110 = _mm_load_ps(values[3]);
+        __m128 c001 = _mm_load_ps(values[4]), c101 = _mm_load_ps(values[5]), c011 = _mm_load_ps(values[6]), c111 = _mm_load_ps(values[7]);
+
+        __m128 dx00 = _mm_sub_ps(c100, c000), dx10 = _mm_sub_ps(c110, c010), dx01 = _mm_sub_ps(c101, c001), dx11 = _mm_sub_ps(c111, c011);
+        __m128 c00 = _mm_add_ps(c000, _mm_mul_ps(tx, dx00)), c10 = _mm_add_ps(c010, _mm_mul_ps(tx, dx10));
+        __m128 c01 = _mm_add_ps(c001, _mm_mul_ps(tx, dx01)), c11 = _mm_add_ps(c011, _mm_mul_ps(tx, dx11));
+        __m128 dy0 = _mm_sub_ps(c10, c00), dy1 = _mm_sub_ps(c11, c01);
+        __m128 c0 = _mm_add_ps(c00, _mm_mul_ps(ty, dy0)), c1 = _mm_add_ps(c01, _mm_mul_ps(ty, dy1));
+        __m128 gx0 = _mm_add_ps(dx00, _mm_mul_ps(ty, _mm_sub_ps(dx10, dx00))), gx1 = _mm_add_ps(dx01, _mm_mul_ps(ty, _mm_sub_ps(dx11, dx01)));
+        __m128 dz = _mm_sub_ps(c1, c0);
+        _mm_storeu_ps(results + n, _mm_add_ps(c0, _mm_mul_ps(tz, dz)));
+        Vec3Reg gradient = {_mm_mul_ps(_mm_add_ps(gx0, _mm_mul_ps(tz, _mm_sub_ps(gx1, gx0))), inverse),
+                            _mm_mul_ps(_mm_add_ps(dy0, _mm_mul_ps(tz, _mm_sub_ps(dy1, dy0))), inverse),
+                            _mm_mul_ps(dz, inverse)};
+        store(gradients, n, gradient);
+    }
+    scalar::sampleGrid(grid, offset(points, n), count - n, results + n, offset(gradients, n));
+}
+
+}
+
+/*
+ * 8-wide kernels
+ */
+namespace avx2 {
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+struct Vec3Reg { __m256 x, y, z; };
+
+AVX2_TARGET inline Vec3Reg load(Vector3Stream s, unsigned int n) { return {_mm256_loadu_ps(s.x + n), _mm256_loadu_ps(s.y + n), _mm256_loadu_ps(s.z + n)}; }
+AVX2_TARGET inline void store(Vector3Stream s, unsigned int n, const Vec3Reg& v) { _mm256_storeu_ps(s.x + n, v.x); _mm256_storeu_ps(s.y + n, v.y); _mm256_storeu_ps(s.z + n, v.z); }
+
+AVX2_TARGET unsigned int overlapHalfSpace(Vector3 normal, real planeOffset, Vector3Stream centers, const real* radii, unsigned int count, unsigned char* results) {
+    __m256 nx = _mm256_set1_ps(normal.x), ny = _mm256_set1_ps(normal.y), nz = _mm256_set1_ps(normal.z), d = _mm256_set1_ps(planeOffset);
+    unsigned int touching = 0, n = 0;
+    for (; n + 8 <= count; n += 8) {
+        Vec3Reg c = load(centers, n);
+        __m256 height = _mm256_fmadd_ps(c.x, nx, _mm256_fmadd_ps(c.y, ny, _mm256_mul_ps(c.z, nz)));
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_sub_ps(height, _mm256_loadu_ps(radii + n)), d, _CMP_LE_OQ));
+        for (int lane = 0; lane < 8; lane++) { results[n + lane] = (mask >> lane) & 1; }
+        touching += __builtin_popcount(mask);
+    }
+    return touching + sse::overlapHalfSpace(normal, planeOffset, offset(centers, n), radii + n, count - n, results + n);
+}
+
+AVX2_TARGET void sampleGrid(const SampleGrid& grid, Vector3Stream points, unsigned int count, real* results, Vector3Stream gradients) {
+    __m256 inverse = _mm256_set1_ps(1 / grid.cellSize), zero = _mm256_setzero_ps();
+    __m256 ox = _mm256_set1_ps(grid.origin.x), oy = _mm256_set1_ps(grid.origin.y), oz = _mm256_set1_ps(grid.origin.z);
+    __m256 lastX = _mm256_set1_ps(grid.countX - 1), lastY = _mm256_set1_ps(grid.countY - 1), lastZ = _mm256_set1_ps(grid.countZ - 1);
+    __m256 lastCellX = _mm256_set1_ps(grid.countX - 2), lastCellY = _mm256_set1_ps(grid.countY - 2), lastCellZ = _mm256_set1_ps(grid.countZ - 2);
+    int strideY = grid.countX, strideZ = grid.countX * grid.countY;
+    __m256i strideYs = _mm256_set1_epi32(strideY), strideZs = _mm256_set1_epi32(strideZ);
+    const int corners[8] = {0, 1, strideY, strideY + 1, strideZ, strideZ + 1, strideZ + strideY, strideZ + strideY + 1};
+    unsigned int n = 0;
+    for (; n + 8 <= count; n += 8) {
+        Vec3Reg p = load(points, n);
+        __m256 fx = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(p.x, ox), inverse), zero), lastX);
+        __m256 fy = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(p.y, oy), inverse), zero), lastY);
+        __m256 fz = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(p.z, oz), inverse), zero), lastZ);
+        __m256 cx = _mm256_min_ps(_mm256_floor_ps(fx), lastCellX);
+        __m256 cy = _mm256_min_ps(_mm256_floor_ps(fy), lastCellY);
+        __m256 cz = _mm256_min_ps(_mm256_floor_ps(fz), lastCellZ);
+        __m256 tx = _mm256_sub_ps(fx, cx), ty = _mm256_sub_ps(fy, cy), tz = _mm256_sub_ps(fz, cz);
+
+        __m256i base = _mm256_add_epi32(_mm256_cvttps_epi32(cx), _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvttps_epi32(cy), strideYs),
+                                                                                   _mm256_mullo_epi32(_mm256_cvttps_epi32(cz), strideZs)));
+        __m256 c[8];
+        for (int i = 0; i < 8; i++) { c[i] = _mm256_i32gather_ps(grid.values, _mm256_add_epi32(base, _mm256_set1_epi32(corners[i])), 4); }
+
+        __m256 dx00 = _mm256_sub_ps(c[1], c[0]), dx10 = _mm256_sub_ps(c[3], c[2]), dx01 = _mm256_sub_ps(c[5], c[4]), dx11 = _mm256_sub_ps(c[7], c[6]);
+        __m256 c00 = _mm256_fmadd_ps(tx, dx00, c[0]), c10 = _mm256_fmadd_ps(tx, dx10, c[2]);
+        __m256 c01 = _mm256_fmadd_ps(tx, dx01, c[4]), c11 = _mm256_fmadd_ps(tx, dx11, c[6]);
+        __m256 dy0 = _mm256_sub_ps(c10, c00), dy1 = _mm256_sub_ps(c11, c01);
+        __m256 c0 = _mm256_fmadd_ps(ty, dy0, c00), c1 = _mm256_fmadd_ps(ty, dy1, c01);
+        __m256 gx0 = _mm256_fmadd_ps(ty, _mm256_sub_ps(dx10, dx00), dx00), gx1 = _mm256_fmadd_ps(ty, _mm256_sub_ps(dx11, dx01), dx01);
+        __m256 dz = _mm256_sub_ps(c1, c0);
+        _mm256_storeu_ps(results + n, _mm256_fmadd_ps(tz, dz, c0));
+        Vec3Reg gradient = {_mm256_mul_ps(_mm256_fmadd_ps(tz, _mm256_sub_ps(gx1, gx0), gx0), inverse),
+                            _mm256_mul_ps(_mm256_fmadd_ps(tz, _mm256_sub_ps(dy1, dy0), dy0), inverse),
+                            _mm256_mul_ps(dz, inverse)};
+        store(gradients, n, gradient);
+    }
+    sse::sampleGrid(grid, offset(points, n), count - n, results + n, offset(gradients, n));
+}
+
+}
+
+/*
+ * 16-wide kernels
+ */
+namespace avx512 {
+
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+struct Vec3Reg { __m512 x, y, z; };
+
+AVX512_TARGET inline Vec3Reg load(Vector3Stream s, unsigned int n) { return {_mm512_loadu_ps(s.x + n), _mm512_loadu_ps(s.y + n), _mm512_loadu_ps(s.z + n)}; }
+AVX512_TARGET inline void store(Vector3Stream s, unsigned int n, const Vec3Reg& v) { _mm512_storeu_ps(s.x + n, v.x); _mm512_storeu_ps(s.y + n, v.y); _mm512_storeu_ps(s.z + n, v.z); }
+
+// The unmasked min, max, convert and gather intrinsics pass an undefined register
+// to the masked builtins, which GCC warns may be uninitialized, so mask with zeros instead
+AVX512_TARGET inline __m512 min(__m512 a, __m512 b) { return _mm512_maskz_min_ps(0xFFFF, a, b); }
+AVX512_TARGET inline __m512 max(__m512 a, __m512 b) { return _mm512_maskz_max_ps(0xFFFF, a, b); }
+AVX512_TARGET inline __m512i truncate(__m512 a) { return _mm512_maskz_cvttps_epi32(0xFFFF, a); }
+AVX512_TARGET inline __m512 gather(__m512i indices, const real* values) { return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, indices, values, 4); }
+
+AVX512_TARGET unsigned int overlapHalfSpace(Vector3 normal, real planeOffset, Vector3Stream centers, const real* radii, unsigned int count, unsigned char* results) {
+    __m512 nx = _mm512_set1_ps(normal.x), ny = _mm512_set1_ps(normal.y), nz = _mm512_set1_ps(normal.z), d = _mm512_set1_ps(planeOffset);
+    unsigned int touching = 0, n = 0;
+    for (; n + 16 <= count; n += 16) {
+        Vec3Reg c = load(centers, n);
+        __m512 height = _mm512_fmadd_ps(c.x, nx, _mm512_fmadd_ps(c.y, ny, _mm512_mul_ps(c.z, nz)));
+        __mmask16 mask = _mm512_cmp_ps_mask(_mm512_sub_ps(height, _mm512_loadu_ps(radii + n)), d, _CMP_LE_OQ);
+        for (int lane = 0; lane < 16; lane++) { results[n + lane] = (mask >> lane) & 1; }
+        touching += __builtin_popcount(mask);
+    }
+    return touching + avx2::overlapHalfSpace(normal, planeOffset, offset(centers, n), radii + n, count - n, results + n);
+}
+
+AVX512_TARGET void sampleGrid(const SampleGrid& grid, Vector3Stream points, unsigned int count, real* results, Vector3Stream gradients) {
+    __m512 inverse = _mm512_set1_ps(1 / grid.cellSize), zero = _mm512_setzero_ps();
+    __m512 ox = _mm512_set1_ps(grid.origin.x), oy = _mm512_set1_ps(grid.origin.y), oz = _mm512_set1_ps(grid.origin.z);
+    __m512 lastX = _mm512_set1_ps(grid.countX - 1), lastY = _mm512_set1_ps(grid.countY - 1), lastZ = _mm512_set1_ps(grid.countZ - 1);
+    __m512 lastCellX = _mm512_set1_ps(grid.countX - 2), lastCellY = _mm512_set1_ps(grid.countY - 2), lastCellZ = _mm512_set1_ps(grid.countZ - 2);
+    int strideY = grid.countX, strideZ = grid.countX * grid.countY;
+    __m512i strideYs = _mm512_set1_epi32(strideY), strideZs = _mm512_set1_epi32(strideZ);
+    const int corners[8] = {0, 1, strideY, strideY + 1, strideZ, strideZ + 1, strideZ + strideY, strideZ + strideY + 1};
+    unsigned int n = 0;
+    for (; n + 16 <= count; n += 16) {
+        Vec3Reg p = load(points, n);
+        __m512 fx = min(max(_mm512_mul_ps(_mm512_sub_ps(p.x, ox), inverse), zero), lastX);
+        __m512 fy = min(max(_mm512_mul_ps(_mm512_sub_ps(p.y, oy), inverse), zero), lastY);
+        __m512 fz = min(max(_mm512_mul_ps(_mm512_sub_ps(p.z, oz), inverse), zero), lastZ);
+        __m512 cx = min(_mm512_floor_ps(fx), lastCellX);
+        __m512 cy = min(_mm512_floor_ps(fy), lastCellY);
+        __m512 cz = min(_mm512_floor_ps(fz), lastCellZ);
+        __m512 tx = _mm512_sub_ps(fx, cx), ty = _mm512_sub_ps(fy, cy), tz = _mm512_sub_ps(fz, cz);
+
+        __m512i base = _mm512_add_epi32(truncate(cx), _mm512_add_epi32(_mm512_mullo_epi32(truncate(cy), strideYs), _mm512_mullo_epi32(truncate(cz), strideZs)));
+        __m512 c[8];
+        for (int i = 0; i < 8; i++) { c[i] = gather(_mm512_add_epi32(base, _mm512_set1_epi32(corners[i])), grid.values); }
+
+        __m512 dx00 = _mm512_sub_ps(c[1], c[0]), dx10 = _mm512_sub_ps(c[3], c[2]), dx01 = _mm512_sub_ps(c[5], c[4]), dx11 = _mm512_sub_ps(c[7], c[6]);
+        __m512 c00 = _mm512_fmadd_ps(tx, dx00, c[0]), c10 = _mm512_fmadd_ps(tx, dx10, c[2]);
+        __m512 c01 = _mm512_fmadd_ps(tx, dx01, c[4]), c11 = _mm512_fmadd_ps(tx, dx11, c[6]);
+        __m512 dy0 = _mm512_sub_ps(c10, c00), dy1 = _mm512_sub_ps(c11, c01);
+        __m512 c0 = _mm512_fmadd_ps(ty, dy0, c00), c1 = _mm512_fmadd_ps(ty, dy1, c01);
+        __m512 gx0 = _mm512_fmadd_ps(ty, _mm512_sub_ps(dx10, dx00), dx00), gx1 = _mm512_fmadd_ps(ty, _mm512_sub_ps(dx11, dx01), dx01);
+        __m512 dz = _mm512_sub_ps(c1, c0);
+        _mm512_storeu_ps(results + n, _mm512_fmadd_ps(tz, dz, c0));
+        Vec3Reg gradient = {_mm512_mul_ps(_mm512_fmadd_ps(tz, _mm512_sub_ps(gx1, gx0), gx0), inverse),
+                            _mm512_mul_ps(_mm512_fmadd_ps(tz, _mm512_sub_ps(dy1, dy0), dy0), inverse),
+                            _mm512_mul_ps(dz, inverse)};
+        store(gradients, n, gradient);
+    }
+    avx2::sampleGrid(grid, offset(points, n), count - n, results + n, offset(gradients, n));
+}
+
+}
+
+#endif
+
+}
+
+SimdLevel BatchMath::detectLevel() {
+#ifdef BATCHMATH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) { return SimdLevel::AVX512; }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { return SimdLevel::AVX2; }
+    if (__builtin_cpu_supports("sse2")) { return SimdLevel::SSE; }
+#endif
+    return SimdLevel::SCALAR;
+}
+
+const char* BatchMath::levelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SSE: return "SSE";
+        case SimdLevel::AVX2: return "AVX2";
+        case SimdLevel::AVX512: return "AVX-512";
+        default: return "scalar";
+    }
+}
+
+BatchMath::Kernels BatchMath::getKernels(SimdLevel level) {
+#ifdef BATCHMATH_X86
+    switch (level) {
+        case SimdLevel::AVX512:
+            return {level, avx512::overlapHalfSpace, avx512::sampleGrid};
+        case SimdLevel::AVX2:
+            return {level, avx2::overlapHalfSpace, avx2::sampleGrid};
+        case SimdLevel::SSE:
+            return {level, sse::overlapHalfSpace, sse::sampleGrid};
+        default:
+            break;
+    }
+#endif
+    return {SimdLevel::SCALAR, scalar::overlapHalfSpace, scalar::sampleGrid};
+}
+
+BatchMath::Kernels& BatchMath::activeKernels() {
+    static Kernels kernels = getKernels(detectLevel());
+    return kernels;
+}
+
+SimdLevel BatchMath::getLevel() { return activeKernels().level; }
+
+void BatchMath::setLevel(SimdLevel level) {
+    activeKernels() = getKernels(std::min(level, detectLevel()));
+}
+
+unsigned int BatchMath::overlapHalfSpace(Vector3 normal, real offset, Vector3Stream centers, const real* radii, unsigned int count, unsigned char* results) {
+    return activeKernels().overlapHalfSpace(normal, offset, centers, radii, count, results);
+}
+
+void BatchMath::sampleGrid(const SampleGrid &grid, Vector3Stream points, unsigned int count, real *results, Vector3Stream gradients) {
+    activeKernels().sampleGrid(grid, points, count, results, gradients);
+}
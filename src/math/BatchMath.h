@@ -0,0 +1,192 @@
+#ifndef PHYSICSENGINE_BATCHMATH_H
+#define PHYSICSENGINE_BATCHMATH_H
+
+#include <algorithm>
+#include "precision.h"
+#include "Vector3.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*
+ * The instruction sets the batch kernels can be run with,
+ * from narrowest to widest.
+ */
+enum class SimdLevel {
+    SCALAR, SSE, AVX2, AVX512
+};
+
+/*
+ * A fixed-width block of N Vector3s stored as a structure
+ * of arrays, so that each component can be loaded into a
+ * single wide register.
+ */
+template<unsigned int N>
+struct alignas(N * sizeof(real)) Vec3xN {
+    real x[N], y[N], z[N];
+
+    Vector3 get(unsigned int lane) const { return {x[lane], y[lane], z[lane]}; }
+    void set(unsigned int lane, const Vector3& v) { x[lane] = v.x; y[lane] = v.y; z[lane] = v.z; }
+};
+
+typedef Vec3xN<4> Vec3x4;
+typedef Vec3xN<8> Vec3x8;
+
+/*
+ * Points at the component arrays of a run of Vector3s
+ * stored as a structure of arrays. The arrays don't need
+ * to be aligned.
+ */
+struct Vector3Stream {
+    real *x, *y, *z;
+
+    Vector3Stream(real* x, real* y, real* z) : x(x), y(y), z(z) {}
+    template<unsigned int N> Vector3Stream(Vec3xN<N>& block) : x(block.x), y(block.y), z(block.z) {}
+};
+
+/*
+ * A grid of values at the corners of cubic cells, stored with x
+ * changing fastest, then y, then z. There must be at least two
+ * values along each axis.
+ */
+struct SampleGrid {
+    const real* values;
+    Vector3 origin;
+    real cellSize;
+    unsigned int countX, countY, countZ;
+};
+
+/*
+ * Math kernels that run over whole arrays of vectors at once.
+ *
+ * Each kernel has a scalar version and SSE, AVX2 and AVX-512
+ * versions. The widest one supported by the CPU is picked the
+ * first time a kernel is called, so a single binary can run on
+ * any machine.
+ */
+class BatchMath {
+public:
+    /*
+     * Returns the widest instruction set supported by this CPU
+     * (and by the precision the engine was built with).
+     */
+    static SimdLevel detectLevel();
+
+    /*
+     * Returns the instruction set currently used by the kernels.
+     */
+    static SimdLevel getLevel();
+
+    /*
+     * Switches the kernels to a narrower instruction set, eg. for
+     * testing or benchmarking. Levels above detectLevel() are clamped.
+     */
+    static void setLevel(SimdLevel level);
+
+    static const char* levelName(SimdLevel level);
+
+    /*
+     * Tests an array of spheres against the half-space of points p where
+     * normal.dot(p) <= offset, writing 1 into results[n] if they touch it
+     * and 0 otherwise. Returns the number touching it.
+     */
+    static unsigned int overlapHalfSpace(Vector3 normal, real offset, Vector3Stream centers, const real* radii, unsigned int count, unsigned char* results);
+
+    /*
+     * Interpolates a grid trilinearly at each point, writing the value
+     * into results[n] and its gradient into gradients. Points outside
+     * the grid are moved onto its nearest face first.
+     */
+    static void sampleGrid(const SampleGrid& grid, Vector3Stream points, unsigned int count, real* results, Vector3Stream gradients);
+
+    /*
+     * Tests a sphere against a single block of spheres and returns a
+     * bitmask of the ones that overlap. This is inlined rather than
+     * dispatched, for tight loops like tree traversals where a kernel
+     * call per block would cost more than the test. It uses SSE2 where
+     * it's part of the baseline instruction set.
+     */
+    template<unsigned int N>
+    static unsigned int overlapSphereBlock(Vector3 center, real radius, const Vec3xN<N>& centers, const real* radii);
+
+    /*
+     * Tests a sphere cast, as in BoundingSphere::overlapsCast, against a
+     * single block of spheres and returns a bitmask of the ones it touches.
+     * Also writes how far along the cast each sphere is into distances.
+     * Inlined like overlapSphereBlock.
+     */
+    template<unsigned int N>
+    static unsigned int overlapCastBlock(Vector3 origin, Vector3 direction, real radius, real maxDistance, const Vec3xN<N>& centers, const real* radii, real* distances);
+
+private:
+    /*
+     * Holds one implementation of every kernel
+     */
+    struct Kernels {
+        SimdLevel level;
+        unsigned int (*overlapHalfSpace)(Vector3 normal, real offset, Vector3Stream centers, const real* radii, unsigned int count, unsigned char* results);
+        void (*sampleGrid)(const SampleGrid& grid, Vector3Stream points, unsigned int count, real* results, Vector3Stream gradients);
+    };
+
+    static Kernels getKernels(SimdLevel level);
+
+    /*
+     * Returns the kernels currently in use, picking them on first use.
+     */
+    static Kernels& activeKernels();
+};
+
+template<unsigned int N>
+inline unsigned int BatchMath::overlapSphereBlock(Vector3 center, real radius, const Vec3xN<N>& centers, const real* radii) {
+    unsigned int mask = 0, n = 0;
+#if defined(__SSE2__)
+    __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z), r = _mm_set1_ps(radius);
+    for (; n + 4 <= N; n += 4) {
+        __m128 dx = _mm_sub_ps(_mm_load_ps(centers.x + n), cx);
+        __m128 dy = _mm_sub_ps(_mm_load_ps(centers.y + n), cy);
+        __m128 dz = _mm_sub_ps(_mm_load_ps(centers.z + n), cz);
+        __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        __m128 reach = _mm_add_ps(r, _mm_loadu_ps(radii + n));
+        mask |= (unsigned int) _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_mul_ps(reach, reach))) << n;
+    }
+#endif
+    for (; n < N; n++) {
+        real reach = radius + radii[n];
+        mask |= (unsigned int) ((centers.get(n) - center).magnitudeSquared() <= reach*reach) << n;
+    }
+    return mask;
+}
+
+template<unsigned int N>
+inline unsigned int BatchMath::overlapCastBlock(Vector3 origin, Vector3 direction, real radius, real maxDistance, const Vec3xN<N>& centers, const real* radii, real* distances) {
+    unsigned int mask = 0, n = 0;
+#if defined(__SSE2__)
+    __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+    __m128 r = _mm_set1_ps(radius), zero = _mm_setzero_ps(), furthest = _mm_set1_ps(maxDistance);
+    for (; n + 4 <= N; n += 4) {
+        __m128 cx = _mm_load_ps(centers.x + n), cy = _mm_load_ps(centers.y + n), cz = _mm_load_ps(centers.z + n);
+        // Find the point of the cast's path closest to each center
+        __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(cx, ox), dx), _mm_mul_ps(_mm_sub_ps(cy, oy), dy)), _mm_mul_ps(_mm_sub_ps(cz, oz), dz));
+        along = _mm_max_ps(zero, _mm_min_ps(furthest, along));
+        _mm_storeu_ps(distances + n, along);
+        __m128 px = _mm_sub_ps(_mm_add_ps(ox, _mm_mul_ps(dx, along)), cx);
+        __m128 py = _mm_sub_ps(_mm_add_ps(oy, _mm_mul_ps(dy, along)), cy);
+        __m128 pz = _mm_sub_ps(_mm_add_ps(oz, _mm_mul_ps(dz, along)), cz);
+        __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz));
+        __m128 reach = _mm_add_ps(r, _mm_loadu_ps(radii + n));
+        mask |= (unsigned int) _mm_movemask_ps(_mm_cmple_ps(distanceSquared, _mm_mul_ps(reach, reach))) << n;
+    }
+#endif
+    for (; n < N; n++) {
+        Vector3 center = centers.get(n);
+        real along = std::max((real)0, std::min(maxDistance, (center - origin).dot(direction)));
+        real reach = radius + radii[n];
+        distances[n] = along;
+        mask |= (unsigned int) ((origin + direction * along - center).magnitudeSquared() <= reach*reach) << n;
+    }
+    return mask;
+}
+
+#endif //PHYSICSENGINE_BATCHMATH_H
@@ -108,10 +108,8 @@ Matrix4& Matrix4::scale(real scaleX, real scaleY, real scaleZ) {
 }
 Matrix4& Matrix4::scale(real scalar) {return scale(scalar,scalar,scalar);}
 
-GLfloat* Matrix4::toGLFloatArray() const {
-    GLfloat* result = new GLfloat[16];
-    for (int i = 0; i < 16; i++) {result[i] = (GLfloat) data[i];}
-    return result;
+void Matrix4::writeGLFloatArray(GLfloat* arr) const {
+    for (int i = 0; i < 16; i++) {arr[i] = (GLfloat) data[i];}
 }
 
 Matrix4 Matrix4::viewMatrix(Vector3 viewPos, real viewYaw, real viewPitch, real viewRoll) {
@@ -48,7 +48,10 @@ public:
     Matrix4& scale(real scaleX, real scaleY, real scaleZ);
     Matrix4& scale(real scalar);
 
-    GLfloat* toGLFloatArray() const;
+    /*
+     * Writes the 16 entries, row by row, into a caller-provided array
+     */
+    void writeGLFloatArray(GLfloat* arr) const;
 
     static Matrix4 viewMatrix(Vector3 viewPos, real viewYaw, real viewPitch, real viewRoll);
     static Matrix4 perspectiveProjectionMatrix(real fov, real nearClipping, real farClipping, real aspectRatio);
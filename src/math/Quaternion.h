@@ -45,5 +45,59 @@ struct Quaternion {
 
 std::ostream& operator<<(std::ostream &out, const Quaternion &q);
 
+/*
+ * The arithmetic is defined here so it can be inlined
+ * into other translation units.
+ */
+inline Quaternion::Quaternion() : Quaternion(1,0,0,0){}
+
+inline Quaternion::Quaternion(real r, real i, real j, real k) : r(r), i(i), j(j), k(k) {}
+
+inline Quaternion Quaternion::operator-() const {
+    return Quaternion();
+}
+
+inline Quaternion Quaternion::operator+(Quaternion &other) const { return {r+other.r,i+other.i,j+other.j,k+other.k}; }
+inline Quaternion& Quaternion::operator+=(Quaternion &other) { r += other.r; i += other.i; j += other.j; k += other.k; return *this; }
+
+inline Quaternion Quaternion::operator*(real other) const { return {r*other, i*other, j*other, k*other}; }
+
+inline Quaternion &Quaternion::operator*=(real other) { r *= other; i *= other; j *= other; k *= other; return *this; }
+
+inline Quaternion Quaternion::operator*(Quaternion &other) const {
+    return {
+        r * other.r - i * other.i - j * other.j - k * other.k,
+        r * other.i + i * other.r + j * other.k - k * other.j,
+        r * other.j + j * other.r + k * other.i - i * other.k,
+        r * other.k + k * other.r + i * other.j - j * other.i
+    };
+}
+
+inline Quaternion& Quaternion::operator*=(Quaternion &other) {
+    r = r * other.r - i * other.i - j * other.j - k * other.k;
+    i = r * other.i + i * other.r + j * other.k - k * other.j;
+    j = r * other.j + j * other.r + k * other.i - i * other.k;
+    k = r * other.k + k * other.r + i * other.j - j * other.i;
+    return *this;
+}
+
+inline void Quaternion::rotateByVector(Vector3 vector) {
+    Quaternion other {0,vector.x,vector.y,vector.z};
+    operator*=(other);
+}
+
+inline void Quaternion::addScaledVector(Vector3 vector) {
+    Quaternion q {0,vector.x,vector.y,vector.z};
+    q = (q * (*this)) * 0.5;
+    operator+=(q);
+}
+
+inline real Quaternion::magnitudeSquared() const { return r*r + i*i + j*j + k*k; }
+inline real Quaternion::magnitude() const { return std::sqrt(magnitudeSquared()); }
+
+inline void Quaternion::normalize() {if (!isZero()) operator*=(1/magnitude());}
+
+inline bool Quaternion::isZero() const { return !(r || i || j || k); }
+
 
 #endif //PHYSICSENGINE_QUATERNION_H
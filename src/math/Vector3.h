@@ -54,5 +54,40 @@ struct Vector3 {
 
 std::ostream& operator<<(std::ostream &out, const Vector3 &v);
 
+/*
+ * The arithmetic is defined here so it can be inlined into
+ * hot loops in other translation units (see BatchMath.h).
+ */
+inline Vector3::Vector3() : Vector3(0,0,0) {}
+inline Vector3::Vector3(real x, real y, real z) : x(x), y(y), z(z) {}
+inline Vector3::Vector3(Vector4 vec4) : Vector3(vec4.x,vec4.y,vec4.z) {}
+
+inline Vector3 Vector3::operator-() const {return {-x,-y,-z};}
+
+inline Vector3 Vector3::operator+(const Vector3& vec) const {return {x+vec.x,y+vec.y,z+vec.z};}
+inline Vector3& Vector3::operator+=(const Vector3& vec) {x += vec.x; y += vec.y; z += vec.z; return *this;}
+
+inline Vector3 Vector3::operator-(const Vector3& vec) const {return {x-vec.x,y-vec.y,z-vec.z};}
+inline Vector3& Vector3::operator-=(const Vector3& vec) {x -= vec.x; y -= vec.y; z -= vec.z; return *this;}
+
+inline Vector3 Vector3::operator*(const real& scalar) const {return {x*scalar,y*scalar,z*scalar};}
+inline Vector3& Vector3::operator*=(const real& scalar) {x *= scalar; y *= scalar; z *= scalar; return *this;}
+
+inline Vector3 Vector3::operator/(const real& scalar) const {return operator*(1/scalar);}
+inline Vector3& Vector3::operator/=(const real& scalar) {return operator*=(1/scalar);}
+
+inline real Vector3::magnitudeSquared() const {return x*x+y*y+z*z;}
+inline real Vector3::magnitude() const {return std::sqrt(magnitudeSquared());}
+
+inline Vector3 Vector3::normalized() const {return (isZero()) ? Vector3() : operator/(magnitude());}
+inline void Vector3::normalize() {if (!isZero()) operator/=(magnitude());}
+
+inline real Vector3::dot(Vector3 vec) const {return x*vec.x + y*vec.y + z*vec.z;}
+inline Vector3 Vector3::cross(Vector3 vec) const {return {y*vec.z-z*vec.y, z*vec.x-x*vec.z, x*vec.y-y*vec.x};}
+inline real Vector3::dot(Vector3 vec1, Vector3 vec2) {return vec1.dot(vec2);}
+inline Vector3 Vector3::cross(Vector3 vec1, Vector3 vec2) {return vec1.cross(vec2);}
+
+inline bool Vector3::isZero() const {return !(x || y || z);}
+
 
 #endif //PHYSICSENGINE_VECTOR3_H
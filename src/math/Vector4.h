@@ -44,4 +44,36 @@ struct Vector4 {
 
 std::ostream& operator<<(std::ostream &out, const Vector4 &v);
 
+/*
+ * The arithmetic is defined here so it can be inlined
+ * into other translation units.
+ */
+inline Vector4::Vector4() : Vector4(0,0,0,0) {}
+inline Vector4::Vector4(real x, real y, real z, real w) : x(x), y(y), z(z), w(w) {}
+
+inline Vector4 Vector4::operator-() const {return {-x,-y,-z,-w};}
+
+inline Vector4 Vector4::operator+(const Vector4& vec) const {return {x+vec.x,y+vec.y,z+vec.z,w+vec.w};}
+inline Vector4& Vector4::operator+=(const Vector4& vec) {x += vec.x; y += vec.y; z += vec.z; w += vec.w; return *this;}
+
+inline Vector4 Vector4::operator-(const Vector4& vec) const {return {x-vec.x,y-vec.y,z-vec.z,w-vec.w};}
+inline Vector4& Vector4::operator-=(const Vector4& vec) {x -= vec.x; y -= vec.y; z -= vec.z; w -= vec.w; return *this;}
+
+inline Vector4 Vector4::operator*(const real& scalar) const {return {x*scalar,y*scalar,z*scalar,w*scalar};}
+inline Vector4& Vector4::operator*=(const real& scalar) {x *= scalar; y *= scalar; z *= scalar; w *= scalar; return *this;}
+
+inline Vector4 Vector4::operator/(const real& scalar) const {return operator*(1/scalar);}
+inline Vector4& Vector4::operator/=(const real& scalar) {return operator*=(1/scalar);}
+
+inline real Vector4::magnitudeSquared() const {return x*x+y*y+z*z+w*w;}
+inline real Vector4::magnitude() const {return std::sqrt(magnitudeSquared());}
+
+inline Vector4 Vector4::normalized() const {return (isZero()) ? Vector4() : operator/(magnitude());}
+inline void Vector4::normalize() {if (!isZero()) operator/=(magnitude());}
+
+inline real Vector4::dot(Vector4 vec) const {return x*vec.x + y*vec.y + z*vec.z + w*vec.w;}
+inline real Vector4::dot(Vector4 vec1, Vector4 vec2) {return vec1.dot(vec2);}
+
+inline bool Vector4::isZero() const {return !(x || y || z || w);}
+
 #endif //PHYSICSENGINE_VECTOR4_H
@@ -1,202 +1,394 @@
 #include "BVHTree.h"
 #include "RigidBody.h"
 
-bool BVHTree::BVHNode::isLeaf() const {
+#include <algorithm>
+
+template<typename Volume>
+bool BVHTree<Volume>::BVHNode::isLeaf() const {
     return body != nullptr;
 }
 
-BVHTree::BVHNode::BVHNode(BVHTree::BVHNode *parent, BoundingSphere volume, RigidBody* body) : parent(parent), volume(volume), body(body), children{nullptr, nullptr} {}
+template<typename Volume>
+BVHTree<Volume>::BVHNode::BVHNode(const Broadphase* tree, BVHNode *parent, Volume volume, RigidBody* body) : BVHTreeNode(tree), children{nullptr, nullptr}, parent(parent), volume(volume), body(body) {
+    if (body) { filter = body->getCollisionFilter(); }
+}
 
-unsigned int BVHTree::getPotentialContacts(const BVHTree::BVHNode *node, PotentialContact *contacts, unsigned int limit) const {
-    if (limit == 0 || node->isLeaf()) {return 0;}
+template<typename Volume>
+void BVHTree<Volume>::getPotentialContacts(const BVHNode *node, std::vector<PotentialContact>& contacts) const {
+    if (node->isLeaf()) {return;}
 
-    unsigned int count = getPotentialContactsBetween(node->children[0], node->children[1], contacts, limit);
+    // Skip subtrees where no body collides with any other
+    if (!node->filter.collidesWith(node->filter)) {return;}
 
-    if (count < limit) {
-        count += getPotentialContacts(node->children[0], contacts + count, limit - count);
-        if (count < limit) {
-            count += getPotentialContacts(node->children[1], contacts + count, limit - count);
-        }
-    }
-    return count;
+    getPotentialContactsBetween(node->children[0], node->children[1], contacts);
+    getPotentialContacts(node->children[0], contacts);
+    getPotentialContacts(node->children[1], contacts);
 }
 
-bool BVHTree::overlaps(const BVHTree::BVHNode *node1, const BVHTree::BVHNode *node2) const {
+template<typename Volume>
+bool BVHTree<Volume>::overlaps(const BVHNode *node1, const BVHNode *node2) const {
     return node1->volume.overlaps(&node2->volume);
 }
 
-unsigned int BVHTree::getPotentialContactsBetween(const BVHTree::BVHNode *node1, const BVHTree::BVHNode *node2, PotentialContact *contacts, unsigned int limit) const {
-    if (limit == 0 || !overlaps(node1, node2)) {return 0;}
+template<typename Volume>
+void BVHTree<Volume>::getPotentialContactsBetween(const BVHNode *node1, const BVHNode *node2, std::vector<PotentialContact>& contacts) const {
+    if (!node1->filter.collidesWith(node2->filter) || !overlaps(node1, node2)) {return;}
     // If we've reached 2 leaf nodes that overlap, they might be in contact
     if (node1->isLeaf() && node2->isLeaf()) {
-        contacts[0].bodies[0] = node1->body;
-        contacts[0].bodies[1] = node2->body;
-        return 1;
+        if (!node1->body->canCollideWith(node2->body)) {return;}
+        contacts.push_back({{node1->body, node2->body}});
+        return;
     }
 
     // Pick one node to descend into: either the non-leaf, or
     // the larger one if they're both branches
-    bool descendIntoFirst = node2->isLeaf() || (!node1->isLeaf() && node1->volume.radius >= node2->volume.radius);
+    bool descendIntoFirst = node2->isLeaf() || (!node1->isLeaf() && node1->volume.getSize() >= node2->volume.getSize());
     const BVHNode* splitNode = descendIntoFirst ? node1 : node2;
     const BVHNode* otherNode = descendIntoFirst ? node2 : node1;
 
-    unsigned int count = getPotentialContactsBetween(splitNode->children[0], otherNode, contacts, limit);
-    // Check if there's room for the other side
-    if (limit > count) {
-        return count + getPotentialContactsBetween(splitNode->children[1], otherNode, contacts + count, limit - count);
-    } else {
-        return count;
+    getPotentialContactsBetween(splitNode->children[0], otherNode, contacts);
+    getPotentialContactsBetween(splitNode->children[1], otherNode, contacts);
+}
+
+template<typename Volume>
+void BVHTree<Volume>::splitPairTasks(unsigned int count) const {
+    tasks.clear();
+    tasks.push_back({root, nullptr});
+
+    bool split = true;
+    while (split && tasks.size() < count) {
+        split = false;
+        nextTasks.clear();
+        for (const PairTask& task : tasks) {
+            const BVHNode* node1 = task.node1;
+            const BVHNode* node2 = task.node2;
+            if (!node2) {
+                if (node1->isLeaf() || !node1->filter.collidesWith(node1->filter)) { continue; }
+                nextTasks.push_back({node1->children[0], nullptr});
+                nextTasks.push_back({node1->children[1], nullptr});
+                nextTasks.push_back({node1->children[0], node1->children[1]});
+                split = true;
+            } else {
+                if (!node1->filter.collidesWith(node2->filter) || !overlaps(node1, node2)) { continue; }
+                if (node1->isLeaf() && node2->isLeaf()) {
+                    nextTasks.push_back(task);
+                    continue;
+                }
+                // Split the same node getPotentialContactsBetween would descend into
+                bool descendIntoFirst = node2->isLeaf() || (!node1->isLeaf() && node1->volume.getSize() >= node2->volume.getSize());
+                const BVHNode* splitNode = descendIntoFirst ? node1 : node2;
+                const BVHNode* otherNode = descendIntoFirst ? node2 : node1;
+                nextTasks.push_back({splitNode->children[0], otherNode});
+                nextTasks.push_back({splitNode->children[1], otherNode});
+                split = true;
+            }
+        }
+        tasks.swap(nextTasks);
     }
+}
 
+template<typename Volume>
+Volume BVHTree<Volume>::getFatVolume(const RigidBody *body) const {
+    Volume volume = Volume::around(body);
+    volume.expand(margin);
+    return volume;
 }
 
-void BVHTree::insert(BVHTree::BVHNode *node, RigidBody *body) {
-    BoundingSphere newVolume = body->getBoundingSphere();
-    // If node is a leaf, create 2 children and put the body in one
-    if (node->isLeaf()) {
-        // Push current node to first child
-        node->children[0] = new BVHNode(node, node->volume, node->body);
-        // Create new child for new body
-        node->children[1] = new BVHNode(node, newVolume, body);
-        // Set current node to non-leaf
-        node->body = nullptr;
-
-        recalculateBoundingVolume(node);
-    } else {
-        // Otherwise, choose the child node that grows the least
-        if (node->children[0]->volume.getGrowth(newVolume) < node->children[1]->volume.getGrowth(newVolume)) {
-            insert(node->children[0], body);
-        } else {
-            insert(node->children[1], body);
+template<typename Volume>
+typename BVHTree<Volume>::BVHNode* BVHTree<Volume>::getLeaf(const RigidBody *body) const {
+    BVHTreeNode* leaf = body->broadphaseNode;
+    return leaf && leaf->tree == this ? static_cast<BVHNode*>(leaf) : nullptr;
+}
+
+template<typename Volume>
+void BVHTree<Volume>::insertLeaf(BVHNode *leaf) {
+    if (!root) {
+        root = leaf;
+        leaf->parent = nullptr;
+        return;
+    }
+
+    // Descend to the node that is cheapest to pair the leaf with
+    BVHNode* node = root;
+    while (!node->isLeaf()) {
+        real combinedSize = Volume(node->volume, leaf->volume).getSize();
+
+        // Pairing with this node creates a new parent of the combined area, and going
+        // further down still grows this node by at least as much
+        real pairCost = 2 * combinedSize;
+        real inheritedCost = 2 * (combinedSize - node->volume.getSize());
+
+        // Descending into a leaf means pairing with it; otherwise the child just grows
+        real childCosts[2];
+        for (int i = 0; i < 2; i++) {
+            BVHNode* child = node->children[i];
+            childCosts[i] = inheritedCost + (child->isLeaf() ? Volume(child->volume, leaf->volume).getSize() : child->volume.getGrowth(leaf->volume));
         }
+
+        if (pairCost < childCosts[0] && pairCost < childCosts[1]) { break; }
+        node = node->children[childCosts[0] < childCosts[1] ? 0 : 1];
     }
-}
 
-void BVHTree::recalculateBoundingVolume(BVHTree::BVHNode *node) {
-    node->volume = BoundingSphere(node->children[0]->volume, node->children[1]->volume);
-    if (node->parent) {
-        recalculateBoundingVolume(node->parent);
+    // Replace the node with a new parent holding both it and the leaf
+    BVHNode* oldParent = node->parent;
+    BVHNode* newParent = new BVHNode(this, oldParent, Volume(node->volume, leaf->volume), nullptr);
+    newParent->filter = node->filter;
+    newParent->filter |= leaf->filter;
+    newParent->children[0] = node;
+    newParent->children[1] = leaf;
+    node->parent = newParent;
+    leaf->parent = newParent;
+
+    if (oldParent) {
+        oldParent->children[oldParent->children[0] == node ? 0 : 1] = newParent;
+        refitUpwards(oldParent);
+    } else {
+        root = newParent;
     }
 }
 
-void BVHTree::deleteNode(BVHNode *node) {
-    if (node->parent) {
-        BVHNode* sibling = node->parent->children[0] == node ? node->parent->children[1] : node->parent->children[0];
+template<typename Volume>
+void BVHTree<Volume>::removeLeaf(BVHNode *leaf) {
+    if (leaf == root) {
+        root = nullptr;
+        return;
+    }
 
-        // Replace parent with sibling
-        node->parent->volume = sibling->volume;
-        node->parent->body = sibling->body;
-        node->parent->children[0] = sibling->children[0];
-        node->parent->children[1] = sibling->children[1];
-        delete sibling;
+    BVHNode* parent = leaf->parent;
+    BVHNode* grandparent = parent->parent;
+    BVHNode* sibling = parent->children[0] == leaf ? parent->children[1] : parent->children[0];
 
-        recalculateBoundingVolume(node->parent->parent);
+    // Replace the parent with the sibling
+    sibling->parent = grandparent;
+    if (grandparent) {
+        grandparent->children[grandparent->children[0] == parent ? 0 : 1] = sibling;
+        refitUpwards(grandparent);
+    } else {
+        root = sibling;
     }
 
-    // Delete the children by first removing their parent to prevent repetition
-    if (node->children[0]) {
-        node->children[0]->parent = nullptr;
-        deleteNode(node->children[0]);
+    delete parent;
+    leaf->parent = nullptr;
+}
+
+template<typename Volume>
+void BVHTree<Volume>::refitUpwards(BVHNode *node) {
+    while (node) {
+        rotate(node);
+        node->volume = Volume(node->children[0]->volume, node->children[1]->volume);
+        node->filter = node->children[0]->filter;
+        node->filter |= node->children[1]->filter;
+        node = node->parent;
     }
-    if (node->children[1]) {
-        node->children[1]->parent = nullptr;
-        deleteNode(node->children[1]);
+}
+
+template<typename Volume>
+bool BVHTree<Volume>::rotate(BVHNode *node) {
+    real bestReduction = 0;
+    int bestSide = -1, bestGrandchild = -1;
+
+    for (int side = 0; side < 2; side++) {
+        BVHNode* child = node->children[side];
+        BVHNode* other = node->children[1 - side];
+        if (other->isLeaf()) { continue; }
+
+        // Swapping child with one of other's children leaves other holding child
+        // and the remaining grandchild; node's own volume doesn't change
+        for (int g = 0; g < 2; g++) {
+            real newSize = Volume(child->volume, other->children[1 - g]->volume).getSize();
+            real reduction = other->volume.getSize() - newSize;
+            if (reduction > bestReduction) {
+                bestReduction = reduction;
+                bestSide = side;
+                bestGrandchild = g;
+            }
+        }
     }
 
-    delete node;
+    if (bestSide < 0) { return false; }
 
-}
+    BVHNode* child = node->children[bestSide];
+    BVHNode* other = node->children[1 - bestSide];
+    BVHNode* grandchild = other->children[bestGrandchild];
 
-BVHTree::BVHTree() : root(nullptr) {}
+    node->children[bestSide] = grandchild;
+    grandchild->parent = node;
+    other->children[bestGrandchild] = child;
+    child->parent = other;
+    other->volume = Volume(other->children[0]->volume, other->children[1]->volume);
+    other->filter = other->children[0]->filter;
+    other->filter |= other->children[1]->filter;
 
-BVHTree::~BVHTree() {
-    if (root) {
-        deleteNode(root);
+    return true;
+}
+
+template<typename Volume>
+void BVHTree<Volume>::refit(BVHNode *node) {
+    if (node->isLeaf()) {
+        node->volume = getFatVolume(node->body);
+        node->filter = node->body->getCollisionFilter();
+        return;
     }
+    refit(node->children[0]);
+    refit(node->children[1]);
+    node->volume = Volume(node->children[0]->volume, node->children[1]->volume);
+    node->filter = node->children[0]->filter;
+    node->filter |= node->children[1]->filter;
 }
 
-void BVHTree::insert(RigidBody *body) {
-    if (!root) {
-        root = new BVHNode(nullptr, body->getBoundingSphere(), body);
+template<typename Volume>
+void BVHTree<Volume>::deleteSubtree(BVHNode *node) {
+    if (node->isLeaf()) {
+        node->body->broadphaseNode = nullptr;
     } else {
-        insert(root, body);
+        deleteSubtree(node->children[0]);
+        deleteSubtree(node->children[1]);
     }
+    delete node;
 }
 
-bool BVHTree::remove(RigidBody *body) {
-    BVHNode* node = findRigidBody(root, body);
-    if (node) { deleteNode(node); return true; }
-    return false;
+template<typename Volume>
+BVHTree<Volume>::BVHTree(real margin, ThreadPool& pool) : root(nullptr), bodyCount(0), margin(margin), pool(pool) {}
+
+template<typename Volume>
+BVHTree<Volume>::~BVHTree() {
+    if (root) {
+        deleteSubtree(root);
+    }
 }
 
-BVHTree::BVHNode *BVHTree::findRigidBody(BVHTree::BVHNode *node, RigidBody *body) const {
-    if (node->body == body) {return node;}
+template<typename Volume>
+void BVHTree<Volume>::insert(RigidBody *body) {
+    BVHNode* leaf = new BVHNode(this, nullptr, getFatVolume(body), body);
+    body->broadphaseNode = leaf;
+    insertLeaf(leaf);
+    bodyCount++;
+}
 
-    BVHNode* result;
-    if (node->children[0] && (result = findRigidBody(node->children[0], body))) {return result;}
-    if (node->children[1] && (result = findRigidBody(node->children[1], body))) {return result;}
+template<typename Volume>
+bool BVHTree<Volume>::remove(RigidBody *body) {
+    BVHNode* leaf = getLeaf(body);
+    if (!leaf) { return false; }
 
-    return nullptr;
+    removeLeaf(leaf);
+    body->broadphaseNode = nullptr;
+    delete leaf;
+    bodyCount--;
+    return true;
 }
 
-unsigned int BVHTree::getPotentialContacts(PotentialContact *contacts, unsigned int limit) const {
-    if (!root) { return 0; }
-    return getPotentialContacts(root, contacts, limit);
+template<typename Volume>
+bool BVHTree<Volume>::update(RigidBody *body) {
+    BVHNode* leaf = getLeaf(body);
+    if (!leaf || leaf->volume.contains(Volume::around(body))) { return false; }
+
+    removeLeaf(leaf);
+    leaf->volume = getFatVolume(body);
+    insertLeaf(leaf);
+    return true;
 }
 
-void BVHTree::print(BVHNode* node, unsigned int level) const {
-    for (int i = 0; i < level; i++) {
-        std::cout << "| ";
+template<typename Volume>
+void BVHTree<Volume>::findEscapedLeaves(BVHNode *node) {
+    if (!node->isLeaf()) {
+        findEscapedLeaves(node->children[0]);
+        findEscapedLeaves(node->children[1]);
+        node->filter = node->children[0]->filter;
+        node->filter |= node->children[1]->filter;
+        return;
     }
-    if (node->body) {
-        std::cout << *node->body << std::endl;
-    } else {
-        std::cout << "BoundingSphere(r=" << node->volume.radius << ")\n";
-        print(node->children[0], level+1);
-        print(node->children[1], level+1);
+
+    node->filter = node->body->getCollisionFilter();
+    if (!node->volume.contains(Volume::around(node->body))) {
+        escapedLeaves.push_back(node);
     }
 }
 
-void BVHTree::print() const {
-    print(root, 0);
+template<typename Volume>
+void BVHTree<Volume>::update() {
+    if (!root) { return; }
+
+    // Find the leaves first, since reinserting them reshapes the tree
+    escapedLeaves.clear();
+    findEscapedLeaves(root);
+    for (BVHNode* leaf : escapedLeaves) {
+        removeLeaf(leaf);
+        leaf->volume = getFatVolume(leaf->body);
+        insertLeaf(leaf);
+    }
 }
 
-bool BoundingSphere::overlaps(const BoundingSphere* other) const {
-    return (other->center-center).magnitudeSquared() <= (radius+other->radius)*(radius+other->radius);
+template<typename Volume>
+void BVHTree<Volume>::refit() {
+    if (root) { refit(root); }
 }
 
-real BoundingSphere::getSize() const {
-    return 4*M_PI/3 * radius*radius*radius;
-}
+template<typename Volume>
+unsigned int BVHTree<Volume>::getPotentialContacts(std::vector<PotentialContact>& contacts) const {
+    if (!root) { return 0; }
+    size_t start = contacts.size();
 
-BoundingSphere::BoundingSphere(Vector3 center, real radius) : center(center), radius(radius) {}
+    // Only split the work up when there's enough of it to cover the overhead
+    unsigned int threadCount = std::min(pool.getThreadCount(), bodyCount / 256);
+    if (threadCount <= 1) {
+        getPotentialContacts(root, contacts);
+        return contacts.size() - start;
+    }
 
-BoundingSphere::BoundingSphere(BoundingSphere &b1, BoundingSphere &b2) {
-    Vector3 offset = b2.center - b1.center;
-    real distanceSquared = offset.magnitudeSquared();
-    real radiusDiff = b2.radius - b1.radius;
+    // A few tasks per thread, so threads that finish early can take more
+    splitPairTasks(threadCount * 4);
 
-    // Check if one sphere encompasses the other
-    if (radiusDiff*radiusDiff >= distanceSquared) {
-        if (b1.radius > b2.radius) {
-            center = b1.center;
-            radius = b1.radius;
-        } else {
-            center = b2.center;
-            radius = b2.radius;
+    if (found.size() < tasks.size()) { found.resize(tasks.size()); }
+    for (unsigned int i = 0; i < tasks.size(); i++) { found[i].clear(); }
+    pool.parallelFor(tasks.size(), 1, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            if (tasks[i].node2) { getPotentialContactsBetween(tasks[i].node1, tasks[i].node2, found[i]); }
+            else { getPotentialContacts(tasks[i].node1, found[i]); }
         }
-    } else {
-        real distance = sqrt(distanceSquared);
-        radius = (real) 0.5 * (distance + b1.radius + b2.radius);
+    });
+
+    for (unsigned int i = 0; i < tasks.size(); i++) {
+        contacts.insert(contacts.end(), found[i].begin(), found[i].end());
+    }
+    return contacts.size() - start;
+}
+
+template<typename Volume>
+real BVHTree<Volume>::queryCast(const BVHNode *node, const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, const std::function<real(RigidBody*)> &visit) const {
+    if (!node->volume.overlapsCast(origin, direction, radius, maxDistance)) { return maxDistance; }
+    if (node->isLeaf()) { return visit(node->body); }
+
+    // Look along the cast in order, so hits found early rule out more of the tree
+    int first = (node->children[0]->volume.getCenter() - node->children[1]->volume.getCenter()).dot(direction) <= 0 ? 0 : 1;
+    maxDistance = queryCast(node->children[first], origin, direction, radius, maxDistance, visit);
+    return queryCast(node->children[1 - first], origin, direction, radius, maxDistance, visit);
+}
+
+template<typename Volume>
+void BVHTree<Volume>::queryCast(const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, const std::function<real(RigidBody*)> &visit) const {
+    if (root) { queryCast(root, origin, direction, radius, maxDistance, visit); }
+}
 
-        // The new center is interpolated between the two centers based on the radii
-        center = b1.center + (distance > 0 ? offset * ((radius - b1.radius) / distance) : Vector3());
+template<typename Volume>
+void BVHTree<Volume>::print(BVHNode* node, unsigned int level) const {
+    for (int i = 0; i < level; i++) {
+        std::cout << "| ";
+    }
+    if (node->body) {
+        std::cout << *node->body << std::endl;
+    } else {
+        std::cout << "Branch(size=" << node->volume.getSize() << ")\n";
+        print(node->children[0], level+1);
+        print(node->children[1], level+1);
     }
 }
 
-real BoundingSphere::getGrowth(BoundingSphere &newSphere) const {
-    BoundingSphere thisSphere = *this;
-    return BoundingSphere(thisSphere, newSphere).getSize() - getSize();
+template<typename Volume>
+void BVHTree<Volume>::print() const {
+    print(root, 0);
 }
 
-BoundingSphere::BoundingSphere() {}
+template class BVHTree<BoundingSphere>;
+template class BVHTree<BoundingBox>;
+template class BVHTree<BoundingKDOP<14>>;
+template class BVHTree<BoundingKDOP<26>>;
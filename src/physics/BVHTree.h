@@ -1,129 +1,248 @@
 #ifndef PHYSICSENGINE_BVHTREE_H
 #define PHYSICSENGINE_BVHTREE_H
+#include <vector>
 #include "../math/Vector3.h"
+#include "Broadphase.h"
+#include "BoundingVolume.h"
+#include "ThreadPool.h"
 
-// Avoid circular dependency
-class RigidBody;
+/*
+ * The part of a BVHTree node that doesn't depend on its volume. A
+ * RigidBody holds its leaf through this, whichever kind of tree it's in.
+ */
+struct BVHTreeNode {
+    /*
+     * Holds the tree the node belongs to.
+     */
+    const Broadphase* tree;
+
+    explicit BVHTreeNode(const Broadphase* tree) : tree(tree) {}
+};
 
 /*
- * A spherical volume meant to completely encompass a RigidBody
+ * A dynamic "bounding volume hierarchy" tree structure that performs
+ * broad-phase collision checks between bounding volumes of the given
+ * type: a BoundingSphere, BoundingBox or BoundingKDOP (see
+ * BoundingVolume.h). Spheres are the cheapest to test and update, but
+ * boxes and k-DOPs fit long or flat bodies far more tightly, so they
+ * report fewer pairs that don't touch.
+ *
+ * New leaves go where they add the least surface area to the tree,
+ * which keeps the volumes that are tested most often small.
+ *
+ * Leaves hold "fat" volumes, enlarged by a margin, so a body that
+ * moves a little stays inside its leaf and costs nothing to update.
+ * Only bodies that escape their leaf are removed and reinserted, and
+ * the tree is refit and locally rotated on the way back up to keep
+ * its quality from depending on the order of insertion.
+ *
+ * Each RigidBody holds a handle to its leaf, so it can only be in
+ * one BVHTree at a time.
  */
-struct BoundingSphere {
-    Vector3 center;
-    real radius;
+template<typename Volume = BoundingSphere>
+class BVHTree : public Broadphase {
+public:
+    struct BVHNode;
 
-    BoundingSphere();
-    BoundingSphere(Vector3 center, real radius);
+private:
 
     /*
-     * Creats a BoundingSphere that fully encompasses two others.
+     * Returns whether two nodes' bounding volumes overlap.
      */
-    BoundingSphere(BoundingSphere &b1, BoundingSphere &b2);
-
-    bool overlaps(const BoundingSphere* other) const;
-    real getSize() const;
+    bool overlaps(const BVHNode* node1, const BVHNode* node2) const;
 
-    real getGrowth(BoundingSphere &newSphere) const;
-};
+    /*
+     * A piece of the search for potential contacts that doesn't depend
+     * on any other: either the pairs within node1, if node2 is null,
+     * or the pairs between node1 and node2.
+     */
+    struct PairTask {
+        const BVHNode* node1;
+        const BVHNode* node2;
+    };
 
-struct PotentialContact {
     /*
-     * Holds the bodies that might be in contact.
+     * Splits the search for potential contacts into at least count tasks,
+     * where the tree is big enough, by stepping down from the root a
+     * level at a time, and leaves them in tasks. Tasks that can't find
+     * any pairs are dropped.
      */
-    RigidBody* bodies[2];
-};
+    void splitPairTasks(unsigned int count) const;
 
-/*
- * A "bounding volume hierarchy" tree structure that performs
- * broad-phase collision checks between BoundingSpheres
- */
-class BVHTree {
-private:
+    /*
+     * Hold the pair tasks, the tasks being split into, and the pairs
+     * each task finds. They are only used inside getPotentialContacts,
+     * and are kept between calls to reuse their memory.
+     */
+    mutable std::vector<PairTask> tasks, nextTasks;
+    mutable std::vector<std::vector<PotentialContact>> found;
 
-    struct BVHNode {
-        /*
-         * Holds this node's child nodes
-         */
-        BVHNode* children[2];
+    /*
+     * Appends the potential contacts from node down to the vector.
+     */
+    void getPotentialContacts(const BVHNode* node, std::vector<PotentialContact>& contacts) const;
 
-        /*
-         * Holds this node's parent node
-         */
-        BVHNode* parent;
+    void getPotentialContactsBetween(const BVHNode *node1, const BVHNode *node2, std::vector<PotentialContact>& contacts) const;
 
-        /*
-         * Holds a single bounding sphere encompassing
-         * all the descendants of this node.
-         */
-        BoundingSphere volume;
+    /*
+     * Runs a cast query from node down. Returns how far along the cast
+     * to keep looking afterwards.
+     */
+    real queryCast(const BVHNode* node, const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const;
 
-        /*
-         * If this node is a leaf, holds its associated RigidBody.
-         */
-        RigidBody* body;
+    /*
+     * Returns the body's bounding volume enlarged by the margin.
+     */
+    Volume getFatVolume(const RigidBody* body) const;
 
-        BVHNode(BVHNode* parent, BoundingSphere volume, RigidBody* body);
+    /*
+     * Returns the body's leaf, or null if it isn't in this tree.
+     */
+    BVHNode* getLeaf(const RigidBody* body) const;
 
-        bool isLeaf() const;
-    };
+    /*
+     * Links a leaf into the hierarchy, next to the node where it adds the
+     * least surface area, then refits its ancestors.
+     */
+    void insertLeaf(BVHNode* leaf);
 
     /*
-     * Returns whether two nodes' bounding volumes overlap.
+     * Unlinks a leaf from the hierarchy, replacing its parent with its
+     * sibling, then refits its ancestors. The leaf itself is kept.
      */
-    bool overlaps(const BVHNode* node1, const BVHNode* node2) const;
+    void removeLeaf(BVHNode* leaf);
 
     /*
-     * Writes the potential contacts from node down into the contacts array,
-     * up to limit. Returns the number written.
+     * Walks from node up to the root, recalculating bounding volumes
+     * and rotating nodes where that makes the tree tighter.
      */
-    unsigned int getPotentialContacts(const BVHNode* node, PotentialContact* contacts, unsigned int limit) const;
+    void refitUpwards(BVHNode* node);
 
-    unsigned int getPotentialContactsBetween(const BVHNode *node1, const BVHNode *node2, PotentialContact *contacts, unsigned int limit) const;
+    /*
+     * Swaps one of node's children with a grandchild under its other child,
+     * if that shrinks the other child. Returns whether a swap happened.
+     */
+    bool rotate(BVHNode* node);
 
     /*
-     * Inserts a RigidBody into the hierarchy.
+     * Recalculates the bounding volumes from node down, taking
+     * leaf volumes from their RigidBodies' current positions.
      */
-    void insert(BVHNode* node, RigidBody* body);
+    void refit(BVHNode* node);
 
-    void recalculateBoundingVolume(BVHNode *node);
+    /*
+     * Deletes a node and all its descendants, clearing the handles
+     * of their RigidBodies.
+     */
+    void deleteSubtree(BVHNode* node);
 
     /*
-     * Deletes a node, removing it from the hierarchy (along with its children)
-     * and replacing its parent with its sibling. This also recalculates
-     * the bounding volumes of the parent nodes.
+     * Adds the leaves from node down whose bodies have left their fat
+     * volumes, and brings the filters from node down up to date.
      */
-    void deleteNode(BVHNode* node);
+    void findEscapedLeaves(BVHNode* node);
 
-    BVHNode* findRigidBody(BVHNode* node, RigidBody* body) const;
+    /*
+     * Holds the leaves found by findEscapedLeaves, kept between updates to reuse its memory.
+     */
+    std::vector<BVHNode*> escapedLeaves;
 
     void print(BVHNode* node, unsigned int level) const;
 
     BVHNode* root;
 
+    unsigned int bodyCount;
+
+    /*
+     * Holds how much leaf volumes are enlarged past their bodies.
+     */
+    real margin;
+
+    ThreadPool& pool;
+
 public:
-    BVHTree();
+    explicit BVHTree(real margin = 0.1, ThreadPool& pool = ThreadPool::shared());
 
-    ~BVHTree();
+    ~BVHTree() override;
 
     /*
      * Inserts a RigidBody into the hierarchy.
      */
-    void insert(RigidBody* body);
+    void insert(RigidBody* body) override;
 
     /*
      * Deletes a RigidBody from the hierarchy. Returns whether the RigidBody was found.
      */
-    bool remove(RigidBody* body);
+    bool remove(RigidBody* body) override;
 
     /*
-     * Writes the potential contacts from the hierarchy into an array
-     * and returns the number written, up to limit.
+     * Moves a RigidBody's leaf to match its current position. Does nothing
+     * if it is still inside its fat volume; otherwise it is reinserted.
+     * Returns whether the tree changed.
      */
-    unsigned int getPotentialContacts(PotentialContact* contacts, unsigned int limit) const;
+    bool update(RigidBody* body);
+
+    /*
+     * Reinserts every RigidBody that has left its fat volume.
+     */
+    void update() override;
+
+    /*
+     * Updates every bounding volume in the hierarchy to match where
+     * its RigidBodies have moved. The shape of the tree is kept.
+     */
+    void refit();
+
+    using Broadphase::getPotentialContacts;
+
+    /*
+     * Appends every potential contact in the hierarchy to the vector and
+     * returns how many were added. In big trees the search is split
+     * into subtree tasks run across the thread pool, and the pairs they
+     * find are joined in a fixed order, so the result doesn't depend on
+     * timing.
+     */
+    unsigned int getPotentialContacts(std::vector<PotentialContact>& contacts) const override;
+
+    void queryCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const override;
 
     void print() const;
 
 };
 
+template<typename Volume>
+struct BVHTree<Volume>::BVHNode : BVHTreeNode {
+    /*
+     * Holds this node's child nodes
+     */
+    BVHNode* children[2];
+
+    /*
+     * Holds this node's parent node
+     */
+    BVHNode* parent;
+
+    /*
+     * Holds a single bounding volume encompassing
+     * all the descendants of this node.
+     */
+    Volume volume;
+
+    /*
+     * Holds the CollisionFilters of all the descendants of this node
+     * combined, so subtrees that can't collide are skipped.
+     */
+    CollisionFilter filter;
+
+    /*
+     * If this node is a leaf, holds its associated RigidBody.
+     */
+    RigidBody* body;
+
+    BVHNode(const Broadphase* tree, BVHNode* parent, Volume volume, RigidBody* body);
+
+    bool isLeaf() const;
+};
+
 
 #endif //PHYSICSENGINE_BVHTREE_H
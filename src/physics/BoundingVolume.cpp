@@ -0,0 +1,255 @@
+#include "BoundingVolume.h"
+#include "RigidBody.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+ * Finds how far a body reaches in either direction along each of the
+ * given unit axes. A body using continuous collision also covers its
+ * bounding sphere where it was at the start of the last step.
+ */
+static void findExtents(const RigidBody* body, const Vector3* axes, unsigned int count, real* min, real* max) {
+    const RigidBodyModel* model = body->getModel();
+    if (model->getType() == RigidBodyModel::GENERIC || model->getType() >= RigidBodyModel::BUILT_IN_TYPES) {
+        BoundingSphere sphere = body->getSweptBoundingSphere();
+        for (unsigned int i = 0; i < count; i++) {
+            real center = axes[i].dot(sphere.center);
+            min[i] = center - sphere.radius;
+            max[i] = center + sphere.radius;
+        }
+        return;
+    }
+
+    const Matrix4& transform = body->getTransformMatrix();
+    Vector3 center(transform.getColumn(3));
+    Vector3 columns[3];
+    for (int i = 0; i < 3; i++) { columns[i] = Vector3(transform.getColumn(i)); }
+    BoundingSphere previous = model->getBoundingSphere();
+    previous.center += body->getPreviousPosition();
+
+    for (unsigned int i = 0; i < count; i++) {
+        // The axis in body space, where the model's support points are
+        Vector3 local(columns[0].dot(axes[i]), columns[1].dot(axes[i]), columns[2].dot(axes[i]));
+        real offset = axes[i].dot(center);
+        min[i] = offset + local.dot(model->getSupportPoint(-local));
+        max[i] = offset + local.dot(model->getSupportPoint(local));
+
+        if (body->usesContinuousCollision()) {
+            real previousCenter = axes[i].dot(previous.center);
+            min[i] = std::min(min[i], previousCenter - previous.radius);
+            max[i] = std::max(max[i], previousCenter + previous.radius);
+        }
+    }
+}
+
+/*
+ * Returns whether a sphere cast, as in BoundingSphere::overlapsCast,
+ * touches the space between pairs of planes along the given unit axes,
+ * each moved apart by the cast's radius.
+ */
+static bool castOverlapsSlabs(const Vector3* axes, const real* min, const real* max, unsigned int count, const Vector3& origin, const Vector3& direction, real radius, real maxDistance) {
+    real enter = 0, exit = maxDistance;
+    for (unsigned int i = 0; i < count; i++) {
+        real start = axes[i].dot(origin), speed = axes[i].dot(direction);
+        real low = min[i] - radius, high = max[i] + radius;
+        if (speed == 0) {
+            if (start < low || start > high) { return false; }
+            continue;
+        }
+        real t1 = (low - start) / speed, t2 = (high - start) / speed;
+        enter = std::max(enter, std::min(t1, t2));
+        exit = std::min(exit, std::max(t1, t2));
+        if (enter > exit) { return false; }
+    }
+    return true;
+}
+
+/*
+ * Returns the surface area of the box between the given bounds.
+ */
+static real boxArea(real x, real y, real z) {
+    return 2 * (x*y + y*z + z*x);
+}
+
+static const Vector3 BOX_AXES[3] = {Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1)};
+
+BoundingSphere::BoundingSphere() {}
+
+BoundingSphere::BoundingSphere(Vector3 center, real radius) : center(center), radius(radius) {}
+
+BoundingSphere::BoundingSphere(const BoundingSphere &b1, const BoundingSphere &b2) {
+    Vector3 offset = b2.center - b1.center;
+    real distanceSquared = offset.magnitudeSquared();
+    real radiusDiff = b2.radius - b1.radius;
+
+    // Check if one sphere encompasses the other
+    if (radiusDiff*radiusDiff >= distanceSquared) {
+        if (b1.radius > b2.radius) {
+            center = b1.center;
+            radius = b1.radius;
+        } else {
+            center = b2.center;
+            radius = b2.radius;
+        }
+    } else {
+        real distance = sqrt(distanceSquared);
+        radius = (real) 0.5 * (distance + b1.radius + b2.radius);
+
+        // The new center is interpolated between the two centers based on the radii
+        center = b1.center + (distance > 0 ? offset * ((radius - b1.radius) / distance) : Vector3());
+    }
+}
+
+BoundingSphere BoundingSphere::around(const RigidBody *body) { return body->getSweptBoundingSphere(); }
+
+void BoundingSphere::expand(real margin) { radius += margin; }
+
+bool BoundingSphere::overlapsCast(const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance) const {
+    // Find the point of the cast's path closest to the center
+    real along = std::max((real)0, std::min(maxDistance, (center - origin).dot(direction)));
+    real reach = this->radius + radius;
+    return (origin + direction * along - center).magnitudeSquared() <= reach*reach;
+}
+
+bool BoundingSphere::overlaps(const BoundingSphere* other) const {
+    return (other->center-center).magnitudeSquared() <= (radius+other->radius)*(radius+other->radius);
+}
+
+bool BoundingSphere::contains(const BoundingSphere& other) const {
+    real slack = radius - other.radius;
+    return slack >= 0 && (other.center-center).magnitudeSquared() <= slack*slack;
+}
+
+real BoundingSphere::getSize() const {
+    return 4*M_PI * radius*radius;
+}
+
+real BoundingSphere::getGrowth(const BoundingSphere &other) const {
+    return BoundingSphere(*this, other).getSize() - getSize();
+}
+
+Vector3 BoundingSphere::getCenter() const { return center; }
+
+BoundingBox::BoundingBox() {}
+
+BoundingBox::BoundingBox(Vector3 min, Vector3 max) : min(min), max(max) {}
+
+BoundingBox::BoundingBox(const BoundingBox &b1, const BoundingBox &b2)
+        : min(std::min(b1.min.x, b2.min.x), std::min(b1.min.y, b2.min.y), std::min(b1.min.z, b2.min.z)),
+          max(std::max(b1.max.x, b2.max.x), std::max(b1.max.y, b2.max.y), std::max(b1.max.z, b2.max.z)) {}
+
+BoundingBox BoundingBox::around(const RigidBody *body) {
+    real min[3], max[3];
+    findExtents(body, BOX_AXES, 3, min, max);
+    return {Vector3(min[0], min[1], min[2]), Vector3(max[0], max[1], max[2])};
+}
+
+void BoundingBox::expand(real margin) {
+    min -= Vector3(margin, margin, margin);
+    max += Vector3(margin, margin, margin);
+}
+
+bool BoundingBox::overlaps(const BoundingBox *other) const {
+    return min.x <= other->max.x && other->min.x <= max.x
+        && min.y <= other->max.y && other->min.y <= max.y
+        && min.z <= other->max.z && other->min.z <= max.z;
+}
+
+bool BoundingBox::contains(const BoundingBox &other) const {
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z
+        && other.max.x <= max.x && other.max.y <= max.y && other.max.z <= max.z;
+}
+
+real BoundingBox::getSize() const {
+    return boxArea(max.x - min.x, max.y - min.y, max.z - min.z);
+}
+
+bool BoundingBox::overlapsCast(const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance) const {
+    real mins[3] = {min.x, min.y, min.z}, maxes[3] = {max.x, max.y, max.z};
+    return castOverlapsSlabs(BOX_AXES, mins, maxes, 3, origin, direction, radius, maxDistance);
+}
+
+real BoundingBox::getGrowth(const BoundingBox &other) const {
+    return BoundingBox(*this, other).getSize() - getSize();
+}
+
+Vector3 BoundingBox::getCenter() const { return (min + max) * 0.5; }
+
+static const real BOX_DIAGONAL = 0.57735027, FACE_DIAGONAL = 0.70710678;
+
+template<unsigned int K>
+const Vector3 BoundingKDOP<K>::AXES[13] = {
+        Vector3(1, 0, 0), Vector3(0, 1, 0), Vector3(0, 0, 1),
+        Vector3(BOX_DIAGONAL, BOX_DIAGONAL, BOX_DIAGONAL), Vector3(BOX_DIAGONAL, BOX_DIAGONAL, -BOX_DIAGONAL),
+        Vector3(BOX_DIAGONAL, -BOX_DIAGONAL, BOX_DIAGONAL), Vector3(-BOX_DIAGONAL, BOX_DIAGONAL, BOX_DIAGONAL),
+        Vector3(FACE_DIAGONAL, FACE_DIAGONAL, 0), Vector3(FACE_DIAGONAL, -FACE_DIAGONAL, 0),
+        Vector3(FACE_DIAGONAL, 0, FACE_DIAGONAL), Vector3(FACE_DIAGONAL, 0, -FACE_DIAGONAL),
+        Vector3(0, FACE_DIAGONAL, FACE_DIAGONAL), Vector3(0, FACE_DIAGONAL, -FACE_DIAGONAL)
+};
+
+template<unsigned int K>
+BoundingKDOP<K>::BoundingKDOP() {}
+
+template<unsigned int K>
+BoundingKDOP<K>::BoundingKDOP(const BoundingKDOP &b1, const BoundingKDOP &b2) {
+    for (unsigned int i = 0; i < AXIS_COUNT; i++) {
+        min[i] = std::min(b1.min[i], b2.min[i]);
+        max[i] = std::max(b1.max[i], b2.max[i]);
+    }
+}
+
+template<unsigned int K>
+BoundingKDOP<K> BoundingKDOP<K>::around(const RigidBody *body) {
+    BoundingKDOP volume;
+    findExtents(body, AXES, AXIS_COUNT, volume.min, volume.max);
+    return volume;
+}
+
+template<unsigned int K>
+void BoundingKDOP<K>::expand(real margin) {
+    for (unsigned int i = 0; i < AXIS_COUNT; i++) {
+        min[i] -= margin;
+        max[i] += margin;
+    }
+}
+
+template<unsigned int K>
+bool BoundingKDOP<K>::overlaps(const BoundingKDOP *other) const {
+    for (unsigned int i = 0; i < AXIS_COUNT; i++) {
+        if (min[i] > other->max[i] || other->min[i] > max[i]) { return false; }
+    }
+    return true;
+}
+
+template<unsigned int K>
+bool BoundingKDOP<K>::contains(const BoundingKDOP &other) const {
+    for (unsigned int i = 0; i < AXIS_COUNT; i++) {
+        if (other.min[i] < min[i] || other.max[i] > max[i]) { return false; }
+    }
+    return true;
+}
+
+template<unsigned int K>
+real BoundingKDOP<K>::getSize() const {
+    return boxArea(max[0] - min[0], max[1] - min[1], max[2] - min[2]);
+}
+
+template<unsigned int K>
+bool BoundingKDOP<K>::overlapsCast(const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance) const {
+    return castOverlapsSlabs(AXES, min, max, AXIS_COUNT, origin, direction, radius, maxDistance);
+}
+
+template<unsigned int K>
+real BoundingKDOP<K>::getGrowth(const BoundingKDOP &other) const {
+    return BoundingKDOP(*this, other).getSize() - getSize();
+}
+
+template<unsigned int K>
+Vector3 BoundingKDOP<K>::getCenter() const {
+    return Vector3(min[0] + max[0], min[1] + max[1], min[2] + max[2]) * 0.5;
+}
+
+template struct BoundingKDOP<6>;
+template struct BoundingKDOP<14>;
+template struct BoundingKDOP<26>;
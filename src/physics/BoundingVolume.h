@@ -0,0 +1,165 @@
+#ifndef PHYSICSENGINE_BOUNDINGVOLUME_H
+#define PHYSICSENGINE_BOUNDINGVOLUME_H
+
+#include "../math/Vector3.h"
+
+// Avoid circular dependency
+class RigidBody;
+
+/*
+ * The bounding volumes a BVHTree or StaticBVH can be built from. Each
+ * one provides the same functions, so the trees can be templated on
+ * which to use: a constructor enclosing two others, around() to
+ * enclose a body, expand(), overlaps(), contains(), overlapsCast(),
+ * getCenter(), and getSize() and getGrowth() for the trees' costs.
+ *
+ * getSize() is the surface area, or an estimate of it, since the
+ * chance of a random ray or small body hitting a volume grows with
+ * its area. That makes the BVHTree's insertion cost and the StaticBVH's
+ * split cost surface area heuristics whichever volume is used.
+ */
+
+/*
+ * A spherical volume meant to completely encompass a RigidBody
+ */
+struct BoundingSphere {
+    Vector3 center;
+    real radius;
+
+    BoundingSphere();
+    BoundingSphere(Vector3 center, real radius);
+
+    /*
+     * Creats a BoundingSphere that fully encompasses two others.
+     */
+    BoundingSphere(const BoundingSphere &b1, const BoundingSphere &b2);
+
+    /*
+     * Returns the body's swept bounding sphere.
+     */
+    static BoundingSphere around(const RigidBody* body);
+
+    void expand(real margin);
+
+    bool overlaps(const BoundingSphere* other) const;
+
+    /*
+     * Returns whether other lies entirely inside this sphere.
+     */
+    bool contains(const BoundingSphere& other) const;
+    real getSize() const;
+
+    /*
+     * Returns whether a sphere of the given radius swept from origin
+     * along direction, which should be normalized, for up to
+     * maxDistance would touch this sphere.
+     */
+    bool overlapsCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance) const;
+
+    /*
+     * Returns how much the size would grow by enclosing another sphere.
+     */
+    real getGrowth(const BoundingSphere& other) const;
+
+    Vector3 getCenter() const;
+};
+
+/*
+ * An axis-aligned box. Much tighter than a sphere around long, thin
+ * bodies, which would otherwise overlap everything along their length.
+ */
+struct BoundingBox {
+    Vector3 min, max;
+
+    BoundingBox();
+    BoundingBox(Vector3 min, Vector3 max);
+
+    /*
+     * Creates the BoundingBox that encompasses two others.
+     */
+    BoundingBox(const BoundingBox& b1, const BoundingBox& b2);
+
+    /*
+     * Returns the smallest box around the body, from its model's support
+     * points, stretched over the last step if it uses continuous collision.
+     * Models of other types than the built-in convex ones use the box
+     * around their bounding sphere, since they may not have support points.
+     */
+    static BoundingBox around(const RigidBody* body);
+
+    void expand(real margin);
+
+    bool overlaps(const BoundingBox* other) const;
+    bool contains(const BoundingBox& other) const;
+    real getSize() const;
+
+    /*
+     * See BoundingSphere::overlapsCast. The box is grown by the radius
+     * along each axis, so casts past its edges may be reported too.
+     */
+    bool overlapsCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance) const;
+
+    real getGrowth(const BoundingBox& other) const;
+
+    Vector3 getCenter() const;
+};
+
+/*
+ * A "discrete oriented polytope" with K faces: the space between K/2
+ * pairs of parallel planes, along fixed directions shared by every
+ * k-DOP. A 6-DOP is a box, a 14-DOP also cuts off the box's corners,
+ * and a 26-DOP its edges too, so it follows rotated bodies more closely
+ * at the cost of more work per test.
+ */
+template<unsigned int K>
+struct BoundingKDOP {
+    static_assert(K == 6 || K == 14 || K == 26, "k-DOPs can have 6, 14 or 26 faces");
+
+    static const unsigned int AXIS_COUNT = K / 2;
+
+    /*
+     * Holds the unit directions of the planes: the coordinate axes,
+     * then the box's diagonals, then the diagonals of its faces.
+     */
+    static const Vector3 AXES[13];
+
+    /*
+     * Holds how far the volume reaches along each axis in either direction.
+     */
+    real min[AXIS_COUNT], max[AXIS_COUNT];
+
+    BoundingKDOP();
+
+    BoundingKDOP(const BoundingKDOP& b1, const BoundingKDOP& b2);
+
+    /*
+     * Returns the smallest k-DOP around the body, in the same way as
+     * BoundingBox::around.
+     */
+    static BoundingKDOP around(const RigidBody* body);
+
+    void expand(real margin);
+
+    bool overlaps(const BoundingKDOP* other) const;
+    bool contains(const BoundingKDOP& other) const;
+
+    /*
+     * Returns the surface area of the box formed by the first three
+     * pairs of planes. The other planes only cut pieces off that box,
+     * so this overestimates the area, but it grows and shrinks with it.
+     */
+    real getSize() const;
+
+    /*
+     * See BoundingSphere::overlapsCast. Each pair of planes is moved
+     * apart by the radius, so casts past the corners may be reported too.
+     */
+    bool overlapsCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance) const;
+
+    real getGrowth(const BoundingKDOP& other) const;
+
+    Vector3 getCenter() const;
+};
+
+
+#endif //PHYSICSENGINE_BOUNDINGVOLUME_H
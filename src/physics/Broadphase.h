@@ -0,0 +1,98 @@
+#ifndef PHYSICSENGINE_BROADPHASE_H
+#define PHYSICSENGINE_BROADPHASE_H
+
+#include <functional>
+#include <vector>
+#include "../math/Vector3.h"
+
+// Avoid circular dependency
+class RigidBody;
+
+/*
+ * Which collision groups a body belongs to and which it collides
+ * with, as bitmasks. Two bodies only collide if each is in a group
+ * the other collides with. Combining filters with |= gives one that
+ * collides with everything any of them might, so a broad phase can
+ * keep one per subtree and skip subtrees that can't collide.
+ */
+struct CollisionFilter {
+    unsigned int group;
+    unsigned int mask;
+
+    /*
+     * By default, a body is in the first group and collides with every group.
+     */
+    explicit CollisionFilter(unsigned int group = 1, unsigned int mask = ~0u) : group(group), mask(mask) {}
+
+    bool collidesWith(const CollisionFilter& other) const { return (group & other.mask) && (other.group & mask); }
+
+    CollisionFilter& operator|=(const CollisionFilter& other) { group |= other.group; mask |= other.mask; return *this; }
+};
+
+struct PotentialContact {
+    /*
+     * Holds the bodies that might be in contact.
+     */
+    RigidBody* bodies[2];
+};
+
+/*
+ * Interface for broad-phase collision detection: cheaply finding
+ * the pairs of RigidBodies whose bounding volumes overlap, so that
+ * only those need a full contact test.
+ */
+class Broadphase {
+
+public:
+    virtual ~Broadphase() = default;
+
+    /*
+     * Adds a RigidBody to the broad phase.
+     */
+    virtual void insert(RigidBody* body) = 0;
+
+    /*
+     * Removes a RigidBody from the broad phase. Returns whether the RigidBody was found.
+     */
+    virtual bool remove(RigidBody* body) = 0;
+
+    /*
+     * Brings the broad phase up to date with where its bodies have moved.
+     * Called once per step, before getPotentialContacts.
+     */
+    virtual void update() = 0;
+
+    /*
+     * Appends every potential contact to the vector, growing it as
+     * needed, and returns how many were added. Pairs that can't
+     * collide, because of their CollisionFilters or because they
+     * ignore each other, are left out.
+     */
+    virtual unsigned int getPotentialContacts(std::vector<PotentialContact>& contacts) const = 0;
+
+    /*
+     * Writes the potential contacts into an array and returns the
+     * number written, up to limit. Any pairs past the limit are lost,
+     * so prefer the version above, which finds them all.
+     */
+    unsigned int getPotentialContacts(PotentialContact* contacts, unsigned int limit) const {
+        std::vector<PotentialContact> found;
+        getPotentialContacts(found);
+        unsigned int count = found.size() < limit ? found.size() : limit;
+        for (unsigned int i = 0; i < count; i++) { contacts[i] = found[i]; }
+        return count;
+    }
+
+    /*
+     * Calls visit on each body whose bounding volume might be touched by a
+     * sphere of the given radius swept from origin along direction, which
+     * should be normalized, for up to maxDistance. visit returns how far
+     * along to keep looking, so a search for the closest hit can stop
+     * looking past the hits it has found. Doesn't change the broad phase,
+     * so queries can run on several threads at once.
+     */
+    virtual void queryCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const = 0;
+
+};
+
+#endif //PHYSICSENGINE_BROADPHASE_H
@@ -0,0 +1,871 @@
+#include "CollisionDetector.h"
+#include "RigidBody.h"
+#include "GJK.h"
+
+/*
+ * A RectangularPrismModel placed in the world
+ */
+struct OrientedBox {
+    Vector3 center;
+    Vector3 axes[3];
+    real halfSize[3];
+
+    explicit OrientedBox(const RigidBody* body) {
+        const Matrix4& transform = body->getTransformMatrix();
+        Vector3 half = static_cast<const RectangularPrismModel*>(body->getModel())->getHalfSize();
+        center = Vector3(transform.getColumn(3));
+        for (int i = 0; i < 3; i++) { axes[i] = Vector3(transform.getColumn(i)); }
+        halfSize[0] = half.x; halfSize[1] = half.y; halfSize[2] = half.z;
+    }
+
+    /*
+     * Returns half the length of the box's shadow on an axis.
+     */
+    real projectOnto(const Vector3& axis) const {
+        return halfSize[0] * real_abs(axes[0].dot(axis))
+             + halfSize[1] * real_abs(axes[1].dot(axis))
+             + halfSize[2] * real_abs(axes[2].dot(axis));
+    }
+
+    Vector3 getVertex(int i) const {
+        return center + axes[0] * (i & 1 ? halfSize[0] : -halfSize[0])
+                      + axes[1] * (i & 2 ? halfSize[1] : -halfSize[1])
+                      + axes[2] * (i & 4 ? halfSize[2] : -halfSize[2]);
+    }
+};
+
+/*
+ * A CapsuleModel placed in the world, as its core segment and radius
+ */
+struct WorldCapsule {
+    Vector3 start, end;
+    real radius;
+
+    explicit WorldCapsule(const RigidBody* body) {
+        const Matrix4& transform = body->getTransformMatrix();
+        auto model = static_cast<const CapsuleModel*>(body->getModel());
+        Vector3 center = Vector3(transform.getColumn(3));
+        Vector3 halfAxis = Vector3(transform.getColumn(1)) * model->getHalfHeight();
+        start = center - halfAxis;
+        end = center + halfAxis;
+        radius = model->getRadius();
+    }
+};
+
+/*
+ * A TriangleMeshModel placed in the world
+ */
+struct WorldMesh {
+    const TriangleMeshModel* model;
+    Vector3 position;
+    Vector3 axes[3];
+
+    explicit WorldMesh(const RigidBody* body) : model(static_cast<const TriangleMeshModel*>(body->getModel())) {
+        const Matrix4& transform = body->getTransformMatrix();
+        position = Vector3(transform.getColumn(3));
+        for (int i = 0; i < 3; i++) { axes[i] = Vector3(transform.getColumn(i)); }
+    }
+
+    void getTriangle(unsigned int index, Vector3* points) const {
+        model->getTriangle(index, points);
+        for (unsigned int i = 0; i < 3; i++) {
+            points[i] = position + axes[0] * points[i].x + axes[1] * points[i].y + axes[2] * points[i].z;
+        }
+    }
+
+    /*
+     * Calls visit with the index of every triangle near the body's bounding sphere
+     */
+    template<typename Visit>
+    void forEachTriangleNear(const RigidBody* body, Visit visit) const {
+        BoundingSphere sphere = body->getBoundingSphere();
+        Vector3 relative = sphere.center - position;
+        Vector3 center(axes[0].dot(relative), axes[1].dot(relative), axes[2].dot(relative));
+        Vector3 reach(sphere.radius, sphere.radius, sphere.radius);
+        model->forEachTriangle(center - reach, center + reach, visit);
+    }
+};
+
+/*
+ * Gathers the contacts between a body and the triangles of a mesh, so
+ * the same point found on neighbouring triangles is only kept once, and
+ * the many triangles a body can rest on still give a small manifold.
+ *
+ * A body resting on one triangle also reaches the edges of those around
+ * it, which would push it sideways as if the surface had seams. So a
+ * contact with an edge or corner is dropped when the point it touches
+ * lies in the plane of a contact with a face, which already covers it.
+ */
+struct MeshManifold {
+    static const unsigned int CAPACITY = 32;
+
+    Vector3 normals[CAPACITY], points[CAPACITY];
+    real depths[CAPACITY];
+    unsigned int featureIds[CAPACITY];
+    bool onFace[CAPACITY];
+    unsigned int count = 0;
+
+    // Points closer together than this are the same contact
+    real tolerance;
+
+    explicit MeshManifold(const RigidBody* body) {
+        tolerance = body->getBoundingSphere().radius * (real)0.01;
+    }
+
+    /*
+     * Adds a contact with a triangle, saying whether it is with the
+     * triangle's face or with one of its edges or corners.
+     */
+    void add(const Vector3& normal, const Vector3& point, real depth, unsigned int featureId, bool face) {
+        unsigned int slot = count;
+        for (unsigned int i = 0; i < count; i++) {
+            if ((points[i] - point).magnitudeSquared() <= tolerance*tolerance) { slot = i; break; }
+        }
+        // When full, a new contact can only take the shallowest one's place
+        if (slot == CAPACITY) {
+            slot = 0;
+            for (unsigned int i = 1; i < count; i++) {
+                if (depths[i] < depths[slot]) { slot = i; }
+            }
+        }
+        if (slot < count && depths[slot] >= depth) { return; }
+        if (slot == count) { count++; }
+        normals[slot] = normal; points[slot] = point; depths[slot] = depth; featureIds[slot] = featureId;
+        onFace[slot] = face;
+    }
+
+    /*
+     * Returns whether a contact is with an edge or corner that a face contact covers.
+     */
+    bool isCovered(unsigned int index) const {
+        if (onFace[index]) { return false; }
+        // The point on the triangle is half the penetration back along the normal from the contact point
+        Vector3 touched = points[index] + normals[index] * (depths[index] / 2);
+        for (unsigned int i = 0; i < count; i++) {
+            if (!onFace[i]) { continue; }
+            Vector3 onPlane = points[i] + normals[i] * (depths[i] / 2);
+            if (real_abs(normals[i].dot(touched - onPlane)) <= tolerance) { return true; }
+        }
+        return false;
+    }
+
+    /*
+     * Writes the contacts that best cover the patch, with the body first
+     */
+    unsigned int write(RigidBody* body, RigidBody* mesh, real restitution, PhysicsContact* contact, unsigned int limit) const {
+        Vector3 keptPoints[CAPACITY];
+        real keptDepths[CAPACITY];
+        unsigned int kept[CAPACITY];
+        unsigned int keptCount = 0, deepest = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            if (isCovered(i)) { continue; }
+            if (keptCount > 0 && depths[i] > keptDepths[deepest]) { deepest = keptCount; }
+            keptPoints[keptCount] = points[i];
+            keptDepths[keptCount] = depths[i];
+            kept[keptCount++] = i;
+        }
+        if (keptCount == 0) { return 0; }
+
+        unsigned int chosen[CollisionDetector::MAX_MANIFOLD_POINTS];
+        unsigned int used = std::min(CollisionDetector::reduceManifold(keptPoints, keptDepths, keptCount, normals[kept[deepest]], chosen), limit);
+        for (unsigned int i = 0; i < used; i++) {
+            unsigned int c = kept[chosen[i]];
+            contact[i].objects[0] = body;
+            contact[i].objects[1] = mesh;
+            contact[i].contactNormal = normals[c];
+            contact[i].contactPoint = points[c];
+            contact[i].penetration = depths[c];
+            contact[i].restitution = restitution;
+            contact[i].featureId = featureIds[c];
+        }
+        return used;
+    }
+};
+
+/*
+ * Gives each contact with a mesh an id from its triangle and the
+ * part of the body touching it, for which 8 means the whole body.
+ */
+static unsigned int meshFeature(unsigned int triangle, unsigned int part) {
+    return triangle * 9 + part + 1;
+}
+
+static real sphereRadius(const RigidBody* body) {
+    return static_cast<const SphereModel*>(body->getModel())->getRadius();
+}
+
+static Vector3 closestOnSegment(const Vector3& start, const Vector3& end, const Vector3& point) {
+    Vector3 direction = end - start;
+    real length = direction.magnitudeSquared();
+    if (length <= 0) { return start; }
+    real t = std::max((real)0, std::min((real)1, direction.dot(point - start) / length));
+    return start + direction * t;
+}
+
+Vector3 CollisionDetector::closestOnTriangle(const Vector3& point, const Vector3& a, const Vector3& b, const Vector3& c) {
+    // Find which of the triangle's vertex, edge or face regions the point is in
+    Vector3 ab = b - a, ac = c - a, ap = point - a;
+    real d1 = ab.dot(ap), d2 = ac.dot(ap);
+    if (d1 <= 0 && d2 <= 0) { return a; }
+
+    Vector3 bp = point - b;
+    real d3 = ab.dot(bp), d4 = ac.dot(bp);
+    if (d3 >= 0 && d4 <= d3) { return b; }
+
+    real vc = d1*d4 - d3*d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) { return a + ab * (d1 / (d1 - d3)); }
+
+    Vector3 cp = point - c;
+    real d5 = ab.dot(cp), d6 = ac.dot(cp);
+    if (d6 >= 0 && d5 <= d6) { return c; }
+
+    real vb = d5*d2 - d1*d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) { return a + ac * (d2 / (d2 - d6)); }
+
+    real va = d3*d6 - d5*d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) { return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))); }
+
+    real denominator = 1 / (va + vb + vc);
+    return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+/*
+ * Returns whether a point in the triangle's plane lies inside it
+ */
+static bool insideTriangle(const Vector3& point, const Vector3* triangle, const Vector3& normal) {
+    for (unsigned int i = 0; i < 3; i++) {
+        const Vector3 &a = triangle[i], &b = triangle[(i + 1) % 3];
+        if ((b - a).cross(point - a).dot(normal) < 0) { return false; }
+    }
+    return true;
+}
+
+/*
+ * Adds the contact between a sphere and a triangle to a manifold, if they
+ * touch. Triangles are two-sided, so the sphere is pushed out on whichever
+ * side its center is.
+ */
+static bool sphereTriangleContact(const Vector3& center, real radius, const Vector3* triangle, unsigned int featureId, MeshManifold& manifold) {
+    Vector3 closest = CollisionDetector::closestOnTriangle(center, triangle[0], triangle[1], triangle[2]);
+    Vector3 offset = center - closest;
+    real distanceSquared = offset.magnitudeSquared();
+    if (distanceSquared > radius*radius) { return false; }
+
+    // The closest point is on the face when the center is right above it
+    Vector3 faceNormal = (triangle[1] - triangle[0]).cross(triangle[2] - triangle[0]).normalized();
+    bool face = insideTriangle(center - faceNormal * faceNormal.dot(center - triangle[0]), triangle, faceNormal);
+    real distance = std::sqrt(distanceSquared);
+    Vector3 normal;
+    if (distance > 0) { normal = offset / distance; }
+    else {
+        // The center is on the triangle, so it could go either way
+        normal = faceNormal;
+        if (normal.isZero()) { return false; }
+    }
+    real penetration = radius - distance;
+    manifold.add(normal, center - normal * (radius - penetration / 2), penetration, featureId, face);
+    return true;
+}
+
+/*
+ * Returns the point of a body's model farthest along a direction, in world space
+ */
+static Vector3 worldSupportPoint(const RigidBody* body, const Vector3& direction) {
+    const Matrix4& transform = body->getTransformMatrix();
+    Vector3 axes[3];
+    for (int i = 0; i < 3; i++) { axes[i] = Vector3(transform.getColumn(i)); }
+    Vector3 point = body->getModel()->getSupportPoint(Vector3(axes[0].dot(direction), axes[1].dot(direction), axes[2].dot(direction)));
+    return Vector3(transform.getColumn(3)) + axes[0] * point.x + axes[1] * point.y + axes[2] * point.z;
+}
+
+/*
+ * Adds the contact between a body and a triangle found by GJK
+ */
+static void convexTriangleContact(const RigidBody* body, const Vector3* triangle, unsigned int featureId, MeshManifold& manifold) {
+    Vector3 normal, point;
+    real penetration;
+    if (GJK::collideTriangle(body, triangle, normal, point, penetration)) {
+        // GJK doesn't say which feature it found, so go by the normal
+        Vector3 faceNormal = (triangle[1] - triangle[0]).cross(triangle[2] - triangle[0]).normalized();
+        manifold.add(normal, point, penetration, featureId, real_abs(normal.dot(faceNormal)) > (real)0.9999);
+    }
+}
+
+/*
+ * Finds the closest points between two segments, writing them into closest1 and closest2
+ */
+static void closestBetweenSegments(const Vector3& start1, const Vector3& end1, const Vector3& start2, const Vector3& end2, Vector3& closest1, Vector3& closest2) {
+    Vector3 d1 = end1 - start1, d2 = end2 - start2, r = start1 - start2;
+    real a = d1.magnitudeSquared(), e = d2.magnitudeSquared(), f = d2.dot(r);
+    real s = 0, t = 0;
+    if (a <= 0 && e <= 0) {
+        s = t = 0;
+    } else if (a <= 0) {
+        t = std::max((real)0, std::min((real)1, f / e));
+    } else {
+        real c = d1.dot(r);
+        if (e <= 0) {
+            s = std::max((real)0, std::min((real)1, -c / a));
+        } else {
+            real b = d1.dot(d2), denominator = a*e - b*b;
+            s = denominator > 0 ? std::max((real)0, std::min((real)1, (b*f - c*e) / denominator)) : 0;
+            t = (b*s + f) / e;
+            if (t < 0) { t = 0; s = std::max((real)0, std::min((real)1, -c / a)); }
+            else if (t > 1) { t = 1; s = std::max((real)0, std::min((real)1, (b - c) / a)); }
+        }
+    }
+    closest1 = start1 + d1 * s;
+    closest2 = start2 + d2 * t;
+}
+
+static void fillContact(PhysicsContact* contact, PhysicsObject* object1, PhysicsObject* object2, Vector3 normal, Vector3 point, real penetration, real restitution, unsigned int featureId = 0) {
+    contact->objects[0] = object1;
+    contact->objects[1] = object2;
+    contact->contactNormal = normal;
+    contact->contactPoint = point;
+    contact->penetration = penetration;
+    contact->restitution = restitution;
+    contact->featureId = featureId;
+}
+
+/*
+ * Creates the contact between two spheres, if they touch
+ */
+static unsigned int spheresContact(PhysicsObject* object1, Vector3 center1, real radius1, PhysicsObject* object2, Vector3 center2, real radius2, real restitution, PhysicsContact* contact) {
+    Vector3 offset = center1 - center2;
+    real distanceSquared = offset.magnitudeSquared(), reach = radius1 + radius2;
+    if (distanceSquared > reach*reach) { return 0; }
+
+    real distance = std::sqrt(distanceSquared);
+    Vector3 normal = distance > 0 ? offset / distance : Vector3::UP;
+    real penetration = reach - distance;
+    // Put the contact halfway between the two surfaces
+    Vector3 point = center2 + normal * (radius2 - penetration / 2);
+    fillContact(contact, object1, object2, normal, point, penetration, restitution);
+    return 1;
+}
+
+/*
+ * Creates the contact between a sphere and a box, if they touch
+ */
+static unsigned int sphereBoxContact(PhysicsObject* sphere, Vector3 center, real radius, PhysicsObject* boxObject, const OrientedBox& box, real restitution, PhysicsContact* contact) {
+    // Clamp the center to the box, in the box's space
+    Vector3 relative = center - box.center;
+    Vector3 closest = box.center;
+    bool inside = true;
+    real local[3];
+    for (int i = 0; i < 3; i++) {
+        local[i] = box.axes[i].dot(relative);
+        real clamped = std::max(-box.halfSize[i], std::min(box.halfSize[i], local[i]));
+        if (clamped != local[i]) { inside = false; }
+        closest += box.axes[i] * clamped;
+    }
+
+    if (!inside) {
+        Vector3 offset = center - closest;
+        real distanceSquared = offset.magnitudeSquared();
+        if (distanceSquared > radius*radius) { return 0; }
+        real distance = std::sqrt(distanceSquared);
+        Vector3 normal = offset / distance;
+        real penetration = radius - distance;
+        fillContact(contact, sphere, boxObject, normal, closest - normal * (penetration / 2), penetration, restitution);
+        return 1;
+    }
+
+    // The center is inside the box, so push it out through the nearest face
+    int face = 0;
+    real faceDistance = REAL_MAX;
+    for (int i = 0; i < 3; i++) {
+        real distance = box.halfSize[i] - real_abs(local[i]);
+        if (distance < faceDistance) { faceDistance = distance; face = i; }
+    }
+    Vector3 normal = box.axes[face] * (local[face] < 0 ? -1 : 1);
+    real penetration = radius + faceDistance;
+    fillContact(contact, sphere, boxObject, normal, center + normal * (faceDistance - penetration / 2), penetration, restitution);
+    return 1;
+}
+
+/*
+ * Clips a polygon to the side of a plane where direction.dot(p) <= offset,
+ * writing the result into out and returning its number of vertices. Each
+ * vertex has an id, and new vertices where an edge crosses the plane get
+ * one made from the edge's ids and the plane's.
+ */
+static unsigned int clipPolygon(const Vector3* in, const unsigned int* inIds, unsigned int count, Vector3 direction, real offset, unsigned int plane, Vector3* out, unsigned int* outIds) {
+    unsigned int outCount = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int next = (i + 1) % count;
+        const Vector3 &a = in[i], &b = in[next];
+        real distA = direction.dot(a) - offset, distB = direction.dot(b) - offset;
+
+        if (distA <= 0) {
+            outIds[outCount] = inIds[i];
+            out[outCount++] = a;
+        }
+        // Add the point where the edge crosses the plane
+        if ((distA < 0 && distB > 0) || (distA > 0 && distB < 0)) {
+            outIds[outCount] = (plane + 1) << 8 | (inIds[i] & 0xf) << 4 | (inIds[next] & 0xf);
+            out[outCount++] = a + (b - a) * (distA / (distA - distB));
+        }
+    }
+    return outCount;
+}
+
+unsigned int CollisionDetector::reduceManifold(const Vector3 *points, const real *depths, unsigned int count, Vector3 normal, unsigned int *chosen) {
+    if (count <= MAX_MANIFOLD_POINTS) {
+        for (unsigned int i = 0; i < count; i++) { chosen[i] = i; }
+        return count;
+    }
+
+    // Start with the deepest point
+    unsigned int first = 0;
+    for (unsigned int i = 1; i < count; i++) {
+        if (depths[i] > depths[first]) { first = i; }
+    }
+
+    // Then the point farthest from it
+    unsigned int second = first;
+    real bestDistance = -1;
+    for (unsigned int i = 0; i < count; i++) {
+        real distance = (points[i] - points[first]).magnitudeSquared();
+        if (distance > bestDistance) { bestDistance = distance; second = i; }
+    }
+
+    // Then the point making the largest triangle with them, on either side
+    unsigned int third = first;
+    real bestArea = -1;
+    Vector3 edge = points[second] - points[first];
+    for (unsigned int i = 0; i < count; i++) {
+        real area = real_abs(edge.cross(points[i] - points[first]).dot(normal));
+        if (area > bestArea) { bestArea = area; third = i; }
+    }
+
+    // Finally the point that adds the most area outside the triangle
+    unsigned int corners[3] = {first, second, third};
+    real winding = edge.cross(points[third] - points[first]).dot(normal) > 0 ? 1 : -1;
+    unsigned int fourth = count;
+    bestArea = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        for (unsigned int e = 0; e < 3; e++) {
+            const Vector3 &a = points[corners[e]], &b = points[corners[(e + 1) % 3]];
+            // Points outside an edge have the opposite winding to the triangle
+            real area = -winding * (b - a).cross(points[i] - a).dot(normal);
+            if (area > bestArea) { bestArea = area; fourth = i; }
+        }
+    }
+
+    chosen[0] = first; chosen[1] = second; chosen[2] = third;
+    if (fourth == count) { return 3; }
+    chosen[3] = fourth;
+    return 4;
+}
+
+unsigned int CollisionDetector::boxAndBox(RigidBody *box1, RigidBody *box2, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+
+    OrientedBox boxes[2] = {OrientedBox(box1), OrientedBox(box2)};
+    Vector3 toCenter = boxes[1].center - boxes[0].center;
+
+    // Find the axis with the least overlap, with its normal pointing from box 1 to box 2.
+    // Axes 0-2 are box 1's faces, 3-5 are box 2's and 6-14 are pairs of edges.
+    real bestOverlap = REAL_MAX;
+    int bestAxis = -1;
+    Vector3 bestNormal;
+    for (int axisIndex = 0; axisIndex < 15; axisIndex++) {
+        Vector3 axis;
+        if (axisIndex < 6) {
+            axis = boxes[axisIndex / 3].axes[axisIndex % 3];
+        } else {
+            axis = boxes[0].axes[(axisIndex - 6) / 3].cross(boxes[1].axes[(axisIndex - 6) % 3]);
+            // Parallel edges don't give a new axis
+            if (axis.magnitudeSquared() < 1e-6) { continue; }
+            axis.normalize();
+        }
+
+        real distance = toCenter.dot(axis);
+        real overlap = boxes[0].projectOnto(axis) + boxes[1].projectOnto(axis) - real_abs(distance);
+        if (overlap < 0) { return 0; }
+
+        // Prefer faces over edges unless the edges are clearly better, since faces give a stable patch
+        bool better = axisIndex < 6 ? overlap < bestOverlap : overlap < bestOverlap * (real)0.95 - (real)0.001;
+        if (better) {
+            bestOverlap = overlap;
+            bestAxis = axisIndex;
+            bestNormal = distance < 0 ? -axis : axis;
+        }
+    }
+
+    if (bestAxis >= 6) {
+        // Two edges are touching: find the closest points between them
+        const OrientedBox &a = boxes[0], &b = boxes[1];
+        int edgeA = (bestAxis - 6) / 3, edgeB = (bestAxis - 6) % 3;
+
+        // Pick the edge of each box nearest the other box
+        Vector3 pointA = a.center, pointB = b.center;
+        for (int i = 0; i < 3; i++) {
+            if (i != edgeA) { pointA += a.axes[i] * (a.axes[i].dot(bestNormal) > 0 ? a.halfSize[i] : -a.halfSize[i]); }
+            if (i != edgeB) { pointB += b.axes[i] * (b.axes[i].dot(bestNormal) > 0 ? -b.halfSize[i] : b.halfSize[i]); }
+        }
+
+        Vector3 directionA = a.axes[edgeA], directionB = b.axes[edgeB];
+        Vector3 offset = pointA - pointB;
+        real cosine = directionA.dot(directionB);
+        real denominator = 1 - cosine*cosine;
+        real s = denominator > 0 ? (cosine * directionB.dot(offset) - directionA.dot(offset)) / denominator : 0;
+        s = std::max(-a.halfSize[edgeA], std::min(a.halfSize[edgeA], s));
+        real t = cosine * s + directionB.dot(offset);
+        t = std::max(-b.halfSize[edgeB], std::min(b.halfSize[edgeB], t));
+
+        Vector3 closestA = pointA + directionA * s, closestB = pointB + directionB * t;
+        fillContact(contact, box1, box2, -bestNormal, (closestA + closestB) * (real)0.5, bestOverlap, restitution, bestAxis << 16);
+        return 1;
+    }
+
+    // A face is touching: the reference face is the one on the separating axis, and
+    // the incident face is the face of the other box pointing most against it
+    bool referenceIsFirst = bestAxis < 3;
+    const OrientedBox& reference = boxes[referenceIsFirst ? 0 : 1];
+    const OrientedBox& incident = boxes[referenceIsFirst ? 1 : 0];
+    Vector3 normal = referenceIsFirst ? bestNormal : -bestNormal;
+    int face = bestAxis % 3;
+    Vector3 faceCenter = reference.center + normal * reference.halfSize[face];
+
+    int incidentFace = 0;
+    real mostAligned = -1;
+    for (int i = 0; i < 3; i++) {
+        real alignment = real_abs(incident.axes[i].dot(normal));
+        if (alignment > mostAligned) { mostAligned = alignment; incidentFace = i; }
+    }
+    Vector3 incidentNormal = incident.axes[incidentFace] * (incident.axes[incidentFace].dot(normal) > 0 ? -1 : 1);
+    Vector3 incidentCenter = incident.center + incidentNormal * incident.halfSize[incidentFace];
+    Vector3 u = incident.axes[(incidentFace + 1) % 3] * incident.halfSize[(incidentFace + 1) % 3];
+    Vector3 v = incident.axes[(incidentFace + 2) % 3] * incident.halfSize[(incidentFace + 2) % 3];
+
+    // Clip the incident face to the sides of the reference face
+    Vector3 polygon[16] = {incidentCenter + u + v, incidentCenter - u + v, incidentCenter - u - v, incidentCenter + u - v};
+    Vector3 clipped[16];
+    unsigned int polygonIds[16] = {1, 2, 3, 4}, clippedIds[16];
+    unsigned int count = 4;
+    for (int side = 1; side <= 2; side++) {
+        Vector3 sideAxis = reference.axes[(face + side) % 3];
+        real extent = reference.halfSize[(face + side) % 3];
+        real centerOffset = sideAxis.dot(reference.center);
+        count = clipPolygon(polygon, polygonIds, count, sideAxis, centerOffset + extent, 2*side - 2, clipped, clippedIds);
+        count = clipPolygon(clipped, clippedIds, count, -sideAxis, -centerOffset + extent, 2*side - 1, polygon, polygonIds);
+    }
+
+    // Keep the clipped points below the reference face
+    Vector3 points[16];
+    real depths[16];
+    unsigned int ids[16];
+    unsigned int pointCount = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        real depth = normal.dot(faceCenter - polygon[i]);
+        if (depth >= 0) {
+            // Put the contact halfway between the two surfaces
+            points[pointCount] = polygon[i] + normal * (depth / 2);
+            ids[pointCount] = polygonIds[i];
+            depths[pointCount++] = depth;
+        }
+    }
+
+    unsigned int chosen[MAX_MANIFOLD_POINTS];
+    unsigned int used = std::min(reduceManifold(points, depths, pointCount, normal, chosen), limit);
+    for (unsigned int i = 0; i < used; i++) {
+        // Tell the features apart by the faces involved and the incident corner or clipped edge
+        unsigned int featureId = bestAxis << 16 | incidentFace << 14 | ids[chosen[i]];
+        fillContact(contact + i, box1, box2, -bestNormal, points[chosen[i]], depths[chosen[i]], restitution, featureId);
+    }
+    return used;
+}
+
+unsigned int CollisionDetector::boxAndHalfSpace(RigidBody *box, Vector3 normal, real offset, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+
+    OrientedBox orientedBox(box);
+
+    // Quick check using the box's shadow on the normal
+    if (normal.dot(orientedBox.center) - orientedBox.projectOnto(normal) > offset) { return 0; }
+
+    Vector3 points[8];
+    real depths[8];
+    unsigned int corners[8];
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < 8; i++) {
+        Vector3 vertex = orientedBox.getVertex(i);
+        real depth = offset - normal.dot(vertex);
+        if (depth >= 0) {
+            points[count] = vertex + normal * (depth / 2);
+            corners[count] = i;
+            depths[count++] = depth;
+        }
+    }
+
+    unsigned int chosen[MAX_MANIFOLD_POINTS];
+    unsigned int used = std::min(reduceManifold(points, depths, count, normal, chosen), limit);
+    for (unsigned int i = 0; i < used; i++) {
+        fillContact(contact + i, box, nullptr, normal, points[chosen[i]], depths[chosen[i]], restitution, corners[chosen[i]] + 1);
+    }
+    return used;
+}
+
+unsigned int CollisionDetector::sphereAndSphere(RigidBody *sphere1, RigidBody *sphere2, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    return spheresContact(sphere1, sphere1->getPosition(), sphereRadius(sphere1), sphere2, sphere2->getPosition(), sphereRadius(sphere2), restitution, contact);
+}
+
+unsigned int CollisionDetector::sphereAndCapsule(RigidBody *sphere, RigidBody *capsule, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    WorldCapsule worldCapsule(capsule);
+    Vector3 center = sphere->getPosition();
+    Vector3 closest = closestOnSegment(worldCapsule.start, worldCapsule.end, center);
+    return spheresContact(sphere, center, sphereRadius(sphere), capsule, closest, worldCapsule.radius, restitution, contact);
+}
+
+unsigned int CollisionDetector::capsuleAndCapsule(RigidBody *capsule1, RigidBody *capsule2, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    WorldCapsule a(capsule1), b(capsule2);
+    Vector3 directionA = a.end - a.start, directionB = b.end - b.start;
+
+    // Parallel capsules touch along a line, so use both ends of where their cores overlap
+    real lengthA = directionA.magnitudeSquared();
+    if (limit >= 2 && lengthA > 0 && directionA.cross(directionB).magnitudeSquared() < (real)1e-4 * lengthA * directionB.magnitudeSquared()) {
+        real t1 = directionA.dot(b.start - a.start) / lengthA, t2 = directionA.dot(b.end - a.start) / lengthA;
+        real begin = std::max((real)0, std::min(t1, t2)), end = std::min((real)1, std::max(t1, t2));
+        if (end > begin) {
+            unsigned int used = 0;
+            real ends[2] = {begin, end};
+            for (unsigned int i = 0; i < 2; i++) {
+                Vector3 pointA = a.start + directionA * ends[i];
+                Vector3 pointB = closestOnSegment(b.start, b.end, pointA);
+                if (spheresContact(capsule1, pointA, a.radius, capsule2, pointB, b.radius, restitution, contact + used)) {
+                    contact[used++].featureId = i + 1;
+                }
+            }
+            return used;
+        }
+    }
+
+    Vector3 closestA, closestB;
+    closestBetweenSegments(a.start, a.end, b.start, b.end, closestA, closestB);
+    return spheresContact(capsule1, closestA, a.radius, capsule2, closestB, b.radius, restitution, contact);
+}
+
+unsigned int CollisionDetector::sphereAndBox(RigidBody *sphere, RigidBody *box, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    return sphereBoxContact(sphere, sphere->getPosition(), sphereRadius(sphere), box, OrientedBox(box), restitution, contact);
+}
+
+unsigned int CollisionDetector::capsuleAndBox(RigidBody *capsule, RigidBody *box, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    WorldCapsule worldCapsule(capsule);
+    OrientedBox orientedBox(box);
+
+    // Find the point on the core closest to the box. Its distance to
+    // the box is convex along the core, so a golden section search finds it.
+    auto distanceToBox = [&](const Vector3& point) {
+        Vector3 relative = point - orientedBox.center;
+        real distance = 0;
+        for (int i = 0; i < 3; i++) {
+            real outside = real_abs(orientedBox.axes[i].dot(relative)) - orientedBox.halfSize[i];
+            if (outside > 0) { distance += outside*outside; }
+        }
+        return distance;
+    };
+    const real ratio = (real)0.618034;
+    Vector3 direction = worldCapsule.end - worldCapsule.start;
+    real low = 0, high = 1;
+    for (int iteration = 0; iteration < 24; iteration++) {
+        real t1 = high - (high - low) * ratio, t2 = low + (high - low) * ratio;
+        if (distanceToBox(worldCapsule.start + direction * t1) <= distanceToBox(worldCapsule.start + direction * t2)) { high = t2; }
+        else { low = t1; }
+    }
+    Vector3 closest = worldCapsule.start + direction * ((low + high) / 2);
+
+    // Once the core reaches the box, the way out depends on the whole shape
+    real closestDistance = distanceToBox(closest);
+    if (closestDistance < (real)1e-6) { return GJK::collide(capsule, box, restitution, contact, limit); }
+
+    // A capsule lying flat on a face touches it along its length, so use both ends
+    if (limit >= 2) {
+        unsigned int used = sphereBoxContact(capsule, worldCapsule.start, worldCapsule.radius, box, orientedBox, restitution, contact);
+        used += sphereBoxContact(capsule, worldCapsule.end, worldCapsule.radius, box, orientedBox, restitution, contact + used);
+        if (used == 2) { contact[0].featureId = 1; contact[1].featureId = 2; }
+        real deepest = worldCapsule.radius - std::sqrt(closestDistance);
+        if (used == 2 && std::max(contact[0].penetration, contact[1].penetration) >= deepest - worldCapsule.radius * (real)0.01) { return used; }
+    }
+    return sphereBoxContact(capsule, closest, worldCapsule.radius, box, orientedBox, restitution, contact);
+}
+
+unsigned int CollisionDetector::sphereAndHalfSpace(RigidBody *sphere, Vector3 normal, real offset, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    Vector3 center = sphere->getPosition();
+    real radius = sphereRadius(sphere);
+    real penetration = offset + radius - normal.dot(center);
+    if (penetration < 0) { return 0; }
+
+    fillContact(contact, sphere, nullptr, normal, center - normal * (radius - penetration / 2), penetration, restitution);
+    return 1;
+}
+
+unsigned int CollisionDetector::capsuleAndHalfSpace(RigidBody *capsule, Vector3 normal, real offset, real restitution, PhysicsContact *contact, unsigned int limit) {
+    WorldCapsule worldCapsule(capsule);
+    Vector3 ends[2] = {worldCapsule.start, worldCapsule.end};
+    unsigned int used = 0;
+    for (unsigned int i = 0; i < 2 && used < limit; i++) {
+        real penetration = offset + worldCapsule.radius - normal.dot(ends[i]);
+        if (penetration < 0) { continue; }
+        fillContact(contact + used++, capsule, nullptr, normal, ends[i] - normal * (worldCapsule.radius - penetration / 2), penetration, restitution, i + 1);
+    }
+    return used;
+}
+
+unsigned int CollisionDetector::convexAndHalfSpace(RigidBody *body, Vector3 normal, real offset, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+
+    Vector3 deepest = worldSupportPoint(body, -normal);
+    real penetration = offset - normal.dot(deepest);
+    if (penetration < 0) { return 0; }
+
+    fillContact(contact, body, nullptr, normal, deepest + normal * (penetration / 2), penetration, restitution);
+    return 1;
+}
+
+unsigned int CollisionDetector::bodyAndHalfSpace(RigidBody *body, Vector3 normal, real offset, real restitution, PhysicsContact *contact, unsigned int limit) {
+    switch (body->getModel()->getType()) {
+        case RigidBodyModel::SPHERE: return sphereAndHalfSpace(body, normal, offset, restitution, contact, limit);
+        case RigidBodyModel::CAPSULE: return capsuleAndHalfSpace(body, normal, offset, restitution, contact, limit);
+        case RigidBodyModel::BOX: return boxAndHalfSpace(body, normal, offset, restitution, contact, limit);
+        default: return convexAndHalfSpace(body, normal, offset, restitution, contact, limit);
+    }
+}
+
+unsigned int CollisionDetector::particleAndHalfSpace(PhysicsObject *particle, Vector3 center, Vector3 normal, real offset, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    real penetration = offset + Particle::RADIUS - normal.dot(center);
+    if (penetration < 0) { return 0; }
+
+    fillContact(contact, particle, nullptr, normal, center - normal * (Particle::RADIUS - penetration / 2), penetration, restitution);
+    return 1;
+}
+
+unsigned int CollisionDetector::sphereAndMesh(RigidBody *sphere, RigidBody *mesh, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    WorldMesh worldMesh(mesh);
+    MeshManifold manifold(sphere);
+    Vector3 center = sphere->getPosition();
+    real radius = sphereRadius(sphere);
+    worldMesh.forEachTriangleNear(sphere, [&](unsigned int t) {
+        Vector3 triangle[3];
+        worldMesh.getTriangle(t, triangle);
+        sphereTriangleContact(center, radius, triangle, meshFeature(t, 8), manifold);
+    });
+    return manifold.write(sphere, mesh, restitution, contact, limit);
+}
+
+unsigned int CollisionDetector::capsuleAndMesh(RigidBody *capsule, RigidBody *mesh, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    WorldMesh worldMesh(mesh);
+    MeshManifold manifold(capsule);
+    WorldCapsule worldCapsule(capsule);
+    worldMesh.forEachTriangleNear(capsule, [&](unsigned int t) {
+        Vector3 triangle[3];
+        worldMesh.getTriangle(t, triangle);
+
+        // A capsule lying flat on the triangle touches it at both ends
+        bool startTouches = sphereTriangleContact(worldCapsule.start, worldCapsule.radius, triangle, meshFeature(t, 0), manifold);
+        bool endTouches = sphereTriangleContact(worldCapsule.end, worldCapsule.radius, triangle, meshFeature(t, 1), manifold);
+        if (startTouches && endTouches) { return; }
+
+        // Otherwise the closest point on the core is on one of the triangle's edges,
+        // unless the core passes through the triangle
+        Vector3 normal = (triangle[1] - triangle[0]).cross(triangle[2] - triangle[0]);
+        real startSide = normal.dot(worldCapsule.start - triangle[0]), endSide = normal.dot(worldCapsule.end - triangle[0]);
+        if ((startSide < 0) != (endSide < 0)) {
+            Vector3 crossing = worldCapsule.start + (worldCapsule.end - worldCapsule.start) * (startSide / (startSide - endSide));
+            if (insideTriangle(crossing, triangle, normal)) {
+                convexTriangleContact(capsule, triangle, meshFeature(t, 8), manifold);
+                return;
+            }
+        }
+
+        Vector3 bestCore, bestTriangle;
+        real bestDistance = REAL_MAX;
+        for (unsigned int e = 0; e < 3; e++) {
+            Vector3 onCore, onEdge;
+            closestBetweenSegments(worldCapsule.start, worldCapsule.end, triangle[e], triangle[(e + 1) % 3], onCore, onEdge);
+            real distance = (onCore - onEdge).magnitudeSquared();
+            if (distance < bestDistance) { bestDistance = distance; bestCore = onCore; bestTriangle = onEdge; }
+        }
+        if (startTouches || endTouches) {
+            // The end already found is closer than any edge, unless the middle is
+            Vector3 end = startTouches ? worldCapsule.start : worldCapsule.end;
+            if ((end - CollisionDetector::closestOnTriangle(end, triangle[0], triangle[1], triangle[2])).magnitudeSquared() <= bestDistance) { return; }
+        }
+        sphereTriangleContact(bestCore, worldCapsule.radius, triangle, meshFeature(t, 8), manifold);
+    });
+    return manifold.write(capsule, mesh, restitution, contact, limit);
+}
+
+unsigned int CollisionDetector::boxAndMesh(RigidBody *box, RigidBody *mesh, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    WorldMesh worldMesh(mesh);
+    MeshManifold manifold(box);
+    OrientedBox orientedBox(box);
+    Vector3 vertices[8];
+    for (unsigned int i = 0; i < 8; i++) { vertices[i] = orientedBox.getVertex(i); }
+
+    worldMesh.forEachTriangleNear(box, [&](unsigned int t) {
+        Vector3 triangle[3];
+        worldMesh.getTriangle(t, triangle);
+        Vector3 normal = (triangle[1] - triangle[0]).cross(triangle[2] - triangle[0]).normalized();
+        if (normal.isZero()) { return; }
+
+        // Face the normal towards the box, then check the box crosses the plane at all
+        real offset = normal.dot(triangle[0]);
+        real centerDistance = normal.dot(orientedBox.center) - offset;
+        if (centerDistance < 0) { normal = -normal; offset = -offset; centerDistance = -centerDistance; }
+        if (centerDistance - orientedBox.projectOnto(normal) > 0) { return; }
+
+        // Corners through the plane above the triangle are pushed straight back out
+        bool found = false;
+        for (unsigned int i = 0; i < 8; i++) {
+            real depth = offset - normal.dot(vertices[i]);
+            if (depth < 0) { continue; }
+            Vector3 projected = vertices[i] + normal * depth;
+            if (!insideTriangle(projected, triangle, normal)) { continue; }
+            manifold.add(normal, vertices[i] + normal * (depth / 2), depth, meshFeature(t, i), true);
+            found = true;
+        }
+
+        // Otherwise an edge or corner of the triangle is in the box
+        if (!found) { convexTriangleContact(box, triangle, meshFeature(t, 8), manifold); }
+    });
+    return manifold.write(box, mesh, restitution, contact, limit);
+}
+
+unsigned int CollisionDetector::convexAndMesh(RigidBody *body, RigidBody *mesh, real restitution, PhysicsContact *contact, unsigned int limit) {
+    if (limit == 0) { return 0; }
+    WorldMesh worldMesh(mesh);
+    MeshManifold manifold(body);
+    Vector3 center = body->getPosition();
+    worldMesh.forEachTriangleNear(body, [&](unsigned int t) {
+        Vector3 triangle[3];
+        worldMesh.getTriangle(t, triangle);
+        Vector3 normal = (triangle[1] - triangle[0]).cross(triangle[2] - triangle[0]).normalized();
+        if (normal.isZero()) { return; }
+
+        // Like a half-space, the body's deepest point through the plane is pushed
+        // straight back out, as long as it went through the triangle itself
+        if (normal.dot(center - triangle[0]) < 0) { normal = -normal; }
+        Vector3 deepest = worldSupportPoint(body, -normal);
+        real depth = normal.dot(triangle[0] - deepest);
+        if (depth < 0) { return; }
+        if (insideTriangle(deepest + normal * depth, triangle, normal)) {
+            manifold.add(normal, deepest + normal * (depth / 2), depth, meshFeature(t, 8), true);
+        } else {
+            convexTriangleContact(body, triangle, meshFeature(t, 8), manifold);
+        }
+    });
+    return manifold.write(body, mesh, restitution, contact, limit);
+}
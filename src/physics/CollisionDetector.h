@@ -0,0 +1,99 @@
+#ifndef PHYSICSENGINE_COLLISIONDETECTOR_H
+#define PHYSICSENGINE_COLLISIONDETECTOR_H
+
+#include "PhysicsContact.h"
+
+// Avoid circular dependency
+class RigidBody;
+
+/*
+ * The narrow-phase routines that find exactly where two shapes
+ * touch. Like ContactGenerator::addContact, each one writes its
+ * contacts into the given array, up to limit, and returns the
+ * number written.
+ *
+ * Contacts between a pair of shapes are reduced to at most
+ * MAX_MANIFOLD_POINTS points spanning the touching area, which
+ * is all a resting body needs and keeps the resolver's work down.
+ */
+class CollisionDetector {
+public:
+    static const unsigned int MAX_MANIFOLD_POINTS = 4;
+
+    /*
+     * Finds the contacts between two RigidBodies with RectangularPrismModels
+     * by testing the 15 potential separating axes. When a face is the axis
+     * of least penetration, the other box's closest face is clipped against
+     * it; when a pair of edges is, they touch at a single point.
+     */
+    static unsigned int boxAndBox(RigidBody* box1, RigidBody* box2, real restitution, PhysicsContact* contact, unsigned int limit);
+
+    /*
+     * Finds the contacts between a RigidBody with a RectangularPrismModel
+     * and the half-space of points p where normal.dot(p) <= offset. The
+     * normal should be normalized.
+     */
+    static unsigned int boxAndHalfSpace(RigidBody* box, Vector3 normal, real offset, real restitution, PhysicsContact* contact, unsigned int limit);
+
+    /*
+     * The routines for SphereModels and CapsuleModels, which only need the
+     * closest points between their cores. Capsules lying along each other
+     * or flat on a face touch at both ends of the overlap.
+     */
+    static unsigned int sphereAndSphere(RigidBody* sphere1, RigidBody* sphere2, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int sphereAndCapsule(RigidBody* sphere, RigidBody* capsule, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int capsuleAndCapsule(RigidBody* capsule1, RigidBody* capsule2, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int sphereAndBox(RigidBody* sphere, RigidBody* box, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int capsuleAndBox(RigidBody* capsule, RigidBody* box, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int sphereAndHalfSpace(RigidBody* sphere, Vector3 normal, real offset, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int capsuleAndHalfSpace(RigidBody* capsule, Vector3 normal, real offset, real restitution, PhysicsContact* contact, unsigned int limit);
+
+    /*
+     * Finds the contact between any convex RigidBody and a half-space at
+     * the model's support point along -normal, its deepest point.
+     */
+    static unsigned int convexAndHalfSpace(RigidBody* body, Vector3 normal, real offset, real restitution, PhysicsContact* contact, unsigned int limit);
+
+    /*
+     * Picks the half-space routine for the body's model, falling
+     * back to convexAndHalfSpace for models without their own.
+     */
+    static unsigned int bodyAndHalfSpace(RigidBody* body, Vector3 normal, real offset, real restitution, PhysicsContact* contact, unsigned int limit);
+
+    /*
+     * Finds the contact between a Particle, as a sphere of Particle::RADIUS
+     * around center, and a half-space. Taking the center lets callers that
+     * already have it in an array skip reading it from the Particle.
+     */
+    static unsigned int particleAndHalfSpace(PhysicsObject* particle, Vector3 center, Vector3 normal, real offset, real restitution, PhysicsContact* contact, unsigned int limit);
+
+    /*
+     * The routines for a body against a TriangleMeshModel, which test each
+     * triangle near the body's bounding sphere and reduce the contacts
+     * from all of them to one manifold. Triangles are two-sided. Spheres
+     * and capsules use the closest points on each triangle, while boxes
+     * and other convex models are pushed back out through the face their
+     * corners or deepest point went through. Where they went past an edge
+     * instead, GJK finds the contact.
+     */
+    static unsigned int sphereAndMesh(RigidBody* sphere, RigidBody* mesh, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int capsuleAndMesh(RigidBody* capsule, RigidBody* mesh, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int boxAndMesh(RigidBody* box, RigidBody* mesh, real restitution, PhysicsContact* contact, unsigned int limit);
+    static unsigned int convexAndMesh(RigidBody* body, RigidBody* mesh, real restitution, PhysicsContact* contact, unsigned int limit);
+
+    /*
+     * Picks the points that best cover a contact patch: the deepest,
+     * the one farthest from it, and then the two that add the most
+     * area. Writes the indices of the chosen points into chosen and
+     * returns how many there are, at most MAX_MANIFOLD_POINTS.
+     */
+    static unsigned int reduceManifold(const Vector3* points, const real* depths, unsigned int count, Vector3 normal, unsigned int* chosen);
+
+    /*
+     * Returns the point of the triangle abc closest to the given point.
+     */
+    static Vector3 closestOnTriangle(const Vector3& point, const Vector3& a, const Vector3& b, const Vector3& c);
+};
+
+
+#endif //PHYSICSENGINE_COLLISIONDETECTOR_H
@@ -0,0 +1,39 @@
+#include "CollisionDispatcher.h"
+#include "CollisionDetector.h"
+#include "RigidBody.h"
+
+CollisionDispatcher::CollisionDispatcher() : functions(), swapped() {
+    registerFunction(RigidBodyModel::SPHERE, RigidBodyModel::SPHERE, CollisionDetector::sphereAndSphere);
+    registerFunction(RigidBodyModel::SPHERE, RigidBodyModel::CAPSULE, CollisionDetector::sphereAndCapsule);
+    registerFunction(RigidBodyModel::SPHERE, RigidBodyModel::BOX, CollisionDetector::sphereAndBox);
+    registerFunction(RigidBodyModel::CAPSULE, RigidBodyModel::CAPSULE, CollisionDetector::capsuleAndCapsule);
+    registerFunction(RigidBodyModel::CAPSULE, RigidBodyModel::BOX, CollisionDetector::capsuleAndBox);
+    registerFunction(RigidBodyModel::BOX, RigidBodyModel::BOX, CollisionDetector::boxAndBox);
+    registerFunction(RigidBodyModel::SPHERE, RigidBodyModel::TRIANGLE_MESH, CollisionDetector::sphereAndMesh);
+    registerFunction(RigidBodyModel::CAPSULE, RigidBodyModel::TRIANGLE_MESH, CollisionDetector::capsuleAndMesh);
+    registerFunction(RigidBodyModel::BOX, RigidBodyModel::TRIANGLE_MESH, CollisionDetector::boxAndMesh);
+    registerFunction(RigidBodyModel::CONVEX_HULL, RigidBodyModel::TRIANGLE_MESH, CollisionDetector::convexAndMesh);
+    registerFunction(RigidBodyModel::GENERIC, RigidBodyModel::TRIANGLE_MESH, CollisionDetector::convexAndMesh);
+}
+
+void CollisionDispatcher::registerFunction(unsigned int typeA, unsigned int typeB, CollisionFunction function) {
+    if (typeA >= RigidBodyModel::MAX_TYPES || typeB >= RigidBodyModel::MAX_TYPES) { return; }
+    functions[typeA][typeB] = function;
+    swapped[typeA][typeB] = false;
+    if (typeA != typeB) {
+        functions[typeB][typeA] = function;
+        swapped[typeB][typeA] = true;
+    }
+}
+
+bool CollisionDispatcher::hasFunction(unsigned int typeA, unsigned int typeB) const {
+    if (typeA >= RigidBodyModel::MAX_TYPES || typeB >= RigidBodyModel::MAX_TYPES) { return false; }
+    return functions[typeA][typeB] != nullptr;
+}
+
+unsigned int CollisionDispatcher::collide(RigidBody *body1, RigidBody *body2, real restitution, PhysicsContact *contact, unsigned int limit) const {
+    unsigned int type1 = body1->getModel()->getType(), type2 = body2->getModel()->getType();
+    if (!hasFunction(type1, type2)) { return 0; }
+    if (swapped[type1][type2]) { return functions[type1][type2](body2, body1, restitution, contact, limit); }
+    return functions[type1][type2](body1, body2, restitution, contact, limit);
+}
@@ -0,0 +1,58 @@
+#ifndef PHYSICSENGINE_COLLISIONDISPATCHER_H
+#define PHYSICSENGINE_COLLISIONDISPATCHER_H
+
+#include "PhysicsContact.h"
+#include "RigidBodyModel.h"
+
+// Avoid circular dependency
+class RigidBody;
+
+/*
+ * A narrow-phase routine for one pair of model types, with the same
+ * arguments and result as the routines in CollisionDetector.
+ */
+typedef unsigned int (*CollisionFunction)(RigidBody* body1, RigidBody* body2, real restitution, PhysicsContact* contact, unsigned int limit);
+
+/*
+ * Picks the narrow-phase routine for a pair of RigidBodies from a
+ * table indexed by their models' type ids, so finding it is two
+ * array lookups rather than a chain of casts.
+ *
+ * A routine registered for (typeA, typeB) is also used for
+ * (typeB, typeA), with the bodies passed in swapped. The built-in
+ * routines for spheres, capsules and boxes, and for each of them
+ * against triangle meshes, are registered when the dispatcher is
+ * created, and custom ones can be added or replace them. Pairs
+ * without a routine, including those with a type id of MAX_TYPES
+ * from a full RigidBodyModel::registerType(), have none to dispatch
+ * to, and are left to the caller's general method.
+ */
+class CollisionDispatcher {
+private:
+    CollisionFunction functions[RigidBodyModel::MAX_TYPES][RigidBodyModel::MAX_TYPES];
+    bool swapped[RigidBodyModel::MAX_TYPES][RigidBodyModel::MAX_TYPES];
+
+public:
+    CollisionDispatcher();
+
+    /*
+     * Sets the routine for bodies of typeA and typeB. It will always be
+     * passed a body of typeA first. Pass nullptr to remove a routine.
+     * Type ids of MAX_TYPES or more are ignored.
+     */
+    void registerFunction(unsigned int typeA, unsigned int typeB, CollisionFunction function);
+
+    /*
+     * Returns whether there is a routine for the pair of types.
+     */
+    bool hasFunction(unsigned int typeA, unsigned int typeB) const;
+
+    /*
+     * Runs the routine for a pair of bodies. Returns 0 if they have none.
+     */
+    unsigned int collide(RigidBody* body1, RigidBody* body2, real restitution, PhysicsContact* contact, unsigned int limit) const;
+
+};
+
+
+#endif //PHYSICSENGINE_COLLISIONDISPATCHER_H
@@ -0,0 +1,70 @@
+#include "ContactCache.h"
+
+size_t ContactCache::PairHash::operator()(const std::pair<PhysicsObject*, PhysicsObject*> &pair) const {
+    return std::hash<PhysicsObject*>()(pair.first) * 31 ^ std::hash<PhysicsObject*>()(pair.second);
+}
+
+ContactCache::ContactCache(real matchDistance) : matchDistance(matchDistance), step(0) {}
+
+std::pair<PhysicsObject*, PhysicsObject*> ContactCache::pairOf(const PhysicsContact &contact) {
+    if (contact.objects[1] && contact.objects[1]->getWorldIndex() < contact.objects[0]->getWorldIndex()) {
+        return std::make_pair(contact.objects[1], contact.objects[0]);
+    }
+    return std::make_pair(contact.objects[0], contact.objects[1]);
+}
+
+void ContactCache::warmStart(PhysicsContact *contactArray, unsigned int numContacts) {
+    for (unsigned int i = 0; i < numContacts; i++) {
+        PhysicsContact& contact = contactArray[i];
+        contact.normalImpulse = 0;
+        contact.frictionImpulse = Vector3();
+
+        auto it = manifolds.find(pairOf(contact));
+        if (it == manifolds.end() || it->second.lastStep != step) { continue; }
+
+        // Take the impulse from the nearest cached point on the same features
+        const Manifold& manifold = it->second;
+        Vector3 localPoint = it->first.first->getPointInBodySpace(contact.contactPoint);
+        real bestDistance = matchDistance * matchDistance;
+        for (unsigned int p = 0; p < manifold.pointCount; p++) {
+            const CachedPoint& point = manifold.points[p];
+            if (point.featureId != contact.featureId) { continue; }
+            real distance = (point.localPoint - localPoint).magnitudeSquared();
+            if (distance <= bestDistance) {
+                bestDistance = distance;
+                contact.normalImpulse = point.normalImpulse;
+                contact.frictionImpulse = contact.objects[0] == it->first.first ? point.frictionImpulse : -point.frictionImpulse;
+            }
+        }
+    }
+}
+
+void ContactCache::store(PhysicsContact *contactArray, unsigned int numContacts) {
+    step++;
+    for (unsigned int i = 0; i < numContacts; i++) {
+        const PhysicsContact& contact = contactArray[i];
+        auto key = pairOf(contact);
+        Manifold& manifold = manifolds[key];
+
+        // The first contact for the pair this step replaces what was there
+        if (manifold.lastStep != step) {
+            manifold.pointCount = 0;
+            manifold.lastStep = step;
+        }
+        if (manifold.pointCount == MAX_MANIFOLD_POINTS) { continue; }
+
+        CachedPoint& point = manifold.points[manifold.pointCount++];
+        point.featureId = contact.featureId;
+        point.localPoint = key.first->getPointInBodySpace(contact.contactPoint);
+        point.normalImpulse = contact.normalImpulse;
+        point.frictionImpulse = contact.objects[0] == key.first ? contact.frictionImpulse : -contact.frictionImpulse;
+    }
+
+    // Forget the pairs that had no contacts this step
+    for (auto it = manifolds.begin(); it != manifolds.end();) {
+        if (it->second.lastStep != step) { it = manifolds.erase(it); }
+        else { ++it; }
+    }
+}
+
+unsigned int ContactCache::getManifoldCount() const { return manifolds.size(); }
@@ -0,0 +1,91 @@
+#ifndef PHYSICSENGINE_CONTACTCACHE_H
+#define PHYSICSENGINE_CONTACTCACHE_H
+
+#include <unordered_map>
+#include "PhysicsContact.h"
+
+/*
+ * Remembers the contacts between each pair of objects from one
+ * step to the next, so a resolver can start from the impulses it
+ * found last time instead of from nothing.
+ *
+ * Contacts are grouped into a manifold per pair of objects, held
+ * in a hash map. A new contact is matched with one from the last
+ * step when they have the same pair and feature id, and are close
+ * together relative to the first object. Manifolds that weren't
+ * refreshed in the last step are thrown away.
+ */
+class ContactCache {
+public:
+    static const unsigned int MAX_MANIFOLD_POINTS = 8;
+
+private:
+    struct CachedPoint {
+        unsigned int featureId;
+
+        /*
+         * Holds the contact point in the space of the first object of the pair.
+         */
+        Vector3 localPoint;
+
+        real normalImpulse;
+
+        /*
+         * Holds the friction impulse on the first object of the pair, which
+         * is the opposite of the contact's if its objects are the other way round.
+         */
+        Vector3 frictionImpulse;
+    };
+
+    struct Manifold {
+        CachedPoint points[MAX_MANIFOLD_POINTS];
+        unsigned int pointCount;
+        unsigned int lastStep;
+    };
+
+    struct PairHash {
+        size_t operator()(const std::pair<PhysicsObject*, PhysicsObject*>& pair) const;
+    };
+
+    std::unordered_map<std::pair<PhysicsObject*, PhysicsObject*>, Manifold, PairHash> manifolds;
+
+    /*
+     * Holds how far apart two points can be and still match.
+     */
+    real matchDistance;
+
+    unsigned int step;
+
+    /*
+     * Returns the key for a contact's pair. The first object of the
+     * key is the one added to the world first, so the order the
+     * objects are given in doesn't matter, unless the second is
+     * scenery.
+     */
+    static std::pair<PhysicsObject*, PhysicsObject*> pairOf(const PhysicsContact& contact);
+
+public:
+    explicit ContactCache(real matchDistance = (real)0.05);
+
+    /*
+     * Sets each contact's normalImpulse and frictionImpulse to those
+     * of the contact it matches from the last step, or to 0 if it's new.
+     */
+    void warmStart(PhysicsContact* contactArray, unsigned int numContacts);
+
+    /*
+     * Replaces the cached contacts with this step's, and throws away
+     * manifolds for pairs that are no longer touching. Called once
+     * per step, after the contacts are resolved.
+     */
+    void store(PhysicsContact* contactArray, unsigned int numContacts);
+
+    /*
+     * Returns the number of pairs with cached contacts.
+     */
+    unsigned int getManifoldCount() const;
+
+};
+
+
+#endif //PHYSICSENGINE_CONTACTCACHE_H
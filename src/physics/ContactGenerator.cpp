@@ -1,18 +1,113 @@
 #include "ContactGenerator.h"
+#include "RigidBody.h"
+#include "CollisionDetector.h"
 
 FloorContactGenerator::FloorContactGenerator(PhysicsObject *object, real floorY, real restitution) : object(object), floorY(floorY), restitution(restitution) {}
 
 unsigned int FloorContactGenerator::addContact(PhysicsContact *contact, unsigned int limit) const {
     real y = object->getPosition().y;
 
-    if (y > floorY) { return 0; }
+    if (limit == 0 || y > floorY) { return 0; }
 
     contact->objects[0] = object;
     contact->objects[1] = nullptr;
     contact->penetration = floorY - y;
     contact->contactNormal = Vector3::UP;
+    contact->contactPoint = Vector3(object->getPosition().x, floorY, object->getPosition().z);
+    contact->featureId = 0;
     contact->restitution = restitution;
 
     return 1;
 }
 
+void PairContactGenerator::beginStep() {}
+
+BoundingSphereContactGenerator::BoundingSphereContactGenerator(real restitution) : restitution(restitution) {}
+
+unsigned int BoundingSphereContactGenerator::addContact(RigidBody *body1, RigidBody *body2, PhysicsContact *contact, unsigned int limit) const {
+    if (limit == 0) { return 0; }
+
+    BoundingSphere sphere1 = body1->getBoundingSphere(), sphere2 = body2->getBoundingSphere();
+
+    // The normal points from the second body towards the first
+    Vector3 offset = sphere1.center - sphere2.center;
+    real distance = offset.magnitude();
+    real penetration = sphere1.radius + sphere2.radius - distance;
+
+    if (penetration < 0) { return 0; }
+
+    contact->objects[0] = body1;
+    contact->objects[1] = body2;
+    contact->contactNormal = distance > 0 ? offset / distance : Vector3::UP;
+    contact->penetration = penetration;
+    contact->contactPoint = sphere2.center + offset * (sphere2.radius / (sphere1.radius + sphere2.radius));
+    contact->featureId = 0;
+    contact->restitution = restitution;
+
+    return 1;
+}
+
+BoxContactGenerator::BoxContactGenerator(real restitution) : BoundingSphereContactGenerator(restitution) {}
+
+unsigned int BoxContactGenerator::addContact(RigidBody *body1, RigidBody *body2, PhysicsContact *contact, unsigned int limit) const {
+    if (body1->getModel()->getType() == RigidBodyModel::BOX && body2->getModel()->getType() == RigidBodyModel::BOX) {
+        return CollisionDetector::boxAndBox(body1, body2, restitution, contact, limit);
+    }
+    return BoundingSphereContactGenerator::addContact(body1, body2, contact, limit);
+}
+
+size_t ConvexContactGenerator::PairHash::operator()(const std::pair<const RigidBody*, const RigidBody*> &pair) const {
+    return std::hash<const RigidBody*>()(pair.first) * 31 ^ std::hash<const RigidBody*>()(pair.second);
+}
+
+ConvexContactGenerator::ConvexContactGenerator(real restitution) : step(0), restitution(restitution) {}
+
+unsigned int ConvexContactGenerator::addContact(RigidBody *body1, RigidBody *body2, PhysicsContact *contact, unsigned int limit) const {
+    // The broad phase may hand over a pair in either order, so always look it up the same way around
+    if (body2->getWorldIndex() < body1->getWorldIndex()) { std::swap(body1, body2); }
+
+    // GJK only sees the box around a mesh, so an axis that separates it from the
+    // box would rarely hold, and refreshing it would cost a GJK query every step
+    bool mesh1 = body1->getModel()->getType() == RigidBodyModel::TRIANGLE_MESH;
+    bool mesh2 = body2->getModel()->getType() == RigidBodyModel::TRIANGLE_MESH;
+    if (mesh1 || mesh2) {
+        if (dispatcher.hasFunction(body1->getModel()->getType(), body2->getModel()->getType())) { return dispatcher.collide(body1, body2, restitution, contact, limit); }
+
+        // Custom models test the mesh's triangles rather than the box around it
+        if (mesh2) { return CollisionDetector::convexAndMesh(body1, body2, restitution, contact, limit); }
+        return CollisionDetector::convexAndMesh(body2, body1, restitution, contact, limit);
+    }
+
+    CachedSimplex& cached = simplexes[std::make_pair(body1, body2)];
+    cached.lastStep = step;
+
+    // Specialized routines, like those for spheres, capsules and boxes, are far cheaper than GJK
+    if (dispatcher.hasFunction(body1->getModel()->getType(), body2->getModel()->getType())) {
+        if (GJK::isSeparated(body1, body2, cached.simplex)) { return 0; }
+
+        unsigned int count = dispatcher.collide(body1, body2, restitution, contact, limit);
+        if (count > 0) { cached.simplex.separatingAxis = Vector3(); }
+        else {
+            // Only pairs that just came apart, or turned so the old axis no longer works, get here
+            Vector3 closest1, closest2;
+            GJK::distance(body1, body2, closest1, closest2, &cached.simplex);
+        }
+        return count;
+    }
+
+    return GJK::collide(body1, body2, restitution, contact, limit, &cached.simplex);
+}
+
+void ConvexContactGenerator::beginStep() {
+    step++;
+    for (auto it = simplexes.begin(); it != simplexes.end();) {
+        if (step - it->second.lastStep > 1) { it = simplexes.erase(it); }
+        else { ++it; }
+    }
+}
+
+HalfSpaceContactGenerator::HalfSpaceContactGenerator(RigidBody *body, Vector3 normal, real offset, real restitution) : body(body), normal(normal.normalized()), offset(offset), restitution(restitution) {}
+
+unsigned int HalfSpaceContactGenerator::addContact(PhysicsContact *contact, unsigned int limit) const {
+    return CollisionDetector::bodyAndHalfSpace(body, normal, offset, restitution, contact, limit);
+}
@@ -1,7 +1,13 @@
 #ifndef PHYSICSENGINE_CONTACTGENERATOR_H
 #define PHYSICSENGINE_CONTACTGENERATOR_H
 
+#include <unordered_map>
 #include "PhysicsContact.h"
+#include "GJK.h"
+#include "CollisionDispatcher.h"
+
+// Avoid circular dependency
+class RigidBody;
 
 /*
  * Interface for creating contacts between PhysicsObjects
@@ -35,5 +41,121 @@ public:
 
 };
 
+/*
+ * Interface for the narrow phase: creating contacts between a pair
+ * of RigidBodies that the broad phase found might be touching.
+ */
+class PairContactGenerator {
+
+public:
+    /*
+     * Works like ContactGenerator::addContact, but for the given pair.
+     */
+    virtual unsigned int addContact(RigidBody* body1, RigidBody* body2, PhysicsContact* contact, unsigned int limit) const = 0;
+
+    /*
+     * Called once each step before any pairs are passed in, for
+     * generators that keep data about pairs between steps.
+     */
+    virtual void beginStep();
+
+};
+
+/*
+ * A narrow phase that treats each RigidBody as its bounding sphere.
+ * This is exact for spherical bodies and conservative for others.
+ */
+class BoundingSphereContactGenerator : public PairContactGenerator {
+
+public:
+    real restitution;
+
+    explicit BoundingSphereContactGenerator(real restitution);
+
+    unsigned int addContact(RigidBody* body1, RigidBody* body2, PhysicsContact* contact, unsigned int limit) const override;
+
+};
+
+/*
+ * A narrow phase that finds the exact contact manifold between
+ * RigidBodies with RectangularPrismModels. Pairs where either
+ * model isn't a box fall back to their bounding spheres.
+ */
+class BoxContactGenerator : public BoundingSphereContactGenerator {
+
+public:
+    explicit BoxContactGenerator(real restitution);
+
+    unsigned int addContact(RigidBody* body1, RigidBody* body2, PhysicsContact* contact, unsigned int limit) const override;
+
+};
+
+/*
+ * A narrow phase for RigidBodies with any convex models, using GJK
+ * and EPA. Pairs with a routine in the dispatcher, like the spheres,
+ * capsules and boxes in CollisionDetector, use it instead. Each
+ * pair's last simplex is kept to start the next step's
+ * query from, and forgotten once the pair stops being tested.
+ *
+ * Pairs that were apart also keep the axis separating them. Most
+ * pairs the broad phase hands over are close but not touching,
+ * and while their cached axis still separates them they are
+ * rejected without running either GJK or the dispatched routine.
+ * Pairs with a triangle mesh skip the cache and go straight to
+ * its triangles.
+ */
+class ConvexContactGenerator : public PairContactGenerator {
+
+private:
+    struct CachedSimplex {
+        GJK::SimplexCache simplex;
+        unsigned int lastStep;
+    };
+
+    struct PairHash {
+        size_t operator()(const std::pair<const RigidBody*, const RigidBody*>& pair) const;
+    };
+
+    mutable std::unordered_map<std::pair<const RigidBody*, const RigidBody*>, CachedSimplex, PairHash> simplexes;
+    unsigned int step;
+
+public:
+    real restitution;
+
+    /*
+     * Holds the specialized routines, where custom ones can be registered.
+     */
+    CollisionDispatcher dispatcher;
+
+    explicit ConvexContactGenerator(real restitution);
+
+    unsigned int addContact(RigidBody* body1, RigidBody* body2, PhysicsContact* contact, unsigned int limit) const override;
+
+    void beginStep() override;
+
+};
+
+/*
+ * Creates contacts between a RigidBody and a half-space, such as the
+ * ground, made up of the points p where normal.dot(p) <= offset. Boxes
+ * touch at up to four of their corners and capsules at both ends;
+ * other models touch at their deepest point.
+ *
+ * For many bodies, PhysicsWorld::addHalfSpace tests them all in one pass.
+ */
+class HalfSpaceContactGenerator : public ContactGenerator {
+
+public:
+    RigidBody* body;
+    Vector3 normal;
+    real offset;
+
+    real restitution;
+
+    HalfSpaceContactGenerator(RigidBody* body, Vector3 normal, real offset, real restitution);
+
+    unsigned int addContact(PhysicsContact* contact, unsigned int limit) const override;
+
+};
 
 #endif //PHYSICSENGINE_CONTACTGENERATOR_H
@@ -0,0 +1,221 @@
+#include "ContinuousCollision.h"
+#include "RigidBody.h"
+#include "GJK.h"
+#include "SpatialQuery.h"
+
+const real ContinuousCollision::TOLERANCE((real)0.005);
+const real ContinuousCollision::CONTACT_DEPTH((real)0.01);
+
+static const int MAX_ITERATIONS = 32;
+
+/*
+ * Returns how far a body moved over the last step, or nothing if
+ * it doesn't use continuous collision.
+ */
+static Vector3 getMotion(const RigidBody* body) {
+    if (!body->usesContinuousCollision()) { return Vector3(); }
+    return body->getPosition() - body->getPreviousPosition();
+}
+
+/*
+ * Returns how far any point of a body could have moved over the last
+ * step because of its rotation: the angle it turned through times the
+ * distance from its center to the farthest point of its model.
+ */
+static real getRotationBound(const RigidBody* body) {
+    if (!body->usesContinuousCollision()) { return 0; }
+
+    Quaternion q1 = body->getPreviousOrientation(), q2 = body->getOrientation();
+    real cosine = std::min((real)1, real_abs(q1.r*q2.r + q1.i*q2.i + q1.j*q2.j + q1.k*q2.k));
+    BoundingSphere sphere = body->getModel()->getBoundingSphere();
+    return 2 * std::acos(cosine) * (sphere.center.magnitude() + sphere.radius);
+}
+
+/*
+ * Places a body part way between two poses. The orientations are
+ * blended and renormalized, which is close enough for the small
+ * turns made in a step.
+ */
+static void placeBetween(RigidBody* body, const Vector3& position1, const Quaternion& orientation1, const Vector3& position2, const Quaternion& orientation2, real time) {
+    // Take the shorter way around between the two orientations
+    real dot = orientation1.r*orientation2.r + orientation1.i*orientation2.i + orientation1.j*orientation2.j + orientation1.k*orientation2.k;
+    real weight1 = 1 - time, weight2 = dot < 0 ? -time : time;
+
+    body->setPosition(position1 + (position2 - position1) * time);
+    body->setOrientation(Quaternion(orientation1.r*weight1 + orientation2.r*weight2, orientation1.i*weight1 + orientation2.i*weight2,
+                                    orientation1.j*weight1 + orientation2.j*weight2, orientation1.k*weight1 + orientation2.k*weight2));
+}
+
+bool ContinuousCollision::sweptSpheres(const BoundingSphere &sphere1, const Vector3 &motion1, const BoundingSphere &sphere2, const Vector3 &motion2, real &time) {
+    // Solve |offset + motion*t| = radius for the first t, with the second sphere held still
+    Vector3 offset = sphere1.center - sphere2.center;
+    Vector3 motion = motion1 - motion2;
+    real radius = sphere1.radius + sphere2.radius;
+
+    real c = offset.magnitudeSquared() - radius*radius;
+    if (c <= 0) {
+        time = 0;
+        return true;
+    }
+
+    real a = motion.magnitudeSquared();
+    real b = 2 * offset.dot(motion);
+    if (a <= 0 || b >= 0) { return false; }
+
+    real discriminant = b*b - 4*a*c;
+    if (discriminant < 0) { return false; }
+
+    time = (-b - std::sqrt(discriminant)) / (2*a);
+    return time <= 1;
+}
+
+/*
+ * Finds when a body first touches a mesh during the last step. Its
+ * bounding sphere is swept through the mesh's triangles first, which
+ * rules out most bodies and gives a time the body can't touch the mesh
+ * before. From there the body is advanced towards the triangles near
+ * the rest of the sweep, as timeOfImpact does for two bodies.
+ */
+static bool meshTimeOfImpact(RigidBody* body, const RigidBody* mesh, real& time) {
+    Vector3 motion = getMotion(body);
+    real length = motion.magnitude();
+    if (length <= 0) { return false; }
+
+    BoundingSphere sphere = body->getBoundingSphere();
+    CastQuery query = {sphere.center - motion, motion / length, length, sphere.radius};
+    CastHit sphereHit;
+    if (!SpatialQuery::castBody(mesh, query, sphereHit)) { return false; }
+
+    // Only the triangles around the rest of the sweep can be reached, found in the mesh's space
+    const Matrix4& transform = mesh->getTransformMatrix();
+    Vector3 axes[3] = {Vector3(transform.getColumn(0)), Vector3(transform.getColumn(1)), Vector3(transform.getColumn(2))};
+    Vector3 meshPosition = mesh->getPosition();
+    auto toMesh = [&](const Vector3& point) {
+        Vector3 offset = point - meshPosition;
+        return Vector3(axes[0].dot(offset), axes[1].dot(offset), axes[2].dot(offset));
+    };
+    Vector3 sweepStart = toMesh(query.origin + query.direction * sphereHit.distance), sweepEnd = toMesh(sphere.center);
+    Vector3 reach(sphere.radius, sphere.radius, sphere.radius);
+    Vector3 low = Vector3(std::min(sweepStart.x, sweepEnd.x), std::min(sweepStart.y, sweepEnd.y), std::min(sweepStart.z, sweepEnd.z)) - reach;
+    Vector3 high = Vector3(std::max(sweepStart.x, sweepEnd.x), std::max(sweepStart.y, sweepEnd.y), std::max(sweepStart.z, sweepEnd.z)) + reach;
+    auto model = static_cast<const TriangleMeshModel*>(mesh->getModel());
+
+    Vector3 end = body->getPosition();
+    Quaternion endOrientation = body->getOrientation();
+    Vector3 start = end - motion;
+    Quaternion startOrientation = body->getPreviousOrientation();
+    real rotationBound = getRotationBound(body);
+
+    // The body is inside its bounding sphere, so it can't touch the mesh any sooner
+    real t = sphereHit.distance / length;
+    bool hit = false;
+    for (int iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+        placeBetween(body, start, startOrientation, end, endOrientation, t);
+
+        // Move on by the least time any of the triangles could be reached in
+        real step = REAL_MAX;
+        bool touching = false;
+        model->forEachTriangle(low, high, [&](unsigned int index) {
+            Vector3 triangle[3];
+            model->getTriangle(index, triangle);
+            for (Vector3& corner : triangle) { corner = meshPosition + axes[0] * corner.x + axes[1] * corner.y + axes[2] * corner.z; }
+
+            Vector3 closest1, closest2;
+            real distance = GJK::distanceToTriangle(body, triangle, closest1, closest2);
+            if (distance <= ContinuousCollision::TOLERANCE) {
+                touching = true;
+                return;
+            }
+            real closing = motion.dot((closest2 - closest1).normalized()) + rotationBound;
+            if (closing > 0) { step = std::min(step, distance / closing); }
+        });
+
+        // Bodies touching at the start are left to the normal contacts
+        if (touching) {
+            hit = t > 0;
+            if (hit) { t = std::min((real)1, t + ContinuousCollision::CONTACT_DEPTH / length); }
+            break;
+        }
+        if (step == REAL_MAX) { break; }
+
+        t += step;
+        if (t >= 1) { break; }
+    }
+
+    body->setPosition(end);
+    body->setOrientation(endOrientation);
+
+    time = t;
+    return hit;
+}
+
+bool ContinuousCollision::timeOfImpact(RigidBody *body1, RigidBody *body2, real &time) {
+    // GJK only sees the box around a mesh, which would stop bodies short of it
+    bool mesh1 = body1->getModel()->getType() == RigidBodyModel::TRIANGLE_MESH;
+    bool mesh2 = body2->getModel()->getType() == RigidBodyModel::TRIANGLE_MESH;
+    if (mesh1 && mesh2) { return false; }
+    if (mesh1) { return meshTimeOfImpact(body2, body1, time); }
+    if (mesh2) { return meshTimeOfImpact(body1, body2, time); }
+
+    Vector3 motion1 = getMotion(body1), motion2 = getMotion(body2);
+
+    // Cheaply rule out bodies whose bounding spheres never meet
+    BoundingSphere start1 = body1->getBoundingSphere(), start2 = body2->getBoundingSphere();
+    start1.center -= motion1;
+    start2.center -= motion2;
+    real sphereTime;
+    if (!sweptSpheres(start1, motion1, start2, motion2, sphereTime)) { return false; }
+
+    // Only bodies with continuous collision move; the others stay where they are
+    Vector3 end1 = body1->getPosition(), end2 = body2->getPosition();
+    Quaternion endOrientation1 = body1->getOrientation(), endOrientation2 = body2->getOrientation();
+    Vector3 start1Position = end1 - motion1, start2Position = end2 - motion2;
+    Quaternion startOrientation1 = body1->usesContinuousCollision() ? body1->getPreviousOrientation() : endOrientation1;
+    Quaternion startOrientation2 = body2->usesContinuousCollision() ? body2->getPreviousOrientation() : endOrientation2;
+    real rotationBound = getRotationBound(body1) + getRotationBound(body2);
+
+    real t = 0;
+    bool hit = false;
+    GJK::SimplexCache cache;
+    Vector3 closest1, closest2;
+    placeBetween(body1, start1Position, startOrientation1, end1, endOrientation1, t);
+    placeBetween(body2, start2Position, startOrientation2, end2, endOrientation2, t);
+    real distance = GJK::distance(body1, body2, closest1, closest2, &cache);
+
+    // Bodies touching at the start are left to the normal contacts
+    if (distance > TOLERANCE) {
+        for (int iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+            // No point on either body can close the gap faster than this
+            Vector3 normal = (closest1 - closest2).normalized();
+            real linearClosing = (motion2 - motion1).dot(normal);
+            real closing = linearClosing + rotationBound;
+            if (closing <= 0) { break; }
+
+            t += distance / closing;
+            if (t >= 1) { break; }
+
+            placeBetween(body1, start1Position, startOrientation1, end1, endOrientation1, t);
+            placeBetween(body2, start2Position, startOrientation2, end2, endOrientation2, t);
+            distance = GJK::distance(body1, body2, closest1, closest2, &cache);
+            if (distance <= TOLERANCE) {
+                // Carry on until they overlap a little, so they get a contact
+                if (linearClosing > 0) { t = std::min((real)1, t + (distance + CONTACT_DEPTH) / linearClosing); }
+                hit = true;
+                break;
+            }
+        }
+    }
+
+    body1->setPosition(end1);
+    body1->setOrientation(endOrientation1);
+    body2->setPosition(end2);
+    body2->setOrientation(endOrientation2);
+
+    time = t;
+    return hit;
+}
+
+void ContinuousCollision::moveToTime(RigidBody *body, real time) {
+    if (!body->usesContinuousCollision()) { return; }
+    placeBetween(body, body->getPreviousPosition(), body->getPreviousOrientation(), body->getPosition(), body->getOrientation(), time);
+}
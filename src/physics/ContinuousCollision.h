@@ -0,0 +1,61 @@
+#ifndef PHYSICSENGINE_CONTINUOUSCOLLISION_H
+#define PHYSICSENGINE_CONTINUOUSCOLLISION_H
+
+#include "BVHTree.h"
+
+// Avoid circular dependency
+class RigidBody;
+
+/*
+ * Finds when bodies moving over a step first touch, so fast bodies
+ * can be stopped there instead of passing through each other. Times
+ * are fractions of the step, from 0 at its start to 1 at its end.
+ */
+class ContinuousCollision {
+public:
+    /*
+     * Holds how close conservative advancement brings two bodies
+     * before counting them as touching.
+     */
+    static const real TOLERANCE;
+
+    /*
+     * Holds how far past first touching the impact time is pushed,
+     * so the bodies overlap enough for the narrow phase to find a
+     * contact between them.
+     */
+    static const real CONTACT_DEPTH;
+
+    /*
+     * Finds the first time two spheres touch as they move by motion1 and
+     * motion2 over the step. Returns false if they don't touch during it.
+     * Spheres that start out overlapping touch at time 0.
+     */
+    static bool sweptSpheres(const BoundingSphere& sphere1, const Vector3& motion1, const BoundingSphere& sphere2, const Vector3& motion2, real& time);
+
+    /*
+     * Finds when two bodies first touch during the last step, using
+     * conservative advancement: each iteration moves them forward by as
+     * much time as they can't possibly close their distance in, so it
+     * never steps past the impact. Bodies with continuous collision move
+     * from their previous pose to their current one, and the others are
+     * held at their current pose. Returns false if the bodies were
+     * already touching at the start of the step, as the normal
+     * contacts handle those, or if they don't touch during it. Against
+     * a TriangleMeshModel, the other body is advanced towards the
+     * triangles its bounding sphere sweeps through instead.
+     *
+     * The bodies are moved while searching but are left where they were.
+     */
+    static bool timeOfImpact(RigidBody* body1, RigidBody* body2, real& time);
+
+    /*
+     * Moves a body with continuous collision back to where it was at
+     * the given time in the last step, between its previous pose and its
+     * current one. Its velocity is unchanged.
+     */
+    static void moveToTime(RigidBody* body, real time);
+};
+
+
+#endif //PHYSICSENGINE_CONTINUOUSCOLLISION_H
@@ -0,0 +1,150 @@
+#include "DistanceField.h"
+#include "RigidBodyModel.h"
+#include "CollisionDetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+ * The number of samples along each side of the blocks the grid is baked in.
+ * Every sample in a block is checked against the same list of triangles.
+ */
+static const unsigned int BLOCK_SIZE = 4;
+
+DistanceField::DistanceField(const Shape &shape, real cellSize, real band, ThreadPool &pool)
+        : cellSize(cellSize), band(std::max(band, 2 * cellSize)) {
+    if (shape.numVertices() == 0) {
+        // Nothing to be near, so a single cell of empty space
+        origin = Vector3();
+        countX = countY = countZ = 2;
+        values.assign(8, this->band);
+        return;
+    }
+
+    const Vector3* positions = shape.getVertexPositions();
+    Vector3 min = positions[0], max = positions[0];
+    for (unsigned int i = 1; i < shape.numVertices(); i++) {
+        min = Vector3(std::min(min.x, positions[i].x), std::min(min.y, positions[i].y), std::min(min.z, positions[i].z));
+        max = Vector3(std::max(max.x, positions[i].x), std::max(max.y, positions[i].y), std::max(max.z, positions[i].z));
+    }
+    Vector3 margin(this->band, this->band, this->band);
+    origin = min - margin;
+    Vector3 size = max + margin - origin;
+    countX = std::max(2u, (unsigned int)std::ceil(size.x / cellSize) + 1);
+    countY = std::max(2u, (unsigned int)std::ceil(size.y / cellSize) + 1);
+    countZ = std::max(2u, (unsigned int)std::ceil(size.z / cellSize) + 1);
+
+    // REAL_MAX marks the samples outside the band until they're filled in
+    values.assign((size_t)countX * countY * countZ, REAL_MAX);
+
+    // The mesh model's tree finds the triangles near each block
+    TriangleMeshModel mesh(shape);
+    unsigned int blocksX = (countX + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    unsigned int blocksY = (countY + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    unsigned int blocksZ = (countZ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    real bandSquared = this->band * this->band;
+    real tolerance = cellSize * cellSize * 1e-4;
+
+    pool.parallelFor(blocksX * blocksY * blocksZ, 1, [&](unsigned int begin, unsigned int end) {
+        std::vector<Vector3> triangles;
+        std::vector<Vector3> normals;
+        for (unsigned int block = begin; block < end; block++) {
+            unsigned int first[3] = {(block % blocksX) * BLOCK_SIZE, (block / blocksX % blocksY) * BLOCK_SIZE, (block / (blocksX * blocksY)) * BLOCK_SIZE};
+            unsigned int last[3] = {std::min(first[0] + BLOCK_SIZE, countX), std::min(first[1] + BLOCK_SIZE, countY), std::min(first[2] + BLOCK_SIZE, countZ)};
+            Vector3 blockMin = origin + Vector3(first[0], first[1], first[2]) * cellSize - margin;
+            Vector3 blockMax = origin + Vector3(last[0] - 1, last[1] - 1, last[2] - 1) * cellSize + margin;
+
+            triangles.clear();
+            normals.clear();
+            mesh.forEachTriangle(blockMin, blockMax, [&](unsigned int t) {
+                Vector3 corners[3];
+                mesh.getTriangle(t, corners);
+                Vector3 normal = (corners[1] - corners[0]).cross(corners[2] - corners[0]).normalized();
+                if (normal.isZero()) { return; }
+                triangles.insert(triangles.end(), corners, corners + 3);
+                normals.push_back(normal);
+            });
+            if (normals.empty()) { continue; }
+
+            for (unsigned int z = first[2]; z < last[2]; z++) {
+                for (unsigned int y = first[1]; y < last[1]; y++) {
+                    for (unsigned int x = first[0]; x < last[0]; x++) {
+                        Vector3 point = origin + Vector3(x, y, z) * cellSize;
+                        real bestDistance = bandSquared, bestSide = 0;
+                        for (unsigned int t = 0; t < normals.size(); t++) {
+                            Vector3 offset = point - CollisionDetector::closestOnTriangle(point, triangles[3*t], triangles[3*t + 1], triangles[3*t + 2]);
+                            real distance = offset.magnitudeSquared();
+                            real side = normals[t].dot(offset);
+
+                            // Near an edge several triangles are about as close, and the
+                            // one the point is most squarely in front of has the right side
+                            if (distance < bestDistance - tolerance || (distance <= bestDistance + tolerance && real_abs(side) > real_abs(bestSide))) {
+                                bestDistance = std::min(bestDistance, distance);
+                                bestSide = side;
+                            }
+                        }
+                        if (bestDistance < bandSquared) {
+                            real distance = std::sqrt(bestDistance);
+                            values[x + (size_t)countX * (y + (size_t)countY * z)] = bestSide < 0 ? -distance : distance;
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    fillOutsideBand();
+}
+
+void DistanceField::fillOutsideBand() {
+    std::vector<unsigned int> queue;
+    for (unsigned int i = 0; i < values.size(); i++) {
+        if (values[i] != REAL_MAX) { queue.push_back(i); }
+    }
+    if (queue.empty()) {
+        // No triangle came near any sample, so it's all in front
+        std::fill(values.begin(), values.end(), band);
+        return;
+    }
+
+    // Spread outwards one sample at a time. The band is two cells wide,
+    // so a sample is never next to one on the other side of the surface.
+    unsigned int strideY = countX, strideZ = countX * countY;
+    for (size_t next = 0; next < queue.size(); next++) {
+        unsigned int i = queue[next];
+        unsigned int x = i % countX, y = i / strideY % countY, z = i / strideZ;
+        real value = values[i] < 0 ? -band : band;
+        unsigned int neighbours[6];
+        unsigned int neighbourCount = 0;
+        if (x > 0) { neighbours[neighbourCount++] = i - 1; }
+        if (x + 1 < countX) { neighbours[neighbourCount++] = i + 1; }
+        if (y > 0) { neighbours[neighbourCount++] = i - strideY; }
+        if (y + 1 < countY) { neighbours[neighbourCount++] = i + strideY; }
+        if (z > 0) { neighbours[neighbourCount++] = i - strideZ; }
+        if (z + 1 < countZ) { neighbours[neighbourCount++] = i + strideZ; }
+        for (unsigned int n = 0; n < neighbourCount; n++) {
+            if (values[neighbours[n]] != REAL_MAX) { continue; }
+            values[neighbours[n]] = value;
+            queue.push_back(neighbours[n]);
+        }
+    }
+}
+
+real DistanceField::getBand() const { return band; }
+
+real DistanceField::getCellSize() const { return cellSize; }
+
+SampleGrid DistanceField::getGrid() const {
+    return {values.data(), origin, cellSize, countX, countY, countZ};
+}
+
+real DistanceField::distance(const Vector3 &point, Vector3 &gradient) const {
+    real x = point.x, y = point.y, z = point.z;
+    real result;
+    BatchMath::sampleGrid(getGrid(), Vector3Stream(&x, &y, &z), 1, &result, Vector3Stream(&gradient.x, &gradient.y, &gradient.z));
+    return result;
+}
+
+void DistanceField::sample(Vector3Stream points, unsigned int count, real *distances, Vector3Stream gradients) const {
+    BatchMath::sampleGrid(getGrid(), points, count, distances, gradients);
+}
@@ -0,0 +1,65 @@
+#ifndef PHYSICSENGINE_DISTANCEFIELD_H
+#define PHYSICSENGINE_DISTANCEFIELD_H
+
+#include <vector>
+#include "../math/BatchMath.h"
+#include "../render/Shape.h"
+#include "ThreadPool.h"
+
+/*
+ * The signed distance to a Shape's surface, sampled on a regular grid
+ * of points once, when the field is created, so that later queries are
+ * a lookup and a trilinear blend of the eight samples around a point.
+ * Distances are positive on the side the Shape's triangles face and
+ * negative behind them, so a closed Shape is negative inside.
+ *
+ * Only a narrow band around the surface is measured exactly. Samples
+ * farther away than band just hold +band or -band, which is enough to
+ * tell which side of the surface they are on. The grid covers the
+ * Shape's bounding box grown by band, and points outside the grid are
+ * treated as being on its edge.
+ */
+class DistanceField {
+    std::vector<real> values;
+    Vector3 origin;
+    real cellSize, band;
+    unsigned int countX, countY, countZ;
+
+    /*
+     * Gives the samples no triangle was within band of the sign of
+     * their neighbours, starting from those that were.
+     */
+    void fillOutsideBand();
+
+public:
+    /*
+     * Bakes the field of a Shape with the given spacing between samples,
+     * in parallel on the pool. The band is made at least two cells wide,
+     * so every sample next to the surface is measured.
+     */
+    DistanceField(const Shape& shape, real cellSize, real band, ThreadPool& pool = ThreadPool::shared());
+
+    real getBand() const;
+    real getCellSize() const;
+
+    /*
+     * Returns the samples in the form the BatchMath kernels take.
+     */
+    SampleGrid getGrid() const;
+
+    /*
+     * Returns the distance at a point, writing the direction it grows
+     * fastest in into gradient. Near the surface the gradient has about
+     * unit length and points away from it.
+     */
+    real distance(const Vector3& point, Vector3& gradient) const;
+
+    /*
+     * Finds the distance and gradient at many points at once,
+     * with BatchMath::sampleGrid.
+     */
+    void sample(Vector3Stream points, unsigned int count, real* distances, Vector3Stream gradients) const;
+};
+
+
+#endif //PHYSICSENGINE_DISTANCEFIELD_H
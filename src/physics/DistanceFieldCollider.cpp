@@ -0,0 +1,198 @@
+#include "DistanceFieldCollider.h"
+#include "RigidBody.h"
+#include "CollisionDetector.h"
+
+/*
+ * Holds the most points added for a single body, the corners of a box.
+ */
+static const unsigned int MAX_BODY_POINTS = 8;
+
+/*
+ * Writes the contact for an object touching a field at a point rounded by
+ * radius, given the field's distance and gradient there, if it's deep enough.
+ * Distances of band or more only say the point is outside the band, so they
+ * never make a contact.
+ */
+static unsigned int pointContact(PhysicsObject* object, const Vector3& point, real radius, real distance, const Vector3& gradient, real band, real restitution, unsigned int featureId, PhysicsContact* contact) {
+    real penetration = radius - distance;
+    Vector3 normal = gradient.normalized();
+    if (penetration < 0 || distance >= band || normal.isZero()) { return 0; }
+
+    contact->objects[0] = object;
+    contact->objects[1] = nullptr;
+    contact->contactNormal = normal;
+    contact->contactPoint = point - normal * (radius - penetration / 2);
+    contact->penetration = penetration;
+    contact->restitution = restitution;
+    contact->featureId = featureId;
+    return 1;
+}
+
+void DistanceFieldCollider::add(const Shape &shape, real cellSize, real band, real restitution) {
+    fields.push_back({DistanceField(shape, cellSize, band), restitution});
+}
+
+unsigned int DistanceFieldCollider::getCount() const { return fields.size(); }
+
+void DistanceFieldCollider::addPoint(const Vector3 &point, real radius, unsigned int owner) {
+    pointsX.push_back(point.x); pointsY.push_back(point.y); pointsZ.push_back(point.z);
+    pointRadii.push_back(radius);
+    owners.push_back(owner);
+}
+
+void DistanceFieldCollider::addPoints(const RigidBody *body, unsigned int owner, const Vector3 &gradient) {
+    const Matrix4& transform = body->getTransformMatrix();
+    Vector3 center(transform.getColumn(3));
+    Vector3 axes[3];
+    for (int i = 0; i < 3; i++) { axes[i] = Vector3(transform.getColumn(i)); }
+
+    switch (body->getModel()->getType()) {
+        case RigidBodyModel::CAPSULE: {
+            auto model = static_cast<const CapsuleModel*>(body->getModel());
+            Vector3 halfAxis = axes[1] * model->getHalfHeight();
+            addPoint(center - halfAxis, model->getRadius(), owner);
+            addPoint(center + halfAxis, model->getRadius(), owner);
+            break;
+        }
+        case RigidBodyModel::BOX: {
+            Vector3 half = static_cast<const RectangularPrismModel*>(body->getModel())->getHalfSize();
+            for (unsigned int i = 0; i < 8; i++) {
+                addPoint(center + axes[0] * (i & 1 ? half.x : -half.x) + axes[1] * (i & 2 ? half.y : -half.y) + axes[2] * (i & 4 ? half.z : -half.z), 0, owner);
+            }
+            break;
+        }
+        default: {
+            // The point facing the surface, and those a little to each side
+            // of it, so a body resting on a face touches at its corners
+            Vector3 down = -gradient.normalized();
+            if (down.isZero()) { down = Vector3::DOWN; }
+            Vector3 side1 = down.cross(real_abs(down.x) < 0.6 ? Vector3::RIGHT : Vector3::UP).normalized();
+            Vector3 side2 = down.cross(side1);
+            Vector3 directions[5] = {down, down + side1 * 0.5, down - side1 * 0.5, down + side2 * 0.5, down - side2 * 0.5};
+            Vector3 found[5];
+            unsigned int foundCount = 0;
+            for (const Vector3& direction : directions) {
+                Vector3 local = body->getModel()->getSupportPoint(Vector3(axes[0].dot(direction), axes[1].dot(direction), axes[2].dot(direction)));
+                Vector3 point = center + axes[0] * local.x + axes[1] * local.y + axes[2] * local.z;
+                bool repeated = false;
+                for (unsigned int i = 0; i < foundCount; i++) { repeated = repeated || (found[i] - point).isZero(); }
+                if (repeated) { continue; }
+                found[foundCount++] = point;
+                addPoint(point, 0, owner);
+            }
+            break;
+        }
+    }
+}
+
+unsigned int DistanceFieldCollider::addPointContacts(unsigned int begin, unsigned int end, real band, real restitution, PhysicsContact *contact, unsigned int limit) const {
+    PhysicsObject* object = objects[owners[begin]];
+    Vector3 points[MAX_BODY_POINTS];
+    real depths[MAX_BODY_POINTS];
+    unsigned int features[MAX_BODY_POINTS];
+    unsigned int count = 0, deepest = 0;
+    for (unsigned int i = begin; i < end; i++) {
+        real depth = pointRadii[i] - pointDistances[i];
+        if (depth < 0) { continue; }
+        points[count] = Vector3(pointsX[i], pointsY[i], pointsZ[i]);
+        depths[count] = depth;
+        features[count] = i;
+        if (depth > depths[deepest]) { deepest = count; }
+        count++;
+    }
+    if (count == 0) { return 0; }
+
+    unsigned int chosen[MAX_BODY_POINTS];
+    unsigned int chosenCount = count;
+    if (count > CollisionDetector::MAX_MANIFOLD_POINTS) {
+        unsigned int i = features[deepest];
+        Vector3 normal = Vector3(pointGradientsX[i], pointGradientsY[i], pointGradientsZ[i]).normalized();
+        chosenCount = CollisionDetector::reduceManifold(points, depths, count, normal, chosen);
+    } else {
+        for (unsigned int c = 0; c < count; c++) { chosen[c] = c; }
+    }
+
+    unsigned int used = 0;
+    for (unsigned int c = 0; c < chosenCount && used < limit; c++) {
+        unsigned int i = features[chosen[c]];
+        Vector3 gradient(pointGradientsX[i], pointGradientsY[i], pointGradientsZ[i]);
+        used += pointContact(object, points[chosen[c]], pointRadii[i], pointDistances[i], gradient, band, restitution, i - begin + 1, contact + used);
+    }
+    return used;
+}
+
+unsigned int DistanceFieldCollider::addContacts(const std::vector<Particle*> &particles, const std::vector<RigidBody*> &bodies, PhysicsContact *contact, unsigned int limit) {
+    if (fields.empty() || limit == 0) { return 0; }
+
+    // Gather the objects' bounding spheres into arrays for the kernel
+    objects.resize(particles.size() + bodies.size());
+    centersX.resize(objects.size()); centersY.resize(objects.size()); centersZ.resize(objects.size());
+    radii.resize(objects.size());
+    distances.resize(objects.size());
+    gradientsX.resize(objects.size()); gradientsY.resize(objects.size()); gradientsZ.resize(objects.size());
+
+    unsigned int count = 0;
+    for (Particle* particle : particles) {
+        if (!particle->hasFiniteMass()) { continue; }
+        Vector3 center = particle->getPosition();
+        objects[count] = particle;
+        centersX[count] = center.x; centersY[count] = center.y; centersZ[count] = center.z;
+        radii[count] = Particle::RADIUS;
+        count++;
+    }
+    unsigned int particleCount = count;
+    for (RigidBody* body : bodies) {
+        if (!body->hasFiniteMass()) { continue; }
+        BoundingSphere sphere = body->getBoundingSphere();
+        objects[count] = body;
+        centersX[count] = sphere.center.x; centersY[count] = sphere.center.y; centersZ[count] = sphere.center.z;
+        radii[count] = sphere.radius;
+        count++;
+    }
+
+    unsigned int used = 0;
+    Vector3Stream centers(centersX.data(), centersY.data(), centersZ.data());
+    Vector3Stream gradients(gradientsX.data(), gradientsY.data(), gradientsZ.data());
+    for (const Field& f : fields) {
+        f.field.sample(centers, count, distances.data(), gradients);
+
+        // Blending the samples can overestimate the distance by up to about a cell
+        real margin = f.field.getCellSize();
+        pointsX.clear(); pointsY.clear(); pointsZ.clear();
+        pointRadii.clear();
+        owners.clear();
+        for (unsigned int n = 0; n < count && used < limit; n++) {
+            if (distances[n] > radii[n] + margin) { continue; }
+            Vector3 center(centersX[n], centersY[n], centersZ[n]);
+            Vector3 gradient(gradientsX[n], gradientsY[n], gradientsZ[n]);
+            if (n < particleCount) {
+                used += pointContact(objects[n], center, radii[n], distances[n], gradient, f.field.getBand(), f.restitution, 0, contact + used);
+                continue;
+            }
+            auto body = static_cast<RigidBody*>(objects[n]);
+            if (body->getModel()->getType() == RigidBodyModel::SPHERE) {
+                real radius = static_cast<const SphereModel*>(body->getModel())->getRadius();
+                used += pointContact(body, body->getPosition(), radius, distances[n], gradient, f.field.getBand(), f.restitution, 0, contact + used);
+            } else {
+                addPoints(body, n, gradient);
+            }
+        }
+        if (used == limit) { break; }
+        if (owners.empty()) { continue; }
+
+        // Then every other body's points in a second batch
+        unsigned int pointCount = owners.size();
+        pointDistances.resize(pointCount);
+        pointGradientsX.resize(pointCount); pointGradientsY.resize(pointCount); pointGradientsZ.resize(pointCount);
+        f.field.sample(Vector3Stream(pointsX.data(), pointsY.data(), pointsZ.data()), pointCount, pointDistances.data(),
+                       Vector3Stream(pointGradientsX.data(), pointGradientsY.data(), pointGradientsZ.data()));
+        for (unsigned int begin = 0; begin < pointCount && used < limit;) {
+            unsigned int end = begin + 1;
+            while (end < pointCount && owners[end] == owners[begin]) { end++; }
+            used += addPointContacts(begin, end, f.field.getBand(), f.restitution, contact + used, limit - used);
+            begin = end;
+        }
+        if (used == limit) { break; }
+    }
+    return used;
+}
@@ -0,0 +1,83 @@
+#ifndef PHYSICSENGINE_DISTANCEFIELDCOLLIDER_H
+#define PHYSICSENGINE_DISTANCEFIELDCOLLIDER_H
+
+#include <vector>
+#include "PhysicsContact.h"
+#include "DistanceField.h"
+
+// Avoid circular dependency
+class RigidBody;
+
+/*
+ * Collides every body and Particle in a world against fixed scenery
+ * described by DistanceFields, like terrain or the inside of a level,
+ * which would be too many triangles to test one at a time.
+ *
+ * Each step, the objects' bounding sphere centers are gathered into
+ * arrays and sampled from each field with one batch query. A Particle
+ * or a sphere gets its contact straight from that sample. Other bodies
+ * close enough to the surface then have their corner points sampled in
+ * a second batch: both ends of a capsule, the eight corners of a box,
+ * and a few support points facing the surface for any other model.
+ * Those deeper than the surface become that body's contacts.
+ */
+class DistanceFieldCollider {
+    struct Field {
+        DistanceField field;
+        real restitution;
+    };
+
+    std::vector<Field> fields;
+
+    /*
+     * The objects being tested this step, with the Particles first, and
+     * their bounding spheres as arrays. Kept between steps to reuse their memory.
+     */
+    std::vector<PhysicsObject*> objects;
+    std::vector<real> centersX, centersY, centersZ, radii;
+    std::vector<real> distances, gradientsX, gradientsY, gradientsZ;
+
+    /*
+     * The points sampled in the second batch, each of which is
+     * rounded by its radius. The points of a body are next to each
+     * other, and owners holds the index of the body in objects.
+     */
+    std::vector<real> pointsX, pointsY, pointsZ, pointRadii;
+    std::vector<unsigned int> owners;
+    std::vector<real> pointDistances, pointGradientsX, pointGradientsY, pointGradientsZ;
+
+    /*
+     * Appends the points of a body to test against a field, given the
+     * direction the field grows in at the body's center.
+     */
+    void addPoints(const RigidBody* body, unsigned int owner, const Vector3& gradient);
+
+    void addPoint(const Vector3& point, real radius, unsigned int owner);
+
+    /*
+     * Writes the contacts for the points from begin to end, which all
+     * belong to the same object, keeping the ones that best cover them.
+     */
+    unsigned int addPointContacts(unsigned int begin, unsigned int end, real band, real restitution, PhysicsContact* contact, unsigned int limit) const;
+
+public:
+    /*
+     * Bakes the DistanceField of a Shape, in world space, and adds it.
+     * See DistanceField for cellSize and band. Contacts are only found
+     * within the band, so it should be wider than the largest sphere or
+     * capsule radius, and the deepest any object may sink.
+     */
+    void add(const Shape& shape, real cellSize, real band, real restitution);
+
+    unsigned int getCount() const;
+
+    /*
+     * Writes the contacts between the objects and every field,
+     * like ContactGenerator::addContact. Objects with infinite mass
+     * are skipped, since they can't be pushed out.
+     */
+    unsigned int addContacts(const std::vector<Particle*>& particles, const std::vector<RigidBody*>& bodies, PhysicsContact* contact, unsigned int limit);
+};
+
+
+#endif //PHYSICSENGINE_DISTANCEFIELDCOLLIDER_H
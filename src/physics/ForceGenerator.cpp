@@ -26,7 +26,8 @@ void DragForce::updateForce(PhysicsObject* object, real deltaTime) {
 real SpringForce::SPRING_DAMPING = 0.75f;
 
 SpringForce::SpringForce(PhysicsObject *objectAnchor1, Vector3 connectionPoint1, PhysicsObject *objectAnchor2, Vector3 connectionPoint2,real k, real restLength, bool shouldPush)
-        : objects{objectAnchor1, objectAnchor2}, connectionPoints{connectionPoint1, connectionPoint2}, k(k), restLength(restLength), shouldPush(shouldPush) {}
+        : objects{objectAnchor1, objectAnchor2}, connectionPoints{connectionPoint1, connectionPoint2}, k(k), restLength(restLength), shouldPush(shouldPush),
+          shape(Shape::cylinder(Vector3(), Vector3::UP, 1, C_BLACK, 6, false)) {}
 
 void SpringForce::updateForce(PhysicsObject *object, real deltaTime) {
     Vector3 connectionPos;
@@ -56,8 +57,12 @@ void SpringForce::updateForce(PhysicsObject *object, real deltaTime) {
 
 }
 
-Shape SpringForce::getShape() const {
-    return Shape::cylinder(objects[0]->getPointInWorldSpace(connectionPoints[0]), objects[1]->getPointInWorldSpace(connectionPoints[1]), 0.1, C_BLACK, 6, false);
+const Shape& SpringForce::getShape() const {
+    return shape;
+}
+
+Matrix4 SpringForce::getShapeMatrix() const {
+    return Shape::cylinderTransform(objects[0]->getPointInWorldSpace(connectionPoints[0]), objects[1]->getPointInWorldSpace(connectionPoints[1]), 0.1);
 }
 
 GravitationalAttractionForce::GravitationalAttractionForce(PhysicsObject *srcObject, real gravitationalConstant) : srcObject(srcObject), g(gravitationalConstant) {}
@@ -67,6 +67,9 @@ private:
     /* Whether the spring will exert pushing forces, or just pulls */
     bool shouldPush;
 
+    /* A unit cylinder, stretched between the connection points when drawn */
+    Shape shape;
+
 public:
     static float SPRING_DAMPING;
 
@@ -75,7 +78,8 @@ public:
 
     void updateForce(PhysicsObject* object, real deltaTime) override;
 
-    Shape getShape() const override;
+    const Shape& getShape() const override;
+    Matrix4 getShapeMatrix() const override;
 
 };
 
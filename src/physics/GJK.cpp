@@ -0,0 +1,618 @@
+#include "GJK.h"
+#include "RigidBody.h"
+
+static const int MAX_ITERATIONS = 32;
+static const unsigned int EPA_MAX_VERTICES = 64;
+static const unsigned int EPA_MAX_FACES = 2 * EPA_MAX_VERTICES;
+static const int EPA_MAX_ITERATIONS = EPA_MAX_VERTICES - 4;
+
+// Simplexes closer to the origin than this are treated as touching it
+static const real TOUCHING_DISTANCE = (real)1e-4;
+// Stop once an iteration moves less than this fraction of the distance
+static const real RELATIVE_TOLERANCE = (real)1e-4;
+static const real EPA_TOLERANCE = (real)1e-4;
+
+/*
+ * How many steps a cast takes towards a body before giving up, and
+ * how close it has to get to count as a hit
+ */
+static const int MAX_CAST_ITERATIONS = 32;
+static const real CAST_TOLERANCE = (real)1e-3;
+
+/*
+ * A RigidBody's model placed in the world
+ */
+struct ConvexBody {
+    const RigidBodyModel* model;
+    Vector3 position;
+    Vector3 axes[3];
+    real margin;
+
+    /*
+     * The world-space points whose hull is the core, when there is no model
+     */
+    const Vector3* points = nullptr;
+    unsigned int pointCount = 0;
+
+    explicit ConvexBody(const RigidBody* body) : model(body->getModel()), margin(body->getModel()->getMargin()) {
+        const Matrix4& transform = body->getTransformMatrix();
+        position = Vector3(transform.getColumn(3));
+        for (int i = 0; i < 3; i++) { axes[i] = Vector3(transform.getColumn(i)); }
+    }
+
+    /*
+     * A sphere, whose core is just its center
+     */
+    ConvexBody(const Vector3& center, real radius) : model(nullptr), position(center), axes{Vector3(1,0,0), Vector3(0,1,0), Vector3(0,0,1)}, margin(radius) {}
+
+    /*
+     * The hull of a few points, like a triangle, with no margin
+     */
+    ConvexBody(const Vector3* points, unsigned int count) : ConvexBody(Vector3(), 0) {
+        this->points = points;
+        pointCount = count;
+    }
+
+    Vector3 directionToBody(const Vector3& direction) const {
+        return Vector3(axes[0].dot(direction), axes[1].dot(direction), axes[2].dot(direction));
+    }
+
+    Vector3 directionToWorld(const Vector3& direction) const {
+        return axes[0] * direction.x + axes[1] * direction.y + axes[2] * direction.z;
+    }
+
+    Vector3 support(const Vector3& direction, bool core) const {
+        Vector3 local = directionToBody(direction);
+        Vector3 point;
+        if (model) { point = model->getCoreSupportPoint(local); }
+        else if (pointCount > 0) {
+            point = points[0];
+            for (unsigned int i = 1; i < pointCount; i++) {
+                if (points[i].dot(local) > point.dot(local)) { point = points[i]; }
+            }
+        }
+        if (!core) { point += local.normalized() * margin; }
+        return position + directionToWorld(point);
+    }
+};
+
+/*
+ * A point on the Minkowski difference, along with the points on
+ * each body it came from and the direction it was found in
+ */
+struct SupportPoint {
+    Vector3 point, on1, on2, direction;
+};
+
+/*
+ * The Minkowski difference of two bodies, or of their cores
+ */
+struct ConvexPair {
+    const ConvexBody &body1, &body2;
+    bool core;
+
+    SupportPoint support(const Vector3& direction) const {
+        SupportPoint s;
+        s.direction = direction;
+        s.on1 = body1.support(direction, core);
+        s.on2 = body2.support(-direction, core);
+        s.point = s.on1 - s.on2;
+        return s;
+    }
+};
+
+struct Simplex {
+    SupportPoint vertices[4];
+    real weights[4];
+    unsigned int count;
+
+    void set(const SupportPoint& a) {
+        vertices[0] = a; weights[0] = 1; count = 1;
+    }
+    void set(const SupportPoint& a, const SupportPoint& b, real u, real v) {
+        vertices[0] = a; vertices[1] = b; weights[0] = u; weights[1] = v; count = 2;
+    }
+    void set(const SupportPoint& a, const SupportPoint& b, const SupportPoint& c, real u, real v, real w) {
+        vertices[0] = a; vertices[1] = b; vertices[2] = c; weights[0] = u; weights[1] = v; weights[2] = w; count = 3;
+    }
+
+    /*
+     * Returns the points on each body matching the weighted point on the simplex.
+     */
+    void getClosestPoints(Vector3& on1, Vector3& on2) const {
+        on1 = Vector3(); on2 = Vector3();
+        for (unsigned int i = 0; i < count; i++) {
+            on1 += vertices[i].on1 * weights[i];
+            on2 += vertices[i].on2 * weights[i];
+        }
+    }
+};
+
+/*
+ * Each of these finds the point of a simplex closest to the origin, and
+ * writes the smallest part of the simplex containing it into out.
+ */
+static Vector3 closestOnSegment(const SupportPoint& a, const SupportPoint& b, Simplex& out) {
+    Vector3 ab = b.point - a.point;
+    real t = -a.point.dot(ab), length = ab.magnitudeSquared();
+    if (t <= 0 || length <= 0) { out.set(a); return a.point; }
+    if (t >= length) { out.set(b); return b.point; }
+    t /= length;
+    out.set(a, b, 1 - t, t);
+    return a.point + ab * t;
+}
+
+static Vector3 closestOnTriangle(const SupportPoint& a, const SupportPoint& b, const SupportPoint& c, Simplex& out) {
+    // Find which of the triangle's vertex, edge or face regions the origin is in
+    Vector3 ab = b.point - a.point, ac = c.point - a.point;
+    real d1 = -ab.dot(a.point), d2 = -ac.dot(a.point);
+    if (d1 <= 0 && d2 <= 0) { out.set(a); return a.point; }
+
+    real d3 = -ab.dot(b.point), d4 = -ac.dot(b.point);
+    if (d3 >= 0 && d4 <= d3) { out.set(b); return b.point; }
+
+    real vc = d1*d4 - d3*d2;
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        real t = d1 / (d1 - d3);
+        out.set(a, b, 1 - t, t);
+        return a.point + ab * t;
+    }
+
+    real d5 = -ab.dot(c.point), d6 = -ac.dot(c.point);
+    if (d6 >= 0 && d5 <= d6) { out.set(c); return c.point; }
+
+    real vb = d5*d2 - d1*d6;
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        real t = d2 / (d2 - d6);
+        out.set(a, c, 1 - t, t);
+        return a.point + ac * t;
+    }
+
+    real va = d3*d6 - d5*d4;
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+        real t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        out.set(b, c, 1 - t, t);
+        return b.point + (c.point - b.point) * t;
+    }
+
+    real denominator = va + vb + vc;
+    if (denominator <= 0) { return closestOnSegment(a, b, out); }
+    real v = vb / denominator, w = vc / denominator;
+    out.set(a, b, c, 1 - v - w, v, w);
+    return a.point + ab * v + ac * w;
+}
+
+static Vector3 closestOnTetrahedron(const Simplex& simplex, Simplex& out) {
+    static const int faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+
+    Vector3 closest;
+    real bestDistance = REAL_MAX;
+    bool inside = true;
+    for (const int* face : faces) {
+        const SupportPoint &a = simplex.vertices[face[0]], &b = simplex.vertices[face[1]], &c = simplex.vertices[face[2]];
+        Vector3 normal = (b.point - a.point).cross(c.point - a.point);
+        real originSide = -normal.dot(a.point);
+        real oppositeSide = normal.dot(simplex.vertices[face[3]].point - a.point);
+
+        // The origin is outside if it's on the other side of any face from the opposite
+        // vertex. Every face is still checked for the closest point, since in a nearly flat
+        // tetrahedron rounding can put the origin on the wrong side of the closest face
+        if (originSide * oppositeSide <= 0) { inside = false; }
+
+        Simplex candidate;
+        Vector3 point = closestOnTriangle(a, b, c, candidate);
+        if (point.magnitudeSquared() < bestDistance) {
+            bestDistance = point.magnitudeSquared();
+            closest = point;
+            out = candidate;
+        }
+    }
+
+    if (inside) {
+        out = simplex;
+        return Vector3();
+    }
+    return closest;
+}
+
+static Vector3 closestOnSimplex(Simplex& simplex) {
+    Simplex reduced;
+    Vector3 closest;
+    switch (simplex.count) {
+        case 1: reduced.set(simplex.vertices[0]); closest = simplex.vertices[0].point; break;
+        case 2: closest = closestOnSegment(simplex.vertices[0], simplex.vertices[1], reduced); break;
+        case 3: closest = closestOnTriangle(simplex.vertices[0], simplex.vertices[1], simplex.vertices[2], reduced); break;
+        default: closest = closestOnTetrahedron(simplex, reduced); break;
+    }
+    simplex = reduced;
+    return closest;
+}
+
+/*
+ * Runs GJK from the given simplex, leaving it holding the part of the
+ * difference closest to the origin, and that point in closest. Returns
+ * whether the difference touches the origin.
+ */
+static bool runGJK(const ConvexPair& pair, Simplex& simplex, Vector3& closest) {
+    real lastDistanceSquared = REAL_MAX;
+    for (int iteration = 0; iteration < MAX_ITERATIONS; iteration++) {
+        closest = closestOnSimplex(simplex);
+        real distanceSquared = closest.magnitudeSquared();
+        if (simplex.count == 4 || distanceSquared < TOUCHING_DISTANCE*TOUCHING_DISTANCE) { return true; }
+
+        // Close to the surface, rounding can keep the relative test below from ever
+        // passing, but it also stops the distance from shrinking
+        if (distanceSquared >= lastDistanceSquared) { return false; }
+        lastDistanceSquared = distanceSquared;
+
+        // Stop when the farthest point towards the origin gets no closer to it
+        SupportPoint next = pair.support(-closest);
+        if (distanceSquared - closest.dot(next.point) <= RELATIVE_TOLERANCE * distanceSquared) { return false; }
+
+        simplex.vertices[simplex.count] = next;
+        simplex.weights[simplex.count++] = 0;
+    }
+    return false;
+}
+
+/*
+ * Fills a simplex with the difference's points in the cached directions, or
+ * with a single point if there aren't any.
+ */
+static void startSimplex(const ConvexPair& pair, const GJK::SimplexCache* cache, Simplex& simplex) {
+    simplex.count = 0;
+    if (cache) {
+        for (unsigned int i = 0; i < cache->count; i++) {
+            simplex.vertices[simplex.count] = pair.support(pair.body1.directionToWorld(cache->directions[i]));
+            simplex.weights[simplex.count++] = 0;
+        }
+    }
+    if (simplex.count == 0) {
+        Vector3 direction = pair.body1.position - pair.body2.position;
+        simplex.set(pair.support(direction.isZero() ? Vector3::UP : direction));
+    }
+}
+
+static void saveSimplex(const ConvexPair& pair, const Simplex& simplex, GJK::SimplexCache* cache) {
+    if (!cache) { return; }
+    cache->count = simplex.count;
+    for (unsigned int i = 0; i < simplex.count; i++) {
+        cache->directions[i] = pair.body1.directionToBody(simplex.vertices[i].direction);
+    }
+}
+
+/*
+ * Returns whether the full bodies are apart along an axis pointing
+ * from the second body to the first.
+ */
+static bool separatedAlong(const ConvexPair& full, const Vector3& axis) {
+    return full.support(-axis).point.dot(axis) > 0;
+}
+
+static void saveSeparatingAxis(const ConvexPair& pair, const Vector3& axis, GJK::SimplexCache* cache) {
+    if (cache) { cache->separatingAxis = pair.body1.directionToBody(axis); }
+}
+
+struct PolytopeFace {
+    unsigned int vertices[3];
+    Vector3 normal;
+    real distance;
+};
+
+static PolytopeFace makeFace(const SupportPoint* vertices, unsigned int a, unsigned int b, unsigned int c) {
+    Vector3 normal = (vertices[b].point - vertices[a].point).cross(vertices[c].point - vertices[a].point);
+    // A sliver can't be the closest face, but still has to stay in the polytope
+    PolytopeFace face = {{a, b, c}, normal, REAL_MAX};
+    if (!normal.isZero()) {
+        face.normal.normalize();
+        face.distance = face.normal.dot(vertices[a].point);
+    }
+    return face;
+}
+
+/*
+ * Grows a simplex that touches the origin into a tetrahedron, by adding
+ * points in directions away from it. Returns false if the difference is flat.
+ */
+static bool makeTetrahedron(const ConvexPair& pair, Simplex& simplex) {
+    static const Vector3 axes[6] = {Vector3(1,0,0), Vector3(-1,0,0), Vector3(0,1,0), Vector3(0,-1,0), Vector3(0,0,1), Vector3(0,0,-1)};
+
+    if (simplex.count == 1) {
+        for (const Vector3& axis : axes) {
+            SupportPoint next = pair.support(axis);
+            if ((next.point - simplex.vertices[0].point).magnitudeSquared() > TOUCHING_DISTANCE*TOUCHING_DISTANCE) {
+                simplex.vertices[simplex.count++] = next;
+                break;
+            }
+        }
+    }
+
+    if (simplex.count == 2) {
+        Vector3 line = simplex.vertices[1].point - simplex.vertices[0].point;
+        for (const Vector3& axis : axes) {
+            Vector3 direction = line.cross(axis);
+            if (direction.isZero()) { continue; }
+            SupportPoint next = pair.support(direction);
+            if (line.cross(next.point - simplex.vertices[0].point).magnitudeSquared() > TOUCHING_DISTANCE*TOUCHING_DISTANCE * line.magnitudeSquared()) {
+                simplex.vertices[simplex.count++] = next;
+                break;
+            }
+        }
+    }
+
+    if (simplex.count == 3) {
+        Vector3 normal = (simplex.vertices[1].point - simplex.vertices[0].point).cross(simplex.vertices[2].point - simplex.vertices[0].point);
+        if (normal.isZero()) { return false; }
+        normal.normalize();
+        for (real side = 1; side >= -1; side -= 2) {
+            SupportPoint next = pair.support(normal * side);
+            if (real_abs(normal.dot(next.point - simplex.vertices[0].point)) > TOUCHING_DISTANCE) {
+                simplex.vertices[simplex.count++] = next;
+                break;
+            }
+        }
+    }
+
+    return simplex.count == 4;
+}
+
+/*
+ * Expands a tetrahedron around the origin out to the surface of the
+ * difference, finding the direction it is closest to the surface in.
+ * Returns false if the tetrahedron couldn't be built.
+ */
+static bool runEPA(const ConvexPair& pair, Simplex& simplex, Vector3& normal, real& depth, Vector3& on1, Vector3& on2) {
+    if (!makeTetrahedron(pair, simplex)) { return false; }
+
+    SupportPoint vertices[EPA_MAX_VERTICES];
+    PolytopeFace faces[EPA_MAX_FACES];
+    unsigned int vertexCount = 4, faceCount = 0;
+    for (unsigned int i = 0; i < 4; i++) { vertices[i] = simplex.vertices[i]; }
+
+    // Wind every face of the tetrahedron so its normal points away from the opposite vertex
+    static const unsigned int tetrahedron[4][4] = {{0, 1, 2, 3}, {0, 3, 1, 2}, {0, 2, 3, 1}, {1, 3, 2, 0}};
+    for (const unsigned int* f : tetrahedron) {
+        PolytopeFace face = makeFace(vertices, f[0], f[1], f[2]);
+        if ((vertices[f[3]].point - vertices[f[0]].point).dot(face.normal) > 0) { face = makeFace(vertices, f[0], f[2], f[1]); }
+        faces[faceCount++] = face;
+    }
+
+    unsigned int closest = 0;
+    for (int iteration = 0; iteration < EPA_MAX_ITERATIONS; iteration++) {
+        closest = 0;
+        for (unsigned int i = 1; i < faceCount; i++) {
+            if (faces[i].distance < faces[closest].distance) { closest = i; }
+        }
+        if (faces[closest].distance == REAL_MAX) { return false; }
+
+        // Stop once the surface is no farther out than the closest face
+        SupportPoint next = pair.support(faces[closest].normal);
+        if (next.point.dot(faces[closest].normal) - faces[closest].distance < EPA_TOLERANCE) { break; }
+        if (vertexCount == EPA_MAX_VERTICES) { break; }
+        unsigned int added = vertexCount;
+        vertices[vertexCount++] = next;
+
+        // Remove the faces the new point can see, keeping the edges around the hole they leave
+        unsigned int edges[EPA_MAX_FACES][2];
+        unsigned int edgeCount = 0;
+        for (unsigned int i = 0; i < faceCount;) {
+            const PolytopeFace& face = faces[i];
+            if (face.normal.dot(next.point - vertices[face.vertices[0]].point) <= 0) { i++; continue; }
+
+            for (int e = 0; e < 3; e++) {
+                unsigned int from = face.vertices[e], to = face.vertices[(e + 1) % 3];
+                // An edge shared with another removed face runs the other way there, and isn't on the hole
+                bool shared = false;
+                for (unsigned int j = 0; j < edgeCount; j++) {
+                    if (edges[j][0] == to && edges[j][1] == from) {
+                        edges[j][0] = edges[edgeCount - 1][0];
+                        edges[j][1] = edges[edgeCount - 1][1];
+                        edgeCount--;
+                        shared = true;
+                        break;
+                    }
+                }
+                if (!shared && edgeCount < EPA_MAX_FACES) {
+                    edges[edgeCount][0] = from;
+                    edges[edgeCount++][1] = to;
+                }
+            }
+            faces[i] = faces[--faceCount];
+        }
+
+        // Fill the hole with faces fanning out from the new point
+        if (faceCount + edgeCount > EPA_MAX_FACES) { break; }
+        for (unsigned int i = 0; i < edgeCount; i++) {
+            faces[faceCount++] = makeFace(vertices, edges[i][0], edges[i][1], added);
+        }
+        if (faceCount == 0) { return false; }
+    }
+
+    // Find where the origin's projection onto the closest face lands on each body
+    closest = 0;
+    for (unsigned int i = 1; i < faceCount; i++) {
+        if (faces[i].distance < faces[closest].distance) { closest = i; }
+    }
+    const PolytopeFace& face = faces[closest];
+    const SupportPoint &a = vertices[face.vertices[0]], &b = vertices[face.vertices[1]], &c = vertices[face.vertices[2]];
+    Vector3 projection = face.normal * face.distance;
+    Vector3 ab = b.point - a.point, ac = c.point - a.point, ap = projection - a.point;
+    real d00 = ab.dot(ab), d01 = ab.dot(ac), d11 = ac.dot(ac), d20 = ap.dot(ab), d21 = ap.dot(ac);
+    real denominator = d00*d11 - d01*d01;
+    real v = 0, w = 0;
+    if (denominator > 0) {
+        v = (d11*d20 - d01*d21) / denominator;
+        w = (d00*d21 - d01*d20) / denominator;
+    }
+    real u = 1 - v - w;
+
+    normal = face.normal;
+    depth = face.distance;
+    on1 = a.on1 * u + b.on1 * v + c.on1 * w;
+    on2 = a.on2 * u + b.on2 * v + c.on2 * w;
+    return true;
+}
+
+/*
+ * Finds the distance between two convex bodies, like GJK::distance
+ */
+static real distanceConvex(const ConvexBody& convex1, const ConvexBody& convex2, Vector3& closest1, Vector3& closest2, GJK::SimplexCache* cache) {
+    ConvexPair cores = {convex1, convex2, true};
+
+    Simplex simplex;
+    Vector3 closest;
+    startSimplex(cores, cache, simplex);
+    bool touching = runGJK(cores, simplex, closest);
+    saveSimplex(cores, simplex, cache);
+    saveSeparatingAxis(cores, Vector3(), cache);
+    if (touching) { return 0; }
+
+    real coreDistance = closest.magnitude();
+    real distance = coreDistance - convex1.margin - convex2.margin;
+    if (distance <= 0) { return 0; }
+
+    Vector3 normal = closest / coreDistance;
+    saveSeparatingAxis(cores, normal, cache);
+    simplex.getClosestPoints(closest1, closest2);
+    closest1 -= normal * convex1.margin;
+    closest2 += normal * convex2.margin;
+    return distance;
+}
+
+real GJK::distance(const RigidBody *body1, const RigidBody *body2, Vector3 &closest1, Vector3 &closest2, SimplexCache *cache) {
+    return distanceConvex(ConvexBody(body1), ConvexBody(body2), closest1, closest2, cache);
+}
+
+real GJK::distanceToTriangle(const RigidBody *body, const Vector3 *triangle, Vector3 &closest1, Vector3 &closest2) {
+    return distanceConvex(ConvexBody(body), ConvexBody(triangle, 3), closest1, closest2, nullptr);
+}
+
+/*
+ * Finds the deepest point of contact between two convex bodies, with the
+ * normal pointing from the second to the first. Returns false if they
+ * don't touch.
+ */
+static bool collideConvex(const ConvexBody& convex1, const ConvexBody& convex2, GJK::SimplexCache* cache, Vector3& normal, Vector3& point, real& penetration) {
+    ConvexPair cores = {convex1, convex2, true};
+    ConvexPair full = {convex1, convex2, false};
+    real margin = convex1.margin + convex2.margin;
+
+    // Bodies that were apart last time are usually still apart the same way
+    if (cache && !cache->separatingAxis.isZero() && separatedAlong(full, convex1.directionToWorld(cache->separatingAxis))) { return false; }
+
+    Simplex simplex;
+    Vector3 closest;
+    startSimplex(cores, cache, simplex);
+    bool touching = runGJK(cores, simplex, closest);
+    saveSimplex(cores, simplex, cache);
+    saveSeparatingAxis(cores, Vector3(), cache);
+
+    if (!touching) {
+        // The cores are apart, so the bodies touch if their margins overlap
+        real coreDistance = closest.magnitude();
+        if (coreDistance > margin) {
+            saveSeparatingAxis(cores, closest / coreDistance, cache);
+            return false;
+        }
+
+        Vector3 closest1, closest2;
+        simplex.getClosestPoints(closest1, closest2);
+        normal = closest / coreDistance;
+        penetration = margin - coreDistance;
+        point = (closest1 - normal * convex1.margin + closest2 + normal * convex2.margin) * (real)0.5;
+    } else {
+        // The cores overlap, so find how far apart the full models must move
+        if (margin > 0) {
+            Simplex coreSimplex = simplex;
+            simplex.count = 0;
+            for (unsigned int i = 0; i < coreSimplex.count; i++) { simplex.vertices[simplex.count++] = full.support(coreSimplex.vertices[i].direction); }
+            if (!runGJK(full, simplex, closest)) { return false; }
+        }
+
+        Vector3 polytopeNormal, on1, on2;
+        if (!runEPA(full, simplex, polytopeNormal, penetration, on1, on2)) { return false; }
+
+        // The first body has to move against the face of the difference it's closest to
+        normal = -polytopeNormal;
+        point = (on1 + on2) * (real)0.5;
+    }
+    return true;
+}
+
+unsigned int GJK::collide(RigidBody *body1, RigidBody *body2, real restitution, PhysicsContact *contact, unsigned int limit, SimplexCache *cache) {
+    if (limit == 0) { return 0; }
+
+    ConvexBody convex1(body1), convex2(body2);
+    Vector3 normal, point;
+    real penetration;
+    if (!collideConvex(convex1, convex2, cache, normal, point, penetration)) { return 0; }
+
+    contact->objects[0] = body1;
+    contact->objects[1] = body2;
+    contact->contactNormal = normal;
+    contact->contactPoint = point;
+    contact->featureId = 0;
+    contact->penetration = penetration;
+    contact->restitution = restitution;
+    return 1;
+}
+
+bool GJK::collideTriangle(const RigidBody *body, const Vector3 *triangle, Vector3 &normal, Vector3 &point, real &penetration) {
+    ConvexBody convex(body), flat(triangle, 3);
+    return collideConvex(convex, flat, nullptr, normal, point, penetration);
+}
+
+bool GJK::isSeparated(const RigidBody *body1, const RigidBody *body2, const SimplexCache &cache) {
+    if (cache.separatingAxis.isZero()) { return false; }
+
+    ConvexBody convex1(body1), convex2(body2);
+    ConvexPair full = {convex1, convex2, false};
+    return separatedAlong(full, convex1.directionToWorld(cache.separatingAxis));
+}
+
+/*
+ * Sweeps a sphere against a convex body, like GJK::cast
+ */
+static bool castConvex(const ConvexBody& convex, const Vector3& origin, const Vector3& direction, real radius, real maxDistance, real& distance, Vector3& normal) {
+    real margin = convex.margin + radius;
+
+    Simplex simplex;
+    Vector3 closest;
+    real travelled = 0;
+    for (int iteration = 0; iteration < MAX_CAST_ITERATIONS; iteration++) {
+        // Only the sphere's center takes part, so its radius is added like a margin
+        ConvexBody sphere(origin + direction * travelled, 0);
+        ConvexPair cores = {convex, sphere, true};
+        if (iteration == 0) { startSimplex(cores, nullptr, simplex); }
+        else {
+            // Start from where the last step's simplex ended up
+            for (unsigned int i = 0; i < simplex.count; i++) { simplex.vertices[i] = cores.support(simplex.vertices[i].direction); }
+        }
+
+        bool touching = runGJK(cores, simplex, closest);
+        real coreDistance = touching ? 0 : closest.magnitude();
+        if (coreDistance - margin <= CAST_TOLERANCE) {
+            distance = travelled;
+            normal = coreDistance > 0 ? -closest / coreDistance : -direction;
+            return true;
+        }
+
+        // Heading away from the closest point of a convex body means it's missed
+        real approach = closest.dot(direction) / coreDistance;
+        if (approach <= 0) { return false; }
+
+        // The body lies beyond the plane through its closest point, so the
+        // sphere can move up to that plane without reaching it
+        travelled += (coreDistance - margin) / approach;
+        if (travelled > maxDistance) { return false; }
+    }
+    return false;
+}
+
+bool GJK::cast(const RigidBody *body, const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, real &distance, Vector3 &normal) {
+    return castConvex(ConvexBody(body), origin, direction, radius, maxDistance, distance, normal);
+}
+
+bool GJK::castTriangle(const Vector3 *triangle, const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, real &distance, Vector3 &normal) {
+    return castConvex(ConvexBody(triangle, 3), origin, direction, radius, maxDistance, distance, normal);
+}
@@ -0,0 +1,94 @@
+#ifndef PHYSICSENGINE_GJK_H
+#define PHYSICSENGINE_GJK_H
+
+#include "PhysicsContact.h"
+
+// Avoid circular dependency
+class RigidBody;
+
+/*
+ * Collision detection between any two convex RigidBodyModels,
+ * using nothing but their support functions, so a new model only
+ * has to describe its own shape to collide with every other.
+ *
+ * The Gilbert-Johnson-Keerthi algorithm walks a simplex through
+ * the Minkowski difference of the two models towards the origin,
+ * giving the distance between them. It runs on the models' cores,
+ * so rounded models only need their margins added afterwards.
+ * When the cores overlap, the Expanding Polytope Algorithm grows
+ * the simplex out to the surface of the difference to find the
+ * penetration depth.
+ */
+class GJK {
+public:
+    /*
+     * The search directions that built a query's final simplex, in
+     * the first body's space. Passing it back in for the next query
+     * on the same pair starts from that simplex, which usually
+     * converges straight away when the bodies have barely moved.
+     *
+     * When the bodies were apart, it also keeps the direction from the
+     * second body to the first, again in the first body's space. Bodies
+     * that were apart along it usually still are, and checking that
+     * only takes a support point from each.
+     */
+    struct SimplexCache {
+        Vector3 directions[4];
+        unsigned int count = 0;
+        Vector3 separatingAxis;
+    };
+
+    /*
+     * Returns the distance between the surfaces of two bodies, or 0 if
+     * they touch, writing the closest point on each into closest1 and
+     * closest2. The points are only meaningful when they don't touch.
+     * Always runs the full query, but still records the separating
+     * axis in the cache.
+     */
+    static real distance(const RigidBody* body1, const RigidBody* body2, Vector3& closest1, Vector3& closest2, SimplexCache* cache = nullptr);
+
+    /*
+     * Returns the distance between a body and a triangle whose corners
+     * are given in world space, like distance.
+     */
+    static real distanceToTriangle(const RigidBody* body, const Vector3* triangle, Vector3& closest1, Vector3& closest2);
+
+    /*
+     * Finds the deepest point of contact between two bodies. Works like
+     * ContactGenerator::addContact, writing at most one contact.
+     * Returns straight away if the cache's separating axis still
+     * separates the bodies.
+     */
+    static unsigned int collide(RigidBody* body1, RigidBody* body2, real restitution, PhysicsContact* contact, unsigned int limit, SimplexCache* cache = nullptr);
+
+    /*
+     * Finds the deepest point of contact between a body and a triangle
+     * whose corners are given in world space. If they touch, writes the
+     * normal pointing from the triangle to the body, the contact point
+     * and the penetration, and returns true.
+     */
+    static bool collideTriangle(const RigidBody* body, const Vector3* triangle, Vector3& normal, Vector3& point, real& penetration);
+
+    /*
+     * Sweeps a sphere from origin along direction, which should be
+     * normalized, for up to maxDistance. If it hits the body, writes how
+     * far it went and the body's surface normal there, facing back at
+     * the sphere, and returns true. A radius of 0 casts a ray. A sphere
+     * that starts out touching the body hits it at distance 0.
+     */
+    static bool cast(const RigidBody* body, const Vector3& origin, const Vector3& direction, real radius, real maxDistance, real& distance, Vector3& normal);
+
+    /*
+     * Sweeps a sphere against a triangle whose corners are given in world space, like cast.
+     */
+    static bool castTriangle(const Vector3* triangle, const Vector3& origin, const Vector3& direction, real radius, real maxDistance, real& distance, Vector3& normal);
+
+    /*
+     * Returns whether the cache's separating axis still separates the
+     * bodies. Returns false if the cache doesn't have one.
+     */
+    static bool isSeparated(const RigidBody* body1, const RigidBody* body2, const SimplexCache& cache);
+};
+
+
+#endif //PHYSICSENGINE_GJK_H
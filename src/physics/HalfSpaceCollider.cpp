@@ -0,0 +1,58 @@
+#include "HalfSpaceCollider.h"
+#include "RigidBody.h"
+#include "CollisionDetector.h"
+#include "../math/BatchMath.h"
+
+void HalfSpaceCollider::add(Vector3 normal, real offset, real restitution) {
+    // Scale the offset along with the normal, so it's still the same half-space
+    real length = normal.magnitude();
+    halfSpaces.push_back({normal / length, offset / length, restitution});
+}
+
+unsigned int HalfSpaceCollider::getCount() const { return halfSpaces.size(); }
+
+unsigned int HalfSpaceCollider::addContacts(const std::vector<Particle*> &particles, const std::vector<RigidBody*> &bodies, PhysicsContact *contact, unsigned int limit) {
+    if (halfSpaces.empty() || limit == 0) { return 0; }
+
+    // Gather the objects' bounding spheres into arrays for the kernel
+    objects.resize(particles.size() + bodies.size());
+    centersX.resize(objects.size()); centersY.resize(objects.size()); centersZ.resize(objects.size());
+    radii.resize(objects.size());
+    touching.resize(objects.size());
+
+    unsigned int count = 0;
+    for (Particle* particle : particles) {
+        if (!particle->hasFiniteMass()) { continue; }
+        Vector3 center = particle->getPosition();
+        objects[count] = particle;
+        centersX[count] = center.x; centersY[count] = center.y; centersZ[count] = center.z;
+        radii[count] = Particle::RADIUS;
+        count++;
+    }
+    unsigned int particleCount = count;
+    for (RigidBody* body : bodies) {
+        if (!body->hasFiniteMass()) { continue; }
+        BoundingSphere sphere = body->getBoundingSphere();
+        objects[count] = body;
+        centersX[count] = sphere.center.x; centersY[count] = sphere.center.y; centersZ[count] = sphere.center.z;
+        radii[count] = sphere.radius;
+        count++;
+    }
+
+    unsigned int used = 0;
+    Vector3Stream centers(centersX.data(), centersY.data(), centersZ.data());
+    for (const HalfSpace& h : halfSpaces) {
+        if (BatchMath::overlapHalfSpace(h.normal, h.offset, centers, radii.data(), count, touching.data()) == 0) { continue; }
+
+        for (unsigned int n = 0; n < count && used < limit; n++) {
+            if (!touching[n]) { continue; }
+            if (n < particleCount) {
+                used += CollisionDetector::particleAndHalfSpace(objects[n], Vector3(centersX[n], centersY[n], centersZ[n]), h.normal, h.offset, h.restitution, contact + used, limit - used);
+            } else {
+                used += CollisionDetector::bodyAndHalfSpace(static_cast<RigidBody*>(objects[n]), h.normal, h.offset, h.restitution, contact + used, limit - used);
+            }
+        }
+        if (used == limit) { break; }
+    }
+    return used;
+}
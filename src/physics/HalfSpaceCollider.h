@@ -0,0 +1,59 @@
+#ifndef PHYSICSENGINE_HALFSPACECOLLIDER_H
+#define PHYSICSENGINE_HALFSPACECOLLIDER_H
+
+#include <vector>
+#include "PhysicsContact.h"
+
+// Avoid circular dependency
+class RigidBody;
+
+/*
+ * Collides every body and Particle in a world against a set of fixed
+ * half-spaces, like the ground and walls, without a ContactGenerator
+ * per object.
+ *
+ * Each step, the objects' bounding spheres are gathered into arrays
+ * once, then tested against each half-space with a single batch
+ * kernel. Only the objects that kernel finds touching go on to the
+ * exact test: a Particle as a sphere of Particle::RADIUS, and a
+ * RigidBody with CollisionDetector::bodyAndHalfSpace.
+ */
+class HalfSpaceCollider {
+    /*
+     * The points p where normal.dot(p) <= offset
+     */
+    struct HalfSpace {
+        Vector3 normal;
+        real offset;
+        real restitution;
+    };
+
+    std::vector<HalfSpace> halfSpaces;
+
+    /*
+     * The objects being tested this step, with the Particles first, and
+     * their bounding spheres as arrays. Kept between steps to reuse their memory.
+     */
+    std::vector<PhysicsObject*> objects;
+    std::vector<real> centersX, centersY, centersZ, radii;
+    std::vector<unsigned char> touching;
+
+public:
+    /*
+     * Adds the half-space of points p where normal.dot(p) <= offset.
+     * The normal doesn't need to be normalized.
+     */
+    void add(Vector3 normal, real offset, real restitution);
+
+    unsigned int getCount() const;
+
+    /*
+     * Writes the contacts between the objects and every half-space,
+     * like ContactGenerator::addContact. Objects with infinite mass
+     * are skipped, since they can't be pushed out.
+     */
+    unsigned int addContacts(const std::vector<Particle*>& particles, const std::vector<RigidBody*>& bodies, PhysicsContact* contact, unsigned int limit);
+};
+
+
+#endif //PHYSICSENGINE_HALFSPACECOLLIDER_H
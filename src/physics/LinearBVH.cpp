@@ -0,0 +1,283 @@
+#include "LinearBVH.h"
+#include "RigidBody.h"
+
+#include <algorithm>
+
+// Spreads the low bits of v out so there are two zero bits between each
+static uint64_t expandBits10(uint64_t v) {
+    v &= 0x3ff;
+    v = (v | v << 16) & 0x30000ff;
+    v = (v | v << 8) & 0x300f00f;
+    v = (v | v << 4) & 0x30c30c3;
+    v = (v | v << 2) & 0x9249249;
+    return v;
+}
+
+static uint64_t expandBits21(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffff;
+    v = (v | v << 16) & 0x1f0000ff0000ff;
+    v = (v | v << 8) & 0x100f00f00f00f00f;
+    v = (v | v << 4) & 0x10c30c30c30c30c3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+LinearBVH::LinearBVH(MortonPrecision precision, ThreadPool& pool) : leafCount(0), precision(precision), pool(pool), visitsCapacity(0), chunkCount(1) {}
+
+void LinearBVH::insert(RigidBody *body) {
+    bodies.push_back(body);
+}
+
+bool LinearBVH::remove(RigidBody *body) {
+    auto it = std::find(bodies.begin(), bodies.end(), body);
+    if (it == bodies.end()) { return false; }
+    *it = bodies.back();
+    bodies.pop_back();
+    return true;
+}
+
+void LinearBVH::update() {
+    leafCount = bodies.size();
+    if (leafCount == 0) { return; }
+
+    // Only split the work up when there's enough of it to cover the overhead
+    chunkCount = std::max(1u, std::min(pool.getThreadCount(), leafCount / 1024));
+
+    nodes.resize(2*leafCount - 1);
+    codes.resize(leafCount);
+    codesBuffer.resize(leafCount);
+    order.resize(leafCount);
+    orderBuffer.resize(leafCount);
+    volumes.resize(leafCount);
+    parents.resize(2*leafCount - 1);
+    if (visitsCapacity < leafCount) {
+        visits.reset(new std::atomic<unsigned int>[leafCount]);
+        visitsCapacity = leafCount;
+    }
+
+    computeCodes();
+    sortCodes();
+    buildHierarchy();
+    computeVolumes();
+}
+
+void LinearBVH::computeCodes() {
+    // Find the bounds of the body centers
+    std::vector<Vector3> chunkMin(chunkCount, Vector3(REAL_MAX, REAL_MAX, REAL_MAX)), chunkMax(chunkCount, Vector3(-REAL_MAX, -REAL_MAX, -REAL_MAX));
+    pool.parallelChunks(leafCount, chunkCount, [&](unsigned int chunk, unsigned int begin, unsigned int end) {
+        Vector3 &min = chunkMin[chunk], &max = chunkMax[chunk];
+        for (unsigned int i = begin; i < end; i++) {
+            BoundingSphere volume = bodies[i]->getSweptBoundingSphere();
+            volumes[i] = volume;
+            min = Vector3(std::min(min.x, volume.center.x), std::min(min.y, volume.center.y), std::min(min.z, volume.center.z));
+            max = Vector3(std::max(max.x, volume.center.x), std::max(max.y, volume.center.y), std::max(max.z, volume.center.z));
+        }
+    });
+
+    Vector3 min = chunkMin[0], max = chunkMax[0];
+    for (unsigned int chunk = 1; chunk < chunkCount; chunk++) {
+        min = Vector3(std::min(min.x, chunkMin[chunk].x), std::min(min.y, chunkMin[chunk].y), std::min(min.z, chunkMin[chunk].z));
+        max = Vector3(std::max(max.x, chunkMax[chunk].x), std::max(max.y, chunkMax[chunk].y), std::max(max.z, chunkMax[chunk].z));
+    }
+
+    // Quantize the centers onto a grid spanning the bounds, and interleave the bits
+    bool fine = precision == BITS_63;
+    real cells = fine ? (1 << 21) - 1 : (1 << 10) - 1;
+    Vector3 extent = max - min;
+    Vector3 scale(extent.x > 0 ? cells / extent.x : 0, extent.y > 0 ? cells / extent.y : 0, extent.z > 0 ? cells / extent.z : 0);
+
+    pool.parallelChunks(leafCount, chunkCount, [&](unsigned int, unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            Vector3 offset = volumes[i].center - min;
+            uint64_t x = offset.x * scale.x, y = offset.y * scale.y, z = offset.z * scale.z;
+            codes[i] = fine ? (expandBits21(x) << 2 | expandBits21(y) << 1 | expandBits21(z))
+                            : (expandBits10(x) << 2 | expandBits10(y) << 1 | expandBits10(z));
+            order[i] = i;
+        }
+    });
+}
+
+void LinearBVH::sortCodes() {
+    const unsigned int RADIX_BITS = 8, BUCKETS = 1 << RADIX_BITS;
+    unsigned int passes = precision == BITS_63 ? 8 : 4;
+
+    // Each chunk counts its own digits, so it knows where to scatter its elements
+    std::vector<unsigned int> offsets(chunkCount * BUCKETS);
+
+    for (unsigned int pass = 0; pass < passes; pass++) {
+        unsigned int shift = pass * RADIX_BITS;
+
+        std::fill(offsets.begin(), offsets.end(), 0);
+        pool.parallelChunks(leafCount, chunkCount, [&](unsigned int chunk, unsigned int begin, unsigned int end) {
+            unsigned int* counts = &offsets[chunk * BUCKETS];
+            for (unsigned int i = begin; i < end; i++) { counts[(codes[i] >> shift) & (BUCKETS-1)]++; }
+        });
+
+        // If every code has the same digit, this pass wouldn't move anything
+        bool sorted = false;
+        for (unsigned int digit = 0; digit < BUCKETS && !sorted; digit++) {
+            unsigned int total = 0;
+            for (unsigned int chunk = 0; chunk < chunkCount; chunk++) { total += offsets[chunk * BUCKETS + digit]; }
+            sorted = total == leafCount;
+        }
+        if (sorted) { continue; }
+
+        // Turn the counts into starting positions, ordered by digit and then by chunk to keep the sort stable
+        unsigned int position = 0;
+        for (unsigned int digit = 0; digit < BUCKETS; digit++) {
+            for (unsigned int chunk = 0; chunk < chunkCount; chunk++) {
+                unsigned int count = offsets[chunk * BUCKETS + digit];
+                offsets[chunk * BUCKETS + digit] = position;
+                position += count;
+            }
+        }
+
+        pool.parallelChunks(leafCount, chunkCount, [&](unsigned int chunk, unsigned int begin, unsigned int end) {
+            unsigned int* next = &offsets[chunk * BUCKETS];
+            for (unsigned int i = begin; i < end; i++) {
+                unsigned int destination = next[(codes[i] >> shift) & (BUCKETS-1)]++;
+                codesBuffer[destination] = codes[i];
+                orderBuffer[destination] = order[i];
+            }
+        });
+
+        codes.swap(codesBuffer);
+        order.swap(orderBuffer);
+    }
+}
+
+int LinearBVH::commonPrefix(int i, int j) const {
+    if (j < 0 || j >= (int) leafCount) { return -1; }
+    if (codes[i] == codes[j]) { return 64 + __builtin_clz((unsigned int) (i ^ j)); }
+    return __builtin_clzll(codes[i] ^ codes[j]);
+}
+
+bool LinearBVH::isLeaf(unsigned int node) const {
+    return node >= leafCount - 1;
+}
+
+void LinearBVH::buildHierarchy() {
+    unsigned int firstLeaf = leafCount - 1;
+
+    // The leaves go in sorted order
+    pool.parallelChunks(leafCount, chunkCount, [&](unsigned int, unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            Node& leaf = nodes[firstLeaf + i];
+            leaf.children[0] = order[i];
+            leaf.volume = volumes[order[i]];
+            leaf.filter = bodies[order[i]]->getCollisionFilter();
+        }
+    });
+    parents[0] = 0;
+
+    // Each internal node covers a range of sorted leaves starting or ending at its own index
+    pool.parallelChunks(firstLeaf, chunkCount, [&](unsigned int, unsigned int begin, unsigned int end) {
+        for (int i = begin; i < (int) end; i++) {
+            // Find which way the range extends, and how far
+            int direction = commonPrefix(i, i + 1) > commonPrefix(i, i - 1) ? 1 : -1;
+            int minPrefix = commonPrefix(i, i - direction);
+
+            int maxLength = 2;
+            while (commonPrefix(i, i + maxLength*direction) > minPrefix) { maxLength *= 2; }
+            int length = 0;
+            for (int step = maxLength / 2; step >= 1; step /= 2) {
+                if (commonPrefix(i, i + (length + step)*direction) > minPrefix) { length += step; }
+            }
+            int j = i + length*direction;
+
+            // Split the range where the codes' common prefix ends
+            int nodePrefix = commonPrefix(i, j);
+            int split = 0, step = length;
+            do {
+                step = (step + 1) / 2;
+                if (commonPrefix(i, i + (split + step)*direction) > nodePrefix) { split += step; }
+            } while (step > 1);
+            int gamma = i + split*direction + std::min(direction, 0);
+
+            Node& node = nodes[i];
+            node.children[0] = std::min(i, j) == gamma ? firstLeaf + gamma : gamma;
+            node.children[1] = std::max(i, j) == gamma + 1 ? firstLeaf + gamma + 1 : gamma + 1;
+            parents[node.children[0]] = i;
+            parents[node.children[1]] = i;
+        }
+    });
+}
+
+void LinearBVH::computeVolumes() {
+    if (leafCount < 2) { return; }
+    unsigned int firstLeaf = leafCount - 1;
+
+    for (unsigned int i = 0; i < firstLeaf; i++) { visits[i].store(0, std::memory_order_relaxed); }
+
+    // Walk up from every leaf; the second child to reach a node fills it in and carries on
+    pool.parallelChunks(leafCount, chunkCount, [&](unsigned int, unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            unsigned int node = parents[firstLeaf + i];
+            while (visits[node].fetch_add(1, std::memory_order_acq_rel) == 1) {
+                Node& n = nodes[node];
+                n.volume = BoundingSphere(nodes[n.children[0]].volume, nodes[n.children[1]].volume);
+                n.filter = nodes[n.children[0]].filter;
+                n.filter |= nodes[n.children[1]].filter;
+                if (node == 0) { break; }
+                node = parents[node];
+            }
+        }
+    });
+}
+
+void LinearBVH::getPotentialContacts(unsigned int node, std::vector<PotentialContact>& contacts) const {
+    if (isLeaf(node)) {return;}
+
+    // Skip subtrees where no body collides with any other
+    const Node& n = nodes[node];
+    if (!n.filter.collidesWith(n.filter)) {return;}
+
+    getPotentialContactsBetween(n.children[0], n.children[1], contacts);
+    getPotentialContacts(n.children[0], contacts);
+    getPotentialContacts(n.children[1], contacts);
+}
+
+void LinearBVH::getPotentialContactsBetween(unsigned int node1, unsigned int node2, std::vector<PotentialContact>& contacts) const {
+    const Node &n1 = nodes[node1], &n2 = nodes[node2];
+    if (!n1.filter.collidesWith(n2.filter) || !n1.volume.overlaps(&n2.volume)) {return;}
+
+    bool leaf1 = isLeaf(node1), leaf2 = isLeaf(node2);
+    // If we've reached 2 leaf nodes that overlap, they might be in contact
+    if (leaf1 && leaf2) {
+        if (!bodies[n1.children[0]]->canCollideWith(bodies[n2.children[0]])) {return;}
+        contacts.push_back({{bodies[n1.children[0]], bodies[n2.children[0]]}});
+        return;
+    }
+
+    // Pick one node to descend into: either the non-leaf, or
+    // the larger one if they're both branches
+    bool descendIntoFirst = leaf2 || (!leaf1 && n1.volume.radius >= n2.volume.radius);
+    const Node& splitNode = descendIntoFirst ? n1 : n2;
+    unsigned int otherNode = descendIntoFirst ? node2 : node1;
+
+    getPotentialContactsBetween(splitNode.children[0], otherNode, contacts);
+    getPotentialContactsBetween(splitNode.children[1], otherNode, contacts);
+}
+
+unsigned int LinearBVH::getPotentialContacts(std::vector<PotentialContact>& contacts) const {
+    if (leafCount == 0) { return 0; }
+    size_t start = contacts.size();
+    getPotentialContacts(0, contacts);
+    return contacts.size() - start;
+}
+
+real LinearBVH::queryCast(unsigned int node, const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, const std::function<real(RigidBody*)> &visit) const {
+    const Node& n = nodes[node];
+    if (!n.volume.overlapsCast(origin, direction, radius, maxDistance)) { return maxDistance; }
+    if (isLeaf(node)) { return visit(bodies[n.children[0]]); }
+
+    // Look along the cast in order, so hits found early rule out more of the tree
+    int first = (nodes[n.children[0]].volume.center - nodes[n.children[1]].volume.center).dot(direction) <= 0 ? 0 : 1;
+    maxDistance = queryCast(n.children[first], origin, direction, radius, maxDistance, visit);
+    return queryCast(n.children[1 - first], origin, direction, radius, maxDistance, visit);
+}
+
+void LinearBVH::queryCast(const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, const std::function<real(RigidBody*)> &visit) const {
+    if (leafCount > 0) { queryCast(0, origin, direction, radius, maxDistance, visit); }
+}
@@ -0,0 +1,138 @@
+#ifndef PHYSICSENGINE_LINEARBVH_H
+#define PHYSICSENGINE_LINEARBVH_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Broadphase.h"
+#include "BVHTree.h"
+#include "ThreadPool.h"
+
+/*
+ * A bounding volume hierarchy that is rebuilt from scratch on every
+ * update instead of being modified, for scenes where most bodies move
+ * each step.
+ *
+ * Bodies are sorted along a Morton (Z-order) curve through the scene,
+ * which puts nearby bodies next to each other. Each node of the tree
+ * can then be built independently from the sorted codes (Karras 2012),
+ * so every stage of the build runs in parallel.
+ */
+class LinearBVH : public Broadphase {
+public:
+    /*
+     * How finely body centers are quantized for sorting: 10 or 21 bits per
+     * axis. Coarser codes sort in half the passes, while finer codes keep
+     * bodies in large or dense scenes from sharing a code.
+     */
+    enum MortonPrecision { BITS_30, BITS_63 };
+
+protected:
+    /*
+     * The nodes are stored flat: the internal nodes first, with the root
+     * at 0, then the leaves in Morton order. Every subtree covers a
+     * contiguous run of internal nodes and of leaves.
+     */
+    struct Node {
+        BoundingSphere volume;
+
+        /*
+         * Holds the CollisionFilters of the bodies under the node combined.
+         */
+        CollisionFilter filter;
+
+        /*
+         * For internal nodes, holds the indices of the two child nodes.
+         * For leaves, children[0] holds the index of the body.
+         */
+        unsigned int children[2];
+    };
+
+    std::vector<RigidBody*> bodies;
+    std::vector<Node> nodes;
+
+    /*
+     * Holds the number of bodies in the last build. The first leaf is at leafCount-1.
+     */
+    unsigned int leafCount;
+
+    bool isLeaf(unsigned int node) const;
+
+private:
+    MortonPrecision precision;
+    ThreadPool& pool;
+
+    /*
+     * Scratch space for building, kept between builds to reuse its memory.
+     */
+    std::vector<uint64_t> codes, codesBuffer;
+    std::vector<unsigned int> order, orderBuffer;
+    std::vector<BoundingSphere> volumes;
+    std::vector<unsigned int> parents;
+    std::unique_ptr<std::atomic<unsigned int>[]> visits;
+    unsigned int visitsCapacity;
+
+    /*
+     * Holds the number of ranges each build stage is split into.
+     */
+    unsigned int chunkCount;
+
+    /*
+     * Computes the Morton code of every body's center within the scene's bounds.
+     */
+    void computeCodes();
+
+    /*
+     * Sorts the codes, and the body order along with them, with a parallel radix sort.
+     */
+    void sortCodes();
+
+    /*
+     * Links up the internal nodes from the sorted codes.
+     */
+    void buildHierarchy();
+
+    /*
+     * Fills in the bounding volumes from the leaves up to the root.
+     */
+    void computeVolumes();
+
+    /*
+     * Returns the length of the common prefix of the sorted codes at i and j,
+     * or -1 if j is out of range. Equal codes are told apart by their index.
+     */
+    int commonPrefix(int i, int j) const;
+
+    void getPotentialContacts(unsigned int node, std::vector<PotentialContact>& contacts) const;
+
+    void getPotentialContactsBetween(unsigned int node1, unsigned int node2, std::vector<PotentialContact>& contacts) const;
+
+    /*
+     * Runs a cast query from node down. Returns how far along the cast
+     * to keep looking afterwards.
+     */
+    real queryCast(unsigned int node, const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const;
+
+public:
+    explicit LinearBVH(MortonPrecision precision = BITS_30, ThreadPool& pool = ThreadPool::shared());
+
+    void insert(RigidBody* body) override;
+
+    bool remove(RigidBody* body) override;
+
+    /*
+     * Rebuilds the hierarchy from the bodies' current positions.
+     */
+    void update() override;
+
+    using Broadphase::getPotentialContacts;
+
+    unsigned int getPotentialContacts(std::vector<PotentialContact>& contacts) const override;
+
+    void queryCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const override;
+
+};
+
+
+#endif //PHYSICSENGINE_LINEARBVH_H
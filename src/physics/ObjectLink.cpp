@@ -4,13 +4,17 @@ real ObjectLink::currentLength() const {
     return (objects[1]->getPosition() - objects[0]->getPosition()).magnitude();
 }
 
-ObjectLink::ObjectLink(PhysicsObject* obj1, PhysicsObject* obj2) {
+ObjectLink::ObjectLink(PhysicsObject* obj1, PhysicsObject* obj2) : shape(Shape::cylinder(Vector3(), Vector3::UP, 1, C_BLACK, 6, false)) {
     objects[0] = obj1;
     objects[1] = obj2;
 }
 
-Shape ObjectLink::getShape() const {
-    return Shape::cylinder(objects[0]->getPosition(), objects[1]->getPosition(), 0.1, C_BLACK, 6, false);
+const Shape& ObjectLink::getShape() const {
+    return shape;
+}
+
+Matrix4 ObjectLink::getShapeMatrix() const {
+    return Shape::cylinderTransform(objects[0]->getPosition(), objects[1]->getPosition(), 0.1);
 }
 
 unsigned int ParticleCable::addContact(PhysicsContact *contact, unsigned int limit) const {
@@ -31,6 +35,8 @@ unsigned int ParticleCable::addContact(PhysicsContact *contact, unsigned int lim
     contact->contactNormal = (objects[1]->getPosition() - objects[0]->getPosition()).normalized();
 
     contact->penetration = length - maxLength;
+    contact->contactPoint = objects[0]->getPosition();
+    contact->featureId = 0;
     contact->restitution = restitution;
 
     return 1;
@@ -65,6 +71,9 @@ unsigned int ParticleRod::addContact(PhysicsContact *contact, unsigned int limit
         contact->penetration = length - currentLen;
     }
 
+    contact->contactPoint = objects[0]->getPosition();
+    contact->featureId = 0;
+
     // Always use 0 restitution (no bounciness)
     contact->restitution = 0;
 
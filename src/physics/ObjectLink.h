@@ -20,7 +20,8 @@ public:
 
     ObjectLink(PhysicsObject* obj1, PhysicsObject* obj2);
 
-    Shape getShape() const override;
+    const Shape& getShape() const override;
+    Matrix4 getShapeMatrix() const override;
 
 protected:
     /*
@@ -29,6 +30,12 @@ protected:
      */
     virtual real currentLength() const;
 
+private:
+    /*
+     * A unit cylinder, stretched between the objects when drawn
+     */
+    Shape shape;
+
 };
 
 /*
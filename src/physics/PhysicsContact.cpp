@@ -56,6 +56,8 @@ void ParticleContact::resolveVelocity(real deltaTime) {
 }
 
 void ParticleContact::resolveInterpenetration(real deltaTime) {
+    objectMovement[0] = objectMovement[1] = Vector3();
+
     // If there isn't penetration, skip this
     if (penetration <= 0) { return; }
 
@@ -70,10 +72,12 @@ void ParticleContact::resolveInterpenetration(real deltaTime) {
     Vector3 movePerIMass = contactNormal * (penetration / totalInverseMass);
 
     // Calculate the movement amounts
-    objects[0]->setPosition(objects[0]->getPosition() + movePerIMass * objects[0]->getInverseMass());
+    objectMovement[0] = movePerIMass * objects[0]->getInverseMass();
+    objects[0]->setPosition(objects[0]->getPosition() + objectMovement[0]);
     if (objects[1]) {
         // Opposite direction to object 0
-        objects[1]->setPosition(objects[1]->getPosition() - movePerIMass * objects[1]->getInverseMass());
+        objectMovement[1] = movePerIMass * -objects[1]->getInverseMass();
+        objects[1]->setPosition(objects[1]->getPosition() + objectMovement[1]);
     }
     penetration = 0;
 }
@@ -36,9 +36,40 @@ public:
      */
     real penetration;
 
+    /*
+     * Holds the position of the contact (in world coordinates)
+     */
+    Vector3 contactPoint;
+
+    /*
+     * Identifies which features of the two objects are touching, like
+     * a box's corner, so the same contact can be recognized in the
+     * next step. Generators that can't tell features apart use 0.
+     */
+    unsigned int featureId;
+
+    /*
+     * Holds the total impulse applied along the normal while
+     * resolving the contact, for resolvers that accumulate it.
+     */
+    real normalImpulse;
+
+    /*
+     * Holds the total impulse applied across the normal by friction,
+     * for resolvers that accumulate it.
+     */
+    Vector3 frictionImpulse;
+
 protected:
     friend class PhysicsContactResolver;
 
+    /*
+     * Holds how far each object was moved by the last call to
+     * resolveInterpenetration, so the resolver can update the
+     * penetration of other contacts involving the same objects.
+     */
+    Vector3 objectMovement[2];
+
     /*
      * Resolves the contact for both velocity and interpenetration
      */
@@ -1,5 +1,7 @@
 #include "PhysicsContactResolver.h"
 
+#include <algorithm>
+
 
 PhysicsContactResolver::PhysicsContactResolver(unsigned int iterations) : iterations(iterations) {}
 
@@ -13,6 +15,10 @@ void PhysicsContactResolver::resolveContact(PhysicsContact *contact, real deltaT
     contact->resolve(deltaTime);
 }
 
+const Vector3* PhysicsContactResolver::getContactMovement(PhysicsContact *contact) {
+    return contact->objectMovement;
+}
+
 
 void ParticleContactResolver::resolveContacts(PhysicsContact* contactArray, unsigned int numContacts, real deltaTime) {
     iterationsUsed = 0;
@@ -34,7 +40,23 @@ void ParticleContactResolver::resolveContacts(PhysicsContact* contactArray, unsi
         if (maxIndex == numContacts) { break; }
 
         // Resolve the current contact
-        resolveContact(contactArray+maxIndex, deltaTime);
+        PhysicsContact* resolved = contactArray+maxIndex;
+        resolveContact(resolved, deltaTime);
+
+        // Moving the objects changes the penetration of their other contacts,
+        // eg. the rest of the points where two boxes touch
+        const Vector3* movement = getContactMovement(resolved);
+        for (unsigned int i = 0; i < numContacts; i++) {
+            PhysicsContact* other = contactArray+i;
+            if (other == resolved) { continue; }
+            for (int k = 0; k < 2; k++) {
+                if (!other->objects[k]) { continue; }
+                // The normal points towards the first object, so moving it along the normal reduces penetration
+                real sign = k == 0 ? -1 : 1;
+                if (other->objects[k] == resolved->objects[0]) { other->penetration += sign * movement[0].dot(other->contactNormal); }
+                else if (other->objects[k] == resolved->objects[1]) { other->penetration += sign * movement[1].dot(other->contactNormal); }
+            }
+        }
 
         iterationsUsed++;
 
@@ -42,3 +64,108 @@ void ParticleContactResolver::resolveContacts(PhysicsContact* contactArray, unsi
 }
 
 ParticleContactResolver::ParticleContactResolver(unsigned int iterations) : PhysicsContactResolver(iterations) {}
+
+const real ImpulseContactResolver::PENETRATION_SLOP(0.005f);
+const real ImpulseContactResolver::PENETRATION_CORRECTION(0.2f);
+const real ImpulseContactResolver::RESTING_VELOCITY(0.5f);
+
+ImpulseContactResolver::ImpulseContactResolver(unsigned int iterations, bool warmStarting, real friction) : PhysicsContactResolver(iterations), warmStarting(warmStarting), friction(friction) {}
+
+void ImpulseContactResolver::setWarmStarting(bool enabled) { warmStarting = enabled; }
+
+void ImpulseContactResolver::setFriction(real friction) { this->friction = friction; }
+
+const ContactCache& ImpulseContactResolver::getCache() const { return cache; }
+
+void ImpulseContactResolver::applyImpulse(PhysicsContact *contact, const Vector3& impulse) {
+    contact->objects[0]->applyImpulse(impulse, contact->contactPoint);
+    if (contact->objects[1]) { contact->objects[1]->applyImpulse(-impulse, contact->contactPoint); }
+}
+
+Vector3 ImpulseContactResolver::getRelativeVelocity(const PhysicsContact *contact) {
+    Vector3 relativeVelocity = contact->objects[0]->getVelocityAtPoint(contact->contactPoint);
+    if (contact->objects[1]) { relativeVelocity -= contact->objects[1]->getVelocityAtPoint(contact->contactPoint); }
+    return relativeVelocity;
+}
+
+real ImpulseContactResolver::getInverseMass(const PhysicsContact *contact, const Vector3 &direction) {
+    real inverseMass = contact->objects[0]->getInverseMassAtPoint(contact->contactPoint, direction);
+    if (contact->objects[1]) { inverseMass += contact->objects[1]->getInverseMassAtPoint(contact->contactPoint, direction); }
+    return inverseMass;
+}
+
+void ImpulseContactResolver::resolveContacts(PhysicsContact *contactArray, unsigned int numContacts, real deltaTime) {
+    iterationsUsed = 0;
+
+    if (warmStarting) { cache.warmStart(contactArray, numContacts); }
+    else {
+        for (unsigned int i = 0; i < numContacts; i++) {
+            contactArray[i].normalImpulse = 0;
+            contactArray[i].frictionImpulse = Vector3();
+        }
+    }
+
+    // Work out each contact's effective masses and the separating velocity it should end up with
+    states.resize(numContacts);
+    for (unsigned int i = 0; i < numContacts; i++) {
+        PhysicsContact* contact = contactArray+i;
+        const Vector3& normal = contact->contactNormal;
+        ContactState& state = states[i];
+
+        real inverseMass = getInverseMass(contact, normal);
+        state.normalMass = inverseMass > 0 ? 1 / inverseMass : 0;
+
+        // Any two directions perpendicular to the normal and each other will do
+        Vector3 axis = real_abs(normal.x) < (real)0.57 ? Vector3::RIGHT : Vector3::UP;
+        state.tangents[0] = normal.cross(axis).normalized();
+        state.tangents[1] = normal.cross(state.tangents[0]);
+        for (unsigned int t = 0; t < 2; t++) {
+            inverseMass = getInverseMass(contact, state.tangents[t]);
+            state.tangentMass[t] = inverseMass > 0 ? 1 / inverseMass : 0;
+        }
+
+        real normalVelocity = getRelativeVelocity(contact).dot(normal);
+        real bounce = normalVelocity < -RESTING_VELOCITY ? -contact->restitution * normalVelocity : 0;
+        real correction = PENETRATION_CORRECTION / deltaTime * std::max((real)0, contact->penetration - PENETRATION_SLOP);
+        state.targetVelocity = std::max(bounce, correction);
+
+        // Start from last step's impulses, dropping any part of the friction that now lies along the normal
+        contact->frictionImpulse -= normal * contact->frictionImpulse.dot(normal);
+        Vector3 impulse = normal * contact->normalImpulse + contact->frictionImpulse;
+        if (!impulse.isZero()) { applyImpulse(contact, impulse); }
+    }
+
+    // Build up the impulses, never letting a contact's total pull its objects together
+    // or its friction exceed what the normal impulse allows
+    unsigned int passes = numContacts ? std::max(1u, iterations / numContacts) : 0;
+    for (unsigned int pass = 0; pass < passes; pass++) {
+        for (unsigned int i = 0; i < numContacts; i++) {
+            PhysicsContact* contact = contactArray+i;
+            const ContactState& state = states[i];
+            if (state.normalMass == 0) { continue; }
+
+            real impulse = (state.targetVelocity - getRelativeVelocity(contact).dot(contact->contactNormal)) * state.normalMass;
+            real total = std::max((real)0, contact->normalImpulse + impulse);
+            impulse = total - contact->normalImpulse;
+            contact->normalImpulse = total;
+            if (impulse != 0) { applyImpulse(contact, contact->contactNormal * impulse); }
+
+            if (friction <= 0) { continue; }
+            Vector3 relativeVelocity = getRelativeVelocity(contact);
+            Vector3 frictionTotal = contact->frictionImpulse;
+            for (unsigned int t = 0; t < 2; t++) {
+                frictionTotal -= state.tangents[t] * (relativeVelocity.dot(state.tangents[t]) * state.tangentMass[t]);
+            }
+            real maxFriction = friction * contact->normalImpulse;
+            if (frictionTotal.magnitudeSquared() > maxFriction * maxFriction) {
+                frictionTotal = frictionTotal.normalized() * maxFriction;
+            }
+            Vector3 frictionChange = frictionTotal - contact->frictionImpulse;
+            contact->frictionImpulse = frictionTotal;
+            if (!frictionChange.isZero()) { applyImpulse(contact, frictionChange); }
+        }
+        iterationsUsed += numContacts;
+    }
+
+    cache.store(contactArray, numContacts);
+}
@@ -1,7 +1,9 @@
 #ifndef PHYSICSENGINE_PHYSICSCONTACTRESOLVER_H
 #define PHYSICSENGINE_PHYSICSCONTACTRESOLVER_H
 
+#include <vector>
 #include "PhysicsContact.h"
+#include "ContactCache.h"
 
 /*
  * The contact resolution routine for particle contacts. One
@@ -27,6 +29,7 @@ protected:
      */
     static real getContactSeparatingVelocity(PhysicsContact* contact);
     static void resolveContact(PhysicsContact* contact, real deltaTime);
+    static const Vector3* getContactMovement(PhysicsContact* contact);
 
 public:
     /*
@@ -34,6 +37,8 @@ public:
      */
     explicit PhysicsContactResolver(unsigned int iterations);
 
+    virtual ~PhysicsContactResolver() = default;
+
     /*
      * Sets the number of iterations that can be used.
      */
@@ -62,5 +67,88 @@ public:
 
 };
 
+/*
+ * A PhysicsContactResolver that also turns RigidBodies, by applying
+ * an impulse at each contact point. Each contact's impulse is built
+ * up over several passes through all the contacts, and only the
+ * total is kept from pulling the objects together, so contacts that
+ * share an object settle on impulses that work for all of them.
+ * Penetration is removed by asking for a little extra separating
+ * velocity rather than by moving the objects.
+ *
+ * With warm starting, each contact's total is remembered in a
+ * ContactCache and applied at the start of the next step. Resting
+ * contacts then start close to the answer, which needs far fewer
+ * passes to keep a stack still.
+ */
+class ImpulseContactResolver : public PhysicsContactResolver {
+private:
+    /*
+     * Holds what each contact needs while resolving, kept between
+     * steps to reuse its memory.
+     */
+    struct ContactState {
+        real normalMass;
+        real targetVelocity;
+
+        /*
+         * Holds two directions across the normal and the effective
+         * mass along each, for friction.
+         */
+        Vector3 tangents[2];
+        real tangentMass[2];
+    };
+    std::vector<ContactState> states;
+
+    ContactCache cache;
+    bool warmStarting;
+
+    /*
+     * Holds the coefficient of friction used for every contact.
+     */
+    real friction;
+
+    static void applyImpulse(PhysicsContact* contact, const Vector3& impulse);
+    static Vector3 getRelativeVelocity(const PhysicsContact* contact);
+    static real getInverseMass(const PhysicsContact* contact, const Vector3& direction);
+
+public:
+    /*
+     * Penetration up to the slop is left alone, so resting contacts
+     * keep touching. A fraction of the rest is removed each step.
+     */
+    static const real PENETRATION_SLOP;
+    static const real PENETRATION_CORRECTION;
+
+    /*
+     * Contacts closing slower than this don't bounce.
+     */
+    static const real RESTING_VELOCITY;
+
+    /*
+     * Creates a new impulse resolver. As with the other resolvers,
+     * iterations counts single contact resolutions, so each step
+     * makes iterations / numContacts passes through the contacts
+     * (at least one).
+     *
+     * Friction stops sliding until it would take more than friction
+     * times the normal impulse. Without it nothing can rest on a
+     * slope, and stacks slide apart at the slightest tilt.
+     */
+    explicit ImpulseContactResolver(unsigned int iterations, bool warmStarting = true, real friction = (real)0.5);
+
+    void setWarmStarting(bool enabled);
+    void setFriction(real friction);
+
+    const ContactCache& getCache() const;
+
+    /*
+     * Resolves the contacts. Should be called every step, even without
+     * contacts, so the cache knows which pairs have separated.
+     */
+    void resolveContacts(PhysicsContact *contactArray, unsigned int numContacts, real deltaTime) override;
+
+};
+
 
 #endif //PHYSICSENGINE_PHYSICSCONTACTRESOLVER_H
@@ -7,7 +7,7 @@ const real PhysicsObject::DAMPING(0.85f);
 
 bool hasFiniteMass();
 
-PhysicsObject::PhysicsObject(Vector3 pos, Vector3 vel, real inverseMass, bool damping, Shape model) : position(pos), velocity(vel), inverseMass(inverseMass), model(model), damping(damping) {}
+PhysicsObject::PhysicsObject(Vector3 pos, Vector3 vel, real inverseMass, bool damping, Shape model) : position(pos), velocity(vel), inverseMass(inverseMass), model(model), damping(damping), worldIndex(0) {}
 
 real PhysicsObject::getInverseMass() const {return inverseMass;}
 bool PhysicsObject::hasFiniteMass() const {return inverseMass > 0.0f;}
@@ -17,6 +17,9 @@ Vector3 PhysicsObject::getVelocity() const {return velocity;}
 
 const Shape& PhysicsObject::getShape() const {return model;}
 
+unsigned int PhysicsObject::getWorldIndex() const {return worldIndex;}
+void PhysicsObject::setWorldIndex(unsigned int index) {worldIndex = index;}
+
 Matrix4 PhysicsObject::getShapeMatrix() const {
     return Matrix4().translate(position);
 }
@@ -58,6 +61,14 @@ void PhysicsObject::addForceAtBodyPoint(Vector3 force, Vector3 relPos) {
     addForceAtPoint(force, relPos + position);
 }
 
+Vector3 PhysicsObject::getVelocityAtPoint(const Vector3 &) const { return velocity; }
+
+real PhysicsObject::getInverseMassAtPoint(const Vector3 &, const Vector3 &) const { return inverseMass; }
+
+void PhysicsObject::applyImpulse(const Vector3 &impulse, const Vector3 &) {
+    velocity += impulse * inverseMass;
+}
+
 Vector3 PhysicsObject::getPointInWorldSpace(Vector3 bodyPos) {
     return position + bodyPos;
 }
@@ -67,7 +78,7 @@ Vector3 PhysicsObject::getPointInBodySpace(Vector3 worldPos) {
 }
 
 BoundingSphere PhysicsObject::getBoundingSphere() const {
-    return BoundingSphere(Vector3(), 0);
+    return BoundingSphere(position, 0);
 }
 
 const real Particle::RADIUS = 0.2;
@@ -75,6 +86,10 @@ const int Particle::SMOOTHNESS = 2;
 
 Particle::Particle(Vector3 pos, Vector3 vel, real inverseMass, bool damping, VertexColor color) : PhysicsObject(pos,vel,inverseMass,damping,Shape::icosphere(Vector3(), Particle::RADIUS, color, Particle::SMOOTHNESS)) {}
 
+BoundingSphere Particle::getBoundingSphere() const {
+    return BoundingSphere(position, RADIUS);
+}
+
 std::ostream &operator<<(std::ostream &out, const PhysicsObject &obj) {
     if (auto p = dynamic_cast<const Particle*>(&obj)) {out << "Particle";}
     else if (auto rb = dynamic_cast<const RigidBody*>(&obj)) {out << "RigidBody(" << *rb->getModel() << ")";}
@@ -25,6 +25,13 @@ protected:
     // Does the object experience damping?
     bool damping;
 
+    /*
+     * Holds the order the object was added to its world in. Unlike
+     * its address, this is the same every run, so it gives pairs of
+     * objects an order that doesn't depend on where they were allocated.
+     */
+    unsigned int worldIndex;
+
     // Clears the force accumulator. Called after each integration step
     virtual void clearAccumulators();
 
@@ -39,6 +46,9 @@ public:
     Vector3 getVelocity() const;
 
     const Shape& getShape() const;
+
+    unsigned int getWorldIndex() const;
+    void setWorldIndex(unsigned int index);
     virtual Matrix4 getShapeMatrix() const;
 
     /*
@@ -57,6 +67,25 @@ public:
     void setVelocity(Vector3 vel);
     virtual void setPosition(Vector3 vel);
 
+    /*
+     * Returns the velocity of a point on the object.
+     * Given in world coordinates
+     */
+    virtual Vector3 getVelocityAtPoint(const Vector3& point) const;
+
+    /*
+     * Returns how much the velocity of a point on the object changes
+     * along a direction for each unit of impulse applied there in that
+     * direction. For an object that can't rotate this is its inverse mass.
+     */
+    virtual real getInverseMassAtPoint(const Vector3& point, const Vector3& direction) const;
+
+    /*
+     * Instantly changes the object's velocity by applying an
+     * impulse at a point. Given in world coordinates
+     */
+    virtual void applyImpulse(const Vector3& impulse, const Vector3& point);
+
     virtual Vector3 getPointInWorldSpace(Vector3 bodyPos);
     virtual Vector3 getPointInBodySpace(Vector3 worldPos);
 
@@ -72,6 +101,8 @@ public:
     static const int SMOOTHNESS;
 
     Particle(Vector3 pos, Vector3 vel, real inverseMass, bool damping, VertexColor color);
+
+    BoundingSphere getBoundingSphere() const override;
 };
 
 #endif //PHYSICSENGINE_PHYSICSOBJECT_H
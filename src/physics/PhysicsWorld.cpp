@@ -1,26 +1,31 @@
 #include "PhysicsWorld.h"
-#include "../render/MainWindow.h"
+#include "RigidBody.h"
+#include "SplitBroadphase.h"
+#include "ContinuousCollision.h"
 
 PhysicsWorld::~PhysicsWorld() {
+    // The broad phase still points at the bodies, so it goes first
+    delete broadphase;
     for (PhysicsObject* obj : objects) {delete obj;}
     for (ForceGenerator* fg : forces) {delete fg;}
-    delete contacts;
+    delete[] contacts;
+    delete contactResolver;
 }
 
 void PhysicsWorld::writeObjectData(bool flatShaded, bool initialWrite, Vector3* positions, VertexColor* colors, GLuint* indices, int &vertexIdx, int &indexIdx) const {
     for (PhysicsObject* obj : objects) {
-        MainWindow::writeShape(obj->getShape(), obj->getShapeMatrix(), flatShaded, initialWrite, positions, colors, indices, vertexIdx, indexIdx);
+        obj->getShape().write(obj->getShapeMatrix(), flatShaded, initialWrite, positions, colors, indices, vertexIdx, indexIdx);
     }
 
     Renderable* r;
     for (ForceGenerator* fg : forces) {
         if ((r = dynamic_cast<Renderable*>(fg)) != nullptr) {
-            MainWindow::writeShape(r->getShape(), Matrix4(), flatShaded, initialWrite, positions, colors, indices, vertexIdx, indexIdx);
+            r->getShape().write(r->getShapeMatrix(), flatShaded, initialWrite, positions, colors, indices, vertexIdx, indexIdx);
         }
     }
     for (ContactGenerator* cg : contactGenerators) {
         if ((r = dynamic_cast<Renderable*>(cg)) != nullptr) {
-            MainWindow::writeShape(r->getShape(), Matrix4(), flatShaded, initialWrite, positions, colors, indices, vertexIdx, indexIdx);
+            r->getShape().write(r->getShapeMatrix(), flatShaded, initialWrite, positions, colors, indices, vertexIdx, indexIdx);
         }
     }
 }
@@ -57,21 +62,97 @@ void PhysicsWorld::update(real deltaTime) {
         obj->update(deltaTime);
     }
 
+    // Find the pairs of bodies that might be colliding
+    findPotentialContacts();
+
+    // Stop fast bodies at what they hit before they pass through it
+    moveToTimesOfImpact();
+
     // Generate the contacts
-    unsigned int usedContacts = generateContacts();
+    contactsUsed = generateContacts();
 
-    // Process the contacts
-    if (usedContacts) {
-        if (calculateContactIterations) { contactResolver.setIterations(usedContacts*2); }
-        contactResolver.resolveContacts(contacts, usedContacts, deltaTime);
-    }
+    // Process the contacts, even when there aren't any so resolvers that
+    // remember contacts between steps know they've gone
+    if (calculateContactIterations) { contactResolver->setIterations(contactsUsed*2); }
+    contactResolver->resolveContacts(contacts, contactsUsed, deltaTime);
 }
 
-PhysicsWorld::PhysicsWorld(unsigned int maxContacts, unsigned int contactIterations) : maxContacts(maxContacts),contactResolver(contactIterations) {
+PhysicsWorld::PhysicsWorld(unsigned int maxContacts, unsigned int contactIterations)
+        : contactResolver(new ParticleContactResolver(contactIterations)), broadphase(new SplitBroadphase<>()), narrowphase(nullptr),
+          particleGrid(2 * Particle::RADIUS), particleCollisions(false), particleRestitution(0),
+          potentialContactsUsed(0), particlePairsUsed(0), contactsUsed(0), maxContacts(maxContacts) {
     contacts = new ParticleContact[maxContacts];
     calculateContactIterations = (contactIterations == 0);
 }
 
+void PhysicsWorld::findPotentialContacts() {
+    broadphase->update();
+    potentialContacts.clear();
+    potentialContactsUsed = broadphase->getPotentialContacts(potentialContacts);
+
+    particlePairs.clear();
+    if (particleCollisions) {
+        particleGrid.update();
+        particlePairsUsed = particleGrid.getPotentialContacts(particlePairs);
+    } else {
+        particlePairsUsed = 0;
+    }
+}
+
+void PhysicsWorld::moveToTimesOfImpact() {
+    for (unsigned int i = 0; i < potentialContactsUsed; i++) {
+        RigidBody** bodies = potentialContacts[i].bodies;
+        if (!bodies[0]->usesContinuousCollision() && !bodies[1]->usesContinuousCollision()) { continue; }
+        if (!bodies[0]->hasFiniteMass() && !bodies[1]->hasFiniteMass()) { continue; }
+
+        real time;
+        if (!ContinuousCollision::timeOfImpact(bodies[0], bodies[1], time)) { continue; }
+
+        // Each body stops at the first thing it hits
+        for (int b = 0; b < 2; b++) {
+            RigidBody* body = bodies[b];
+            if (!body->usesContinuousCollision()) { continue; }
+            real& impactTime = impactTimes[body->getWorldIndex()];
+            if (impactTime == REAL_MAX) { impactedBodies.push_back(body); }
+            impactTime = std::min(impactTime, time);
+        }
+    }
+
+    for (RigidBody* body : impactedBodies) {
+        real& impactTime = impactTimes[body->getWorldIndex()];
+        ContinuousCollision::moveToTime(body, impactTime);
+        impactTime = REAL_MAX;
+    }
+    impactedBodies.clear();
+}
+
+unsigned int PhysicsWorld::generateParticleContacts(PhysicsContact *contact, unsigned int limit) const {
+    unsigned int used = 0;
+    for (unsigned int i = 0; i < particlePairsUsed && used < limit; i++) {
+        PhysicsObject *p1 = particlePairs[i].objects[0], *p2 = particlePairs[i].objects[1];
+
+        // Two immovable particles can't resolve a contact
+        if (!p1->hasFiniteMass() && !p2->hasFiniteMass()) { continue; }
+
+        // The normal points from the second particle towards the first
+        Vector3 offset = p1->getPosition() - p2->getPosition();
+        real distance = offset.magnitude();
+        real penetration = 2 * Particle::RADIUS - distance;
+        if (penetration < 0) { continue; }
+
+        contact->objects[0] = p1;
+        contact->objects[1] = p2;
+        contact->contactNormal = distance > 0 ? offset / distance : Vector3::UP;
+        contact->penetration = penetration;
+        contact->contactPoint = p2->getPosition() + offset * (real)0.5;
+        contact->featureId = 0;
+        contact->restitution = particleRestitution;
+        contact++;
+        used++;
+    }
+    return used;
+}
+
 unsigned int PhysicsWorld::generateContacts() {
     unsigned int limit = maxContacts;
     PhysicsContact* nextContact = contacts;
@@ -85,15 +166,96 @@ unsigned int PhysicsWorld::generateContacts() {
         if (limit <= 0) { break; }
     }
 
+    // Then every object against the half-spaces and the distance fields
+    if (limit > 0) {
+        unsigned int used = halfSpaces.addContacts(particles, bodies, nextContact, limit);
+        limit -= used;
+        nextContact += used;
+    }
+    if (limit > 0) {
+        unsigned int used = distanceFields.addContacts(particles, bodies, nextContact, limit);
+        limit -= used;
+        nextContact += used;
+    }
+
+    // Then the collisions between particles
+    if (limit > 0) {
+        unsigned int used = generateParticleContacts(nextContact, limit);
+        limit -= used;
+        nextContact += used;
+    }
+
+    // Then run the narrow phase on the broad phase's pairs
+    if (narrowphase) {
+        narrowphase->beginStep();
+        for (unsigned int i = 0; i < potentialContactsUsed && limit > 0; i++) {
+            RigidBody** bodies = potentialContacts[i].bodies;
+
+            // Two immovable bodies can't resolve a contact
+            if (!bodies[0]->hasFiniteMass() && !bodies[1]->hasFiniteMass()) { continue; }
+
+            unsigned int used = narrowphase->addContact(bodies[0], bodies[1], nextContact, limit);
+            limit -= used;
+            nextContact += used;
+        }
+    }
+
     // Return the number of contacts used
     return maxContacts - limit;
 
 }
 
-void PhysicsWorld::addObject(PhysicsObject *object) { objects.push_back(object); }
+void PhysicsWorld::addObject(PhysicsObject *object) {
+    object->setWorldIndex(objects.size());
+    objects.push_back(object);
+    impactTimes.push_back(REAL_MAX);
+    if (auto body = dynamic_cast<RigidBody*>(object)) {
+        bodies.push_back(body);
+        broadphase->insert(body);
+    } else if (auto particle = dynamic_cast<Particle*>(object)) {
+        particles.push_back(particle);
+        particleGrid.insert(particle);
+    }
+}
 
 void PhysicsWorld::addForceGenerator(ForceGenerator *fg) { forces.push_back(fg); }
 
 void PhysicsWorld::applyForceToObject(PhysicsObject *obj, ForceGenerator *fg) { forceRegistry.add(obj, fg); }
 
 void PhysicsWorld::addContactGenerator(ContactGenerator* cg) { contactGenerators.push_back(cg); }
+
+void PhysicsWorld::setBroadphase(Broadphase* bp) {
+    delete broadphase;
+    broadphase = bp;
+    for (RigidBody* body : bodies) { broadphase->insert(body); }
+}
+
+void PhysicsWorld::setContactResolver(PhysicsContactResolver* resolver) {
+    delete contactResolver;
+    contactResolver = resolver;
+}
+
+void PhysicsWorld::setParticleCollisions(bool enabled, real restitution) {
+    particleCollisions = enabled;
+    particleRestitution = restitution;
+}
+
+void PhysicsWorld::addHalfSpace(Vector3 normal, real offset, real restitution) { halfSpaces.add(normal, offset, restitution); }
+
+void PhysicsWorld::addDistanceField(const Shape &shape, real cellSize, real band, real restitution) {
+    distanceFields.add(shape, cellSize, band, restitution);
+}
+
+void PhysicsWorld::setNarrowphase(PairContactGenerator* pcg) { narrowphase = pcg; }
+
+void PhysicsWorld::cast(const CastQuery *queries, unsigned int count, CastHit *hits) const {
+    SpatialQuery::cast(*broadphase, queries, count, hits);
+}
+
+void PhysicsWorld::overlap(const BoundingSphere *spheres, unsigned int count, RigidBody **bodies, unsigned int maxPerSphere, unsigned int *counts) const {
+    SpatialQuery::overlap(*broadphase, spheres, count, bodies, maxPerSphere, counts);
+}
+
+unsigned int PhysicsWorld::getPotentialContactCount() const { return potentialContactsUsed; }
+
+unsigned int PhysicsWorld::getContactCount() const { return contactsUsed; }
@@ -5,6 +5,10 @@
 #include "ForceRegistry.h"
 #include "PhysicsContactResolver.h"
 #include "ContactGenerator.h"
+#include "SpatialHashGrid.h"
+#include "SpatialQuery.h"
+#include "HalfSpaceCollider.h"
+#include "DistanceFieldCollider.h"
 
 class PhysicsWorld {
 
@@ -13,7 +17,81 @@ private:
     std::vector<ForceGenerator*> forces;
     std::vector<ContactGenerator*> contactGenerators;
     ForceRegistry forceRegistry;
-    ParticleContactResolver contactResolver;
+
+    /*
+     * Resolves the contacts each step. Owned by the world.
+     */
+    PhysicsContactResolver* contactResolver;
+
+    /*
+     * Holds the RigidBodies among the objects, which
+     * take part in the broad phase.
+     */
+    std::vector<RigidBody*> bodies;
+
+    /*
+     * Holds the Particles among the objects.
+     */
+    std::vector<Particle*> particles;
+
+    /*
+     * Holds the half-spaces every object collides with.
+     */
+    HalfSpaceCollider halfSpaces;
+
+    /*
+     * Holds the static scenery every object collides with.
+     */
+    DistanceFieldCollider distanceFields;
+
+    /*
+     * Holds every RigidBody in the world for finding
+     * pairs that might be colliding. Owned by the world.
+     * Defaults to a SplitBroadphase, so static bodies
+     * cost nothing to update.
+     */
+    Broadphase* broadphase;
+
+    /*
+     * Creates contacts for the pairs the broad phase finds.
+     * If null, the pairs are still found but not used.
+     */
+    PairContactGenerator* narrowphase;
+
+    /*
+     * Holds every Particle in the world for finding ones that
+     * overlap, when particle collisions are turned on.
+     */
+    SpatialHashGrid particleGrid;
+    bool particleCollisions;
+    real particleRestitution;
+
+    /*
+     * Holds the pairs found by the broad phase. Grows to fit
+     * every pair, and keeps its memory between updates.
+     */
+    std::vector<PotentialContact> potentialContacts;
+
+    /*
+     * Holds the pairs of overlapping Particles found by the particle
+     * grid. Grows to fit every pair, like potentialContacts.
+     */
+    std::vector<ObjectPair> particlePairs;
+
+    /*
+     * Holds the earliest time of impact found this step for each
+     * object, by its world index, or REAL_MAX if it didn't hit
+     * anything. Only the bodies listed in impactedBodies are set,
+     * and they are reset once the bodies have been moved.
+     */
+    std::vector<real> impactTimes;
+    std::vector<RigidBody*> impactedBodies;
+
+    /*
+     * These are performance tracking values; we keep a record of
+     * the number of pairs and contacts found in the last update.
+     */
+    unsigned int potentialContactsUsed, particlePairsUsed, contactsUsed;
 
     /*
      * Holds the maximum number of allowed contacts
@@ -33,11 +111,34 @@ private:
     bool calculateContactIterations;
 
     /*
-     * Calls each of the registered contact generators to report
-     * their contacts. Returns the number of generated contacts.
+     * Updates the broad phase with the bodies' new positions and
+     * collects the pairs of bodies that might be touching.
+     */
+    void findPotentialContacts();
+
+    /*
+     * Finds the potential contacts involving bodies with continuous
+     * collision that passed into each other during the step, and moves
+     * those bodies back to the earliest time they hit something. They
+     * lose the rest of the step's motion, but then overlap just enough
+     * for the narrow phase to stop them.
+     */
+    void moveToTimesOfImpact();
+
+    /*
+     * Calls each of the registered contact generators, then tests every
+     * object against the world's half-spaces, then creates the contacts
+     * between overlapping Particles, and then runs the narrow phase for
+     * each potential contact. Returns the number of generated contacts.
      */
     unsigned int generateContacts();
 
+    /*
+     * Writes a contact for each overlapping pair of Particles found
+     * this step, in one pass. Returns the number of contacts written.
+     */
+    unsigned int generateParticleContacts(PhysicsContact* contact, unsigned int limit) const;
+
 public:
     /*
      * Creates a new simulator that can handle up to the given number of contacts
@@ -62,7 +163,8 @@ public:
 
 
     /*
-     * Adds a PhysicsObject to the world.
+     * Adds a PhysicsObject to the world. RigidBodies are
+     * also added to the broad phase.
      */
     void addObject(PhysicsObject* object);
 
@@ -80,6 +182,70 @@ public:
      * Adds a ContactGenerator to the world.
      */
     void addContactGenerator(ContactGenerator* cg);
+
+    /*
+     * Replaces the broad phase, moving every RigidBody into the new one.
+     * The world takes ownership of it and deletes the old one.
+     */
+    void setBroadphase(Broadphase* bp);
+
+    /*
+     * Replaces the contact resolver. The world takes ownership of it
+     * and deletes the old one. If the world calculates the number of
+     * contact iterations, it sets the new resolver's each step too.
+     */
+    void setContactResolver(PhysicsContactResolver* resolver);
+
+    /*
+     * Sets the narrow phase used on the broad phase's potential
+     * contacts. The world does not take ownership of it.
+     */
+    void setNarrowphase(PairContactGenerator* pcg);
+
+    /*
+     * Turns collisions between every pair of Particles on or off.
+     * Colliding Particles bounce apart with the given restitution.
+     */
+    void setParticleCollisions(bool enabled, real restitution = 0.5);
+
+    /*
+     * Adds the half-space of points p where normal.dot(p) <= offset, such
+     * as the ground, which every Particle and RigidBody collides with.
+     * Much faster than a ContactGenerator per object when there are many.
+     */
+    void addHalfSpace(Vector3 normal, real offset, real restitution);
+
+    /*
+     * Adds static scenery, as the DistanceField of a Shape in world space,
+     * which every Particle and RigidBody collides with. Baking the field
+     * takes a while, so this is best done when a level is loaded. See
+     * DistanceFieldCollider::add for choosing the band.
+     */
+    void addDistanceField(const Shape& shape, real cellSize, real band, real restitution);
+
+    /*
+     * Finds the first RigidBody hit by each of a batch of rays and sphere
+     * casts, writing it into the matching element of hits. The batch is
+     * split across the shared ThreadPool. See SpatialQuery.
+     */
+    void cast(const CastQuery* queries, unsigned int count, CastHit* hits) const;
+
+    /*
+     * Finds the RigidBodies overlapping each of a batch of spheres. The
+     * bodies found for sphere i are written from bodies[i*maxPerSphere]
+     * onwards, and how many there are into counts[i]. See SpatialQuery.
+     */
+    void overlap(const BoundingSphere* spheres, unsigned int count, RigidBody** bodies, unsigned int maxPerSphere, unsigned int* counts) const;
+
+    /*
+     * Returns the number of pairs the broad phase found in the last update.
+     */
+    unsigned int getPotentialContactCount() const;
+
+    /*
+     * Returns the number of contacts generated in the last update.
+     */
+    unsigned int getContactCount() const;
 };
 
 
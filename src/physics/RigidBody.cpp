@@ -1,41 +1,76 @@
 #include "RigidBody.h"
 
+#include <algorithm>
+
 const real RigidBody::ANGULAR_DAMPING(0.9f);
 
-void RigidBody::calculateDerivedData() {
-    orientation.normalize();
+void RigidBody::invalidateDerivedData(bool orientationChanged) {
+    transformDirty = inverseTransformDirty = true;
+    if (orientationChanged) { inertiaDirty = true; }
+}
+
+const Matrix4& RigidBody::getTransformMatrix() const {
+    if (transformDirty) {
+        transformMatrix = Matrix4().translate(position).rotate(orientation);
+        transformDirty = false;
+    }
+    return transformMatrix;
+}
 
-    // Calculate the transform matrix for the body
-    transformMatrix = Matrix4().translate(position).rotate(orientation);
-    inverseInertiaTensorWorld = Matrix4().rotate(orientation).multiply(model->getInverseInertiaTensor(inverseMass)).multiply(Matrix4().rotate(orientation).inverse());
+const Matrix4& RigidBody::getInverseTransformMatrix() const {
+    if (inverseTransformDirty) {
+        // The transform is a rotation followed by a translation, so its
+        // inverse is the transposed rotation applied after undoing the translation
+        inverseTransformMatrix = Matrix4().rotate(orientation).transpose().translate(-position);
+        inverseTransformDirty = false;
+    }
+    return inverseTransformMatrix;
+}
+
+const Matrix4& RigidBody::getInverseInertiaTensorWorld() const {
+    if (inertiaDirty) {
+        // Rotation matrices are orthogonal, so the transpose is the inverse
+        Matrix4 rotation = Matrix4().rotate(orientation);
+        inverseInertiaTensorWorld = Matrix4(rotation).multiply(inverseInertiaTensor).multiply(rotation.transpose());
+        inertiaDirty = false;
+    }
+    return inverseInertiaTensorWorld;
 }
 
 RigidBody::RigidBody(Vector3 pos, Vector3 vel, Quaternion dir, Vector3 rot, real inverseMass, bool damping, RigidBodyModel* model, Shape shape)
-        : PhysicsObject(pos, vel, inverseMass, damping, shape), orientation(dir), angularVelocity(rot), model(model) {
-    calculateDerivedData();
+        : PhysicsObject(pos, vel, inverseMass, damping, shape), orientation(dir), angularVelocity(rot), model(model),
+          continuousCollision(false), broadphaseNode(nullptr) {
+    inverseInertiaTensor = model->getInverseInertiaTensor(inverseMass);
+    orientation.normalize();
+    previousPosition = position;
+    previousOrientation = orientation;
+    invalidateDerivedData();
 }
 
 RigidBody::RigidBody(Vector3 pos, Vector3 vel, Quaternion dir, Vector3 rot, real inverseMass, bool damping, RigidBodyModel* model, VertexColor color)
         : RigidBody(pos, vel, dir, rot, inverseMass, damping, model, model->getMatchingShape(color)) {}
 
 Matrix4 RigidBody::getShapeMatrix() const {
-    return transformMatrix;
+    return getTransformMatrix();
 }
 
 void RigidBody::update(real deltaTime) {
+    previousPosition = position;
+    previousOrientation = orientation;
     if (!hasFiniteMass()) {return;}
 
     // Update angular velocity/position
-    Vector3 angularAcceleration = inverseInertiaTensorWorld.multiply(Vector4(torqueAccumulator,1 ));
+    Vector3 angularAcceleration = getInverseInertiaTensorWorld().multiply(Vector4(torqueAccumulator,1 ));
     angularVelocity += angularAcceleration * deltaTime;
     orientation.addScaledVector(angularVelocity*deltaTime);
+    orientation.normalize();
 
     if (damping) { angularVelocity *= real_pow(ANGULAR_DAMPING, deltaTime); }
 
     // Update linear velocity/position and clear accumulators
     PhysicsObject::update(deltaTime);
 
-    calculateDerivedData();
+    invalidateDerivedData();
 
 }
 
@@ -56,20 +91,89 @@ void RigidBody::addForceAtBodyPoint(Vector3 force, Vector3 relPos) {
 }
 
 Vector3 RigidBody::getPointInWorldSpace(Vector3 bodyPos) {
-    return transformMatrix.multiply(Vector4(bodyPos, 1));
+    return getTransformMatrix().multiply(Vector4(bodyPos, 1));
 }
 
 Vector3 RigidBody::getPointInBodySpace(Vector3 worldPos) {
-    return transformMatrix.inverse().multiply(Vector4(worldPos, 1));
+    return getInverseTransformMatrix().multiply(Vector4(worldPos, 1));
 }
 
 Quaternion RigidBody::getOrientation() const {
     return orientation;
 }
 
+Vector3 RigidBody::getAngularVelocity() const {
+    return angularVelocity;
+}
+
+Vector3 RigidBody::getVelocityAtPoint(const Vector3 &point) const {
+    return velocity + angularVelocity.cross(point - position);
+}
+
+real RigidBody::getInverseMassAtPoint(const Vector3 &point, const Vector3 &direction) const {
+    // The impulse's torque turns the body, which also moves the point
+    Vector3 arm = point - position;
+    Vector3 angularChange = Vector3(getInverseInertiaTensorWorld().multiply(arm.cross(direction), 0));
+    return inverseMass + angularChange.cross(arm).dot(direction);
+}
+
+void RigidBody::applyImpulse(const Vector3 &impulse, const Vector3 &point) {
+    if (!hasFiniteMass()) { return; }
+    velocity += impulse * inverseMass;
+    angularVelocity += Vector3(getInverseInertiaTensorWorld().multiply((point - position).cross(impulse), 0));
+}
+
 void RigidBody::setPosition(Vector3 vel) {
     PhysicsObject::setPosition(vel);
-    calculateDerivedData();
+    invalidateDerivedData(false);
+}
+
+void RigidBody::setOrientation(Quaternion dir) {
+    orientation = dir;
+    orientation.normalize();
+    invalidateDerivedData();
+}
+
+Vector3 RigidBody::getPreviousPosition() const {
+    return previousPosition;
+}
+
+Quaternion RigidBody::getPreviousOrientation() const {
+    return previousOrientation;
+}
+
+void RigidBody::setContinuousCollision(bool enabled) {
+    continuousCollision = enabled;
+}
+
+bool RigidBody::usesContinuousCollision() const {
+    return continuousCollision;
+}
+
+void RigidBody::setCollisionFilter(const CollisionFilter &filter) {
+    collisionFilter = filter;
+}
+
+const CollisionFilter& RigidBody::getCollisionFilter() const {
+    return collisionFilter;
+}
+
+void RigidBody::ignoreCollisionsWith(RigidBody *other) {
+    if (std::find(ignoredBodies.begin(), ignoredBodies.end(), other) != ignoredBodies.end()) { return; }
+    ignoredBodies.push_back(other);
+    other->ignoredBodies.push_back(this);
+}
+
+void RigidBody::stopIgnoringCollisionsWith(RigidBody *other) {
+    ignoredBodies.erase(std::remove(ignoredBodies.begin(), ignoredBodies.end(), other), ignoredBodies.end());
+    other->ignoredBodies.erase(std::remove(other->ignoredBodies.begin(), other->ignoredBodies.end(), this), other->ignoredBodies.end());
+}
+
+bool RigidBody::canCollideWith(const RigidBody *other) const {
+    if (!collisionFilter.collidesWith(other->collisionFilter)) { return false; }
+
+    // Bodies only ignore a few others, so a linear search is quickest
+    return std::find(ignoredBodies.begin(), ignoredBodies.end(), other) == ignoredBodies.end();
 }
 
 BoundingSphere RigidBody::getBoundingSphere() const {
@@ -78,6 +182,16 @@ BoundingSphere RigidBody::getBoundingSphere() const {
     return sphere;
 }
 
+BoundingSphere RigidBody::getSweptBoundingSphere() const {
+    BoundingSphere sphere = getBoundingSphere();
+    if (!continuousCollision) { return sphere; }
+
+    // The model's sphere is centered on the body, so only the position moves it
+    BoundingSphere previous = sphere;
+    previous.center += previousPosition - position;
+    return BoundingSphere(previous, sphere);
+}
+
 const RigidBodyModel* RigidBody::getModel() const {
     return model;
 }
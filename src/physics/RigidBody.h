@@ -1,6 +1,7 @@
 #ifndef PHYSICSENGINE_RIGIDBODY_H
 #define PHYSICSENGINE_RIGIDBODY_H
 
+#include <vector>
 #include "PhysicsObject.h"
 #include "../math/Quaternion.h"
 #include "RigidBodyModel.h"
@@ -25,10 +26,36 @@ protected:
     /*
      * Holds the matrix for converting between body space
      * and world space. Used via the getPointIn__Space functions.
+     * Derived from the position and orientation on demand; read
+     * it through getTransformMatrix().
      */
-    Matrix4 transformMatrix;
+    mutable Matrix4 transformMatrix;
 
-    Matrix4 inverseInertiaTensorWorld;
+    /*
+     * Holds the inverse of transformMatrix, for converting from
+     * world space into body space. Read it through
+     * getInverseTransformMatrix().
+     */
+    mutable Matrix4 inverseTransformMatrix;
+
+    /*
+     * Holds the inverse inertia tensor in body space. This only
+     * depends on the model and the mass, so it is calculated once.
+     */
+    Matrix4 inverseInertiaTensor;
+
+    /*
+     * Holds the inverse inertia tensor in world space. Derived from
+     * the orientation on demand; read it through
+     * getInverseInertiaTensorWorld().
+     */
+    mutable Matrix4 inverseInertiaTensorWorld;
+
+    /*
+     * Track which pieces of derived data are out of date with
+     * the body's state and need recalculating before being read.
+     */
+    mutable bool transformDirty, inverseTransformDirty, inertiaDirty;
 
     /*
      * Stores the physical geometry of the RigidBody
@@ -41,11 +68,47 @@ protected:
     Vector3 torqueAccumulator;
 
     /*
-     * Calculates internal data from state data. Should be called
-     * after the body's state is directly altered (automatically
-     * happens during updates).
+     * Holds where the body was at the start of its last update, so
+     * its motion over the step can be swept.
+     */
+    Vector3 previousPosition;
+    Quaternion previousOrientation;
+
+    /*
+     * Whether the body's motion is swept for collisions, so it can't
+     * pass through other bodies between steps.
+     */
+    bool continuousCollision;
+
+    /*
+     * Holds which other bodies this one collides with.
+     */
+    CollisionFilter collisionFilter;
+
+    /*
+     * Holds the bodies this one never collides with, whatever their
+     * filters, such as the bodies it's linked to.
+     */
+    std::vector<const RigidBody*> ignoredBodies;
+
+    /*
+     * Holds this body's leaf in a BVHTree, so the tree can find
+     * it without searching. Managed by the tree.
+     */
+    BVHTreeNode* broadphaseNode;
+    template<typename Volume> friend class BVHTree;
+
+    /*
+     * Marks the internal data derived from the position and
+     * orientation as out of date, so that it is recalculated the
+     * next time it is read. Should be called after the body's state
+     * is directly altered (automatically happens during updates).
+     * Pass false for orientationChanged if only the position moved.
      */
-    void calculateDerivedData();
+    void invalidateDerivedData(bool orientationChanged = true);
+
+    const Matrix4& getInverseTransformMatrix() const;
+    const Matrix4& getInverseInertiaTensorWorld() const;
 
     void clearAccumulators() override;
 
@@ -58,8 +121,31 @@ public:
     RigidBody(Vector3 pos, Vector3 vel, Quaternion dir, Vector3 rot, real inverseMass, bool damping, RigidBodyModel* model, VertexColor color);
 
     Quaternion getOrientation() const;
+    Vector3 getAngularVelocity() const;
+
+    /*
+     * Returns the matrix converting body space to world space. Its first
+     * three columns are the body's axes and the fourth is its position.
+     */
+    const Matrix4& getTransformMatrix() const;
 
     void setPosition(Vector3 vel) override;
+    void setOrientation(Quaternion dir);
+
+    Vector3 getPreviousPosition() const;
+    Quaternion getPreviousOrientation() const;
+
+    /*
+     * Turns continuous collision detection on or off for the body. Fast,
+     * small bodies like projectiles need it to avoid tunneling through
+     * thin bodies when the step is long. Off by default.
+     */
+    void setContinuousCollision(bool enabled);
+    bool usesContinuousCollision() const;
+
+    Vector3 getVelocityAtPoint(const Vector3& point) const override;
+    real getInverseMassAtPoint(const Vector3& point, const Vector3& direction) const override;
+    void applyImpulse(const Vector3& impulse, const Vector3& point) override;
 
     void addForceAtPoint(Vector3 force, Vector3 pos) override;
     void addForceAtBodyPoint(Vector3 force, Vector3 relPos) override;
@@ -68,7 +154,35 @@ public:
     Vector3 getPointInWorldSpace(Vector3 bodyPos) override;
     Vector3 getPointInBodySpace(Vector3 worldPos) override;
 
+    /*
+     * Sets which other bodies this one collides with. Broad phases
+     * pick up the change the next time they update.
+     */
+    void setCollisionFilter(const CollisionFilter& filter);
+    const CollisionFilter& getCollisionFilter() const;
+
+    /*
+     * Stops or restarts collisions between this body and another,
+     * whatever their filters. Affects both bodies.
+     */
+    void ignoreCollisionsWith(RigidBody* other);
+    void stopIgnoringCollisionsWith(RigidBody* other);
+
+    /*
+     * Returns whether this body and another can collide, according to
+     * their filters and the bodies they ignore.
+     */
+    bool canCollideWith(const RigidBody* other) const;
+
     BoundingSphere getBoundingSphere() const override;
+
+    /*
+     * Returns the volume the broad phase should use for the body. With
+     * continuous collision, it covers the body's whole motion over the
+     * last step; otherwise it's just the bounding sphere.
+     */
+    BoundingSphere getSweptBoundingSphere() const;
+
     const RigidBodyModel* getModel() const;
 
 };
@@ -1,7 +1,17 @@
 
 #include "RigidBodyModel.h"
 
-RigidBodyModel::RigidBodyModel() {}
+#include <algorithm>
+#include <vector>
+
+RigidBodyModel::RigidBodyModel(unsigned int type) : boundingSphere(Vector3(), 0), type(type) {}
+
+unsigned int RigidBodyModel::registerType() {
+    static unsigned int nextType = BUILT_IN_TYPES;
+    return nextType < MAX_TYPES ? nextType++ : MAX_TYPES;
+}
+
+unsigned int RigidBodyModel::getType() const { return type; }
 
 Matrix4 RigidBodyModel::getInverseInertiaTensor(real inverseMass) {
     return Matrix4();
@@ -13,10 +23,20 @@ Shape RigidBodyModel::getMatchingShape(VertexColor color) {
 
 BoundingSphere RigidBodyModel::getBoundingSphere() const { return boundingSphere; }
 
-RectangularPrismModel::RectangularPrismModel(real xLen, real yLen, real zLen) : xLen(xLen), yLen(yLen), zLen(zLen) {
+Vector3 RigidBodyModel::getCoreSupportPoint(const Vector3 &) const { return boundingSphere.center; }
+
+real RigidBodyModel::getMargin() const { return boundingSphere.radius; }
+
+Vector3 RigidBodyModel::getSupportPoint(const Vector3 &direction) const {
+    return getCoreSupportPoint(direction) + direction.normalized() * getMargin();
+}
+
+RectangularPrismModel::RectangularPrismModel(real xLen, real yLen, real zLen) : RigidBodyModel(BOX), xLen(xLen), yLen(yLen), zLen(zLen) {
     boundingSphere = BoundingSphere(Vector3(), (real)0.5 * sqrt(xLen*xLen + yLen*yLen + zLen*zLen));
 }
 
+Vector3 RectangularPrismModel::getHalfSize() const { return Vector3(xLen, yLen, zLen) * (real)0.5; }
+
 Matrix4 RectangularPrismModel::getInverseInertiaTensor(real inverseMass) {
     return Matrix4(12*inverseMass/(yLen*yLen + zLen*zLen), 0, 0, 0,
                    0, 12*inverseMass/(xLen*xLen + zLen*zLen), 0, 0,
@@ -28,9 +48,235 @@ Shape RectangularPrismModel::getMatchingShape(VertexColor color) {
     return Shape::rectangularPrism(Vector3(0,0,0), xLen, yLen, zLen, color, true);
 }
 
+Vector3 RectangularPrismModel::getCoreSupportPoint(const Vector3 &direction) const {
+    return Vector3(direction.x < 0 ? -xLen/2 : xLen/2, direction.y < 0 ? -yLen/2 : yLen/2, direction.z < 0 ? -zLen/2 : zLen/2);
+}
+
+real RectangularPrismModel::getMargin() const { return 0; }
+
+SphereModel::SphereModel(real radius) : RigidBodyModel(SPHERE), radius(radius) {
+    boundingSphere = BoundingSphere(Vector3(), radius);
+}
+
+real SphereModel::getRadius() const { return radius; }
+
+Matrix4 SphereModel::getInverseInertiaTensor(real inverseMass) {
+    real inverseMoment = 5*inverseMass/(2*radius*radius);
+    return Matrix4(inverseMoment, 0, 0, 0,
+                   0, inverseMoment, 0, 0,
+                   0, 0, inverseMoment, 0,
+                   0, 0, 0, 1);
+}
+
+Shape SphereModel::getMatchingShape(VertexColor color) {
+    return Shape::icosphere(Vector3(), radius, color, 2);
+}
+
+real SphereModel::getMargin() const { return radius; }
+
+CapsuleModel::CapsuleModel(real radius, real height) : RigidBodyModel(CAPSULE), radius(radius), height(height) {
+    boundingSphere = BoundingSphere(Vector3(), radius + height/2);
+}
+
+real CapsuleModel::getRadius() const { return radius; }
+
+real CapsuleModel::getHalfHeight() const { return height/2; }
+
+Matrix4 CapsuleModel::getInverseInertiaTensor(real inverseMass) {
+    // Split the mass between the cylinder and the two hemispheres by volume
+    real cylinderVolume = (real)M_PI * radius*radius * height;
+    real sphereVolume = (real)(4*M_PI/3) * radius*radius*radius;
+    real cylinderShare = cylinderVolume / (cylinderVolume + sphereVolume);
+    real sphereShare = 1 - cylinderShare;
+
+    // The moments per unit of mass. Each hemisphere's center of mass
+    // sits 3/8 of the radius beyond the end of the cylinder
+    real axial = cylinderShare*radius*radius/2 + sphereShare*radius*radius*2/5;
+    real transverse = cylinderShare*(radius*radius/4 + height*height/12)
+                    + sphereShare*(radius*radius*2/5 + height*height/4 + 3*height*radius/8);
+    return Matrix4(inverseMass/transverse, 0, 0, 0,
+                   0, inverseMass/axial, 0, 0,
+                   0, 0, inverseMass/transverse, 0,
+                   0, 0, 0, 1);
+}
+
+Shape CapsuleModel::getMatchingShape(VertexColor color) {
+    return Shape::capsule(Vector3(), radius, height, color, 2);
+}
+
+Vector3 CapsuleModel::getCoreSupportPoint(const Vector3 &direction) const {
+    return Vector3(0, direction.y < 0 ? -height/2 : height/2, 0);
+}
+
+real CapsuleModel::getMargin() const { return radius; }
+
+ConvexHullModel::ConvexHullModel(const Shape &shape) : RigidBodyModel(CONVEX_HULL), shape(shape) {
+    real radius = 0;
+    for (unsigned int i = 0; i < shape.numVertices(); i++) {
+        radius = std::max(radius, shape.getVertexPositions()[i].magnitude());
+    }
+    boundingSphere = BoundingSphere(Vector3(), radius);
+}
+
+Matrix4 ConvexHullModel::getInverseInertiaTensor(real inverseMass) {
+    // Sum the covariance of the tetrahedra joining the origin to each triangle
+    const Vector3* positions = shape.getVertexPositions();
+    const GLuint* indices = shape.getIndices();
+    real volume = 0;
+    real covariance[3][3] = {};
+    for (unsigned int i = 0; i + 2 < shape.numIndices(); i += 3) {
+        const Vector3 &a = positions[indices[i]], &b = positions[indices[i+1]], &c = positions[indices[i+2]];
+        real determinant = a.dot(b.cross(c));
+        volume += determinant / 6;
+
+        Vector3 sum = a + b + c;
+        real p[4][3] = {{a.x, a.y, a.z}, {b.x, b.y, b.z}, {c.x, c.y, c.z}, {sum.x, sum.y, sum.z}};
+        for (int r = 0; r < 3; r++) {
+            for (int col = 0; col < 3; col++) {
+                real total = 0;
+                for (int v = 0; v < 4; v++) { total += p[v][r] * p[v][col]; }
+                covariance[r][col] += determinant / 120 * total;
+            }
+        }
+    }
+
+    // Turn the covariance into the inertia tensor for a unit of mass, then scale its inverse to the body's mass
+    real trace = covariance[0][0] + covariance[1][1] + covariance[2][2];
+    Matrix4 inertia;
+    for (int r = 0; r < 3; r++) {
+        for (int col = 0; col < 3; col++) {
+            inertia.setEntry(((r == col ? trace : 0) - covariance[r][col]) / volume, r, col);
+        }
+    }
+    Matrix4 inverse = inertia.inverse();
+    for (int r = 0; r < 3; r++) {
+        for (int col = 0; col < 3; col++) {
+            inverse.setEntry(inverse.getEntry(r, col) * inverseMass, r, col);
+        }
+    }
+    return inverse;
+}
+
+Shape ConvexHullModel::getMatchingShape(VertexColor color) {
+    std::vector<VertexColor> colors(shape.numVertices(), color);
+    return Shape(shape.numVertices(), shape.getVertexPositions(), colors.data(), shape.numIndices(), shape.getIndices(), shape.isFlatShaded());
+}
+
+Vector3 ConvexHullModel::getCoreSupportPoint(const Vector3 &direction) const {
+    const Vector3* positions = shape.getVertexPositions();
+    Vector3 best = positions[0];
+    real bestDistance = direction.dot(best);
+    for (unsigned int i = 1; i < shape.numVertices(); i++) {
+        real distance = direction.dot(positions[i]);
+        if (distance > bestDistance) { bestDistance = distance; best = positions[i]; }
+    }
+    return best;
+}
+
+real ConvexHullModel::getMargin() const { return 0; }
+
+TriangleMeshModel::TriangleMeshModel(const Shape &shape) : RigidBodyModel(TRIANGLE_MESH), shape(shape) {
+    const Vector3* positions = shape.getVertexPositions();
+    real radius = 0;
+    for (unsigned int i = 0; i < shape.numVertices(); i++) {
+        radius = std::max(radius, positions[i].magnitude());
+    }
+    boundingSphere = BoundingSphere(Vector3(), radius);
+
+    const GLuint* indices = shape.getIndices();
+    for (unsigned int i = 0; i + 2 < shape.numIndices(); i += 3) {
+        triangles.push_back({{indices[i], indices[i+1], indices[i+2]}});
+    }
+    if (triangles.empty()) { return; }
+    nodes.reserve(2 * triangles.size());
+    buildNode(0, triangles.size());
+}
+
+static real component(const Vector3& v, unsigned int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+unsigned int TriangleMeshModel::buildNode(unsigned int begin, unsigned int end) {
+    unsigned int index = nodes.size();
+    nodes.emplace_back();
+
+    // Bound the triangles, and their centroids for choosing a split
+    const Vector3* positions = shape.getVertexPositions();
+    Vector3 min(REAL_MAX, REAL_MAX, REAL_MAX), max(-REAL_MAX, -REAL_MAX, -REAL_MAX);
+    Vector3 low = min, high = max;
+    for (unsigned int t = begin; t < end; t++) {
+        Vector3 centroid;
+        for (unsigned int v : triangles[t].vertices) {
+            const Vector3& p = positions[v];
+            min = Vector3(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+            max = Vector3(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+            centroid += p;
+        }
+        low = Vector3(std::min(low.x, centroid.x), std::min(low.y, centroid.y), std::min(low.z, centroid.z));
+        high = Vector3(std::max(high.x, centroid.x), std::max(high.y, centroid.y), std::max(high.z, centroid.z));
+    }
+    nodes[index].min = min;
+    nodes[index].max = max;
+
+    unsigned int count = end - begin;
+    if (count <= MAX_LEAF_SIZE) {
+        nodes[index].index = begin;
+        nodes[index].count = count;
+        return index;
+    }
+
+    // Halve the triangles along the axis their centroids spread furthest over
+    Vector3 extent = high - low;
+    unsigned int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    auto centroidOf = [&](const Triangle& t) {
+        return component(positions[t.vertices[0]], axis) + component(positions[t.vertices[1]], axis) + component(positions[t.vertices[2]], axis);
+    };
+    unsigned int middle = begin + count / 2;
+    std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end,
+                     [&](const Triangle& a, const Triangle& b) { return centroidOf(a) < centroidOf(b); });
+
+    buildNode(begin, middle);
+    unsigned int second = buildNode(middle, end);
+    nodes[index].index = second;
+    nodes[index].count = 0;
+    return index;
+}
+
+Matrix4 TriangleMeshModel::getInverseInertiaTensor(real) {
+    return Matrix4(0, 0, 0, 0,
+                   0, 0, 0, 0,
+                   0, 0, 0, 0,
+                   0, 0, 0, 1);
+}
+
+Shape TriangleMeshModel::getMatchingShape(VertexColor color) {
+    std::vector<VertexColor> colors(shape.numVertices(), color);
+    return Shape(shape.numVertices(), shape.getVertexPositions(), colors.data(), shape.numIndices(), shape.getIndices(), shape.isFlatShaded());
+}
+
+Vector3 TriangleMeshModel::getCoreSupportPoint(const Vector3 &direction) const {
+    if (nodes.empty()) { return Vector3(); }
+    const Node& root = nodes[0];
+    return Vector3(direction.x < 0 ? root.min.x : root.max.x, direction.y < 0 ? root.min.y : root.max.y, direction.z < 0 ? root.min.z : root.max.z);
+}
+
+real TriangleMeshModel::getMargin() const { return 0; }
+
+unsigned int TriangleMeshModel::getTriangleCount() const { return triangles.size(); }
+
+void TriangleMeshModel::getTriangle(unsigned int index, Vector3 *points) const {
+    const Vector3* positions = shape.getVertexPositions();
+    for (unsigned int i = 0; i < 3; i++) { points[i] = positions[triangles[index].vertices[i]]; }
+}
+
 std::ostream &operator<<(std::ostream &out, const RigidBodyModel &rm) {
-    if (auto rp = dynamic_cast<const RectangularPrismModel*>(&rm)) {out << "RectangularPrismModel";}
-    else {out << "RigidBodyModel";}
+    switch (rm.getType()) {
+        case RigidBodyModel::BOX: out << "RectangularPrismModel"; break;
+        case RigidBodyModel::SPHERE: out << "SphereModel"; break;
+        case RigidBodyModel::CAPSULE: out << "CapsuleModel"; break;
+        case RigidBodyModel::CONVEX_HULL: out << "ConvexHullModel"; break;
+        case RigidBodyModel::TRIANGLE_MESH: out << "TriangleMeshModel"; break;
+        default: out << "RigidBodyModel"; break;
+    }
     return out;
 }
-
@@ -2,6 +2,8 @@
 #define PHYSICSENGINE_RIGIDBODYMODEL_H
 
 
+#include <algorithm>
+#include <vector>
 #include "../math/Matrix4.h"
 #include "../render/Shape.h"
 #include "BVHTree.h"
@@ -14,8 +16,29 @@ class RigidBodyModel {
 protected:
     BoundingSphere boundingSphere;
 
+    /*
+     * Identifies which kind of model this is, so collision
+     * detection can pick a routine without a dynamic_cast.
+     */
+    unsigned int type;
+
 public:
-    explicit RigidBodyModel();
+    /*
+     * The type ids of the built-in models. Other models can
+     * get an id of their own from registerType().
+     */
+    enum Type : unsigned int { GENERIC, SPHERE, CAPSULE, BOX, CONVEX_HULL, TRIANGLE_MESH, BUILT_IN_TYPES };
+    static const unsigned int MAX_TYPES = 16;
+
+    explicit RigidBodyModel(unsigned int type = GENERIC);
+
+    /*
+     * Returns a new type id for a custom model, or
+     * MAX_TYPES if they have all been used.
+     */
+    static unsigned int registerType();
+
+    unsigned int getType() const;
 
     virtual Shape getMatchingShape(VertexColor color);
 
@@ -28,6 +51,27 @@ public:
 
     BoundingSphere getBoundingSphere() const;
 
+    /*
+     * Returns the point of the model's core that is farthest in a
+     * direction, in body space. The model is its core grown by
+     * getMargin() in every direction, which lets rounded models
+     * like spheres and capsules use a point or a segment as their
+     * core. Convex collision detection only needs these two
+     * functions, so every model that overrides them can collide
+     * with every other. By default a model collides as its
+     * bounding sphere, with the center as its core and the radius
+     * as its margin, so models that override the core should
+     * override the margin too.
+     */
+    virtual Vector3 getCoreSupportPoint(const Vector3& direction) const;
+    virtual real getMargin() const;
+
+    /*
+     * Returns the point of the model that is farthest in a
+     * direction, in body space.
+     */
+    Vector3 getSupportPoint(const Vector3& direction) const;
+
 };
 
 
@@ -39,11 +83,201 @@ private:
 public:
     RectangularPrismModel(real xLen, real yLen, real zLen);
 
+    /*
+     * Returns half the prism's length along each axis.
+     */
+    Vector3 getHalfSize() const;
+
+    Matrix4 getInverseInertiaTensor(real inverseMass) override;
+
+    Shape getMatchingShape(VertexColor color) override;
+
+    Vector3 getCoreSupportPoint(const Vector3& direction) const override;
+    real getMargin() const override;
+};
+
+class SphereModel : public RigidBodyModel {
+
+private:
+    real radius;
+
+public:
+    explicit SphereModel(real radius);
+
+    real getRadius() const;
+
+    Matrix4 getInverseInertiaTensor(real inverseMass) override;
+
+    Shape getMatchingShape(VertexColor color) override;
+
+    real getMargin() const override;
+};
+
+/*
+ * A cylinder along the y axis capped with hemispheres: the
+ * points within radius of the segment from (0,-height/2,0)
+ * to (0,height/2,0).
+ */
+class CapsuleModel : public RigidBodyModel {
+
+private:
+    real radius, height;
+
+public:
+    CapsuleModel(real radius, real height);
+
+    real getRadius() const;
+
+    /*
+     * Returns half the length of the capsule's core segment.
+     */
+    real getHalfHeight() const;
+
+    Matrix4 getInverseInertiaTensor(real inverseMass) override;
+
+    Shape getMatchingShape(VertexColor color) override;
+
+    Vector3 getCoreSupportPoint(const Vector3& direction) const override;
+    real getMargin() const override;
+};
+
+/*
+ * The convex hull of a Shape's vertices. The Shape should be a
+ * closed, convex mesh centered on its center of mass, which is
+ * used both for rendering and to integrate the inertia tensor.
+ */
+class ConvexHullModel : public RigidBodyModel {
+
+private:
+    Shape shape;
+
+public:
+    explicit ConvexHullModel(const Shape& shape);
+
     Matrix4 getInverseInertiaTensor(real inverseMass) override;
 
     Shape getMatchingShape(VertexColor color) override;
+
+    Vector3 getCoreSupportPoint(const Vector3& direction) const override;
+    real getMargin() const override;
 };
 
+/*
+ * The triangles of a Shape, for static scenery like the floor or
+ * the walls of a level. Unlike the other models it doesn't have to
+ * be convex or closed, so it can only be used by bodies with
+ * infinite mass.
+ *
+ * The triangles are sorted into a bounding volume hierarchy of
+ * axis-aligned boxes once, when the model is created, so collision
+ * detection only has to look at those near the other body. The
+ * routines in CollisionDetector that take a mesh test each of those
+ * triangles. Elsewhere, such as in GJK, the mesh is only seen as the
+ * box around it.
+ */
+class TriangleMeshModel : public RigidBodyModel {
+public:
+    /*
+     * Holds the most triangles a leaf can hold.
+     */
+    static const unsigned int MAX_LEAF_SIZE = 4;
+
+private:
+    /*
+     * The nodes are stored depth first, so a branch's first
+     * child comes straight after it.
+     */
+    struct Node {
+        Vector3 min, max;
+
+        /*
+         * For a branch, holds the index of its second child. For
+         * a leaf, holds the index of its first triangle.
+         */
+        unsigned int index;
+
+        /*
+         * Holds the number of triangles in a leaf, or 0 for a branch.
+         */
+        unsigned int count;
+    };
+
+    struct Triangle {
+        unsigned int vertices[3];
+    };
+
+    Shape shape;
+    std::vector<Triangle> triangles;
+    std::vector<Node> nodes;
+
+    /*
+     * Builds the subtree over the triangles from begin to end,
+     * reordering them, and returns the index of its root.
+     */
+    unsigned int buildNode(unsigned int begin, unsigned int end);
+
+public:
+    explicit TriangleMeshModel(const Shape& shape);
+
+    /*
+     * Returns the inertia tensor of an immovable body, whatever the mass.
+     */
+    Matrix4 getInverseInertiaTensor(real inverseMass) override;
+
+    Shape getMatchingShape(VertexColor color) override;
+
+    /*
+     * Returns a corner of the box around the whole mesh, so convex
+     * tests against the mesh as a whole are quick and never miss it.
+     */
+    Vector3 getCoreSupportPoint(const Vector3& direction) const override;
+    real getMargin() const override;
+
+    unsigned int getTriangleCount() const;
+
+    /*
+     * Writes the corners of a triangle, in body space, into points.
+     */
+    void getTriangle(unsigned int index, Vector3* points) const;
+
+    /*
+     * Calls visit with the index of every triangle whose bounding box
+     * overlaps the box from min to max, in body space.
+     */
+    template<typename Visit>
+    void forEachTriangle(const Vector3& min, const Vector3& max, Visit visit) const;
+};
+
+template<typename Visit>
+void TriangleMeshModel::forEachTriangle(const Vector3& min, const Vector3& max, Visit visit) const {
+    if (nodes.empty()) { return; }
+
+    // Halving the triangles at every split keeps the depth far below the stack size
+    unsigned int stack[64];
+    unsigned int size = 0;
+    stack[size++] = 0;
+    const Vector3* positions = shape.getVertexPositions();
+    while (size > 0) {
+        unsigned int index = stack[--size];
+        const Node& node = nodes[index];
+        if (node.min.x > max.x || node.max.x < min.x || node.min.y > max.y || node.max.y < min.y || node.min.z > max.z || node.max.z < min.z) { continue; }
+
+        if (node.count == 0) {
+            stack[size++] = node.index;
+            stack[size++] = index + 1;
+            continue;
+        }
+
+        for (unsigned int t = node.index; t < node.index + node.count; t++) {
+            const Vector3 &a = positions[triangles[t].vertices[0]], &b = positions[triangles[t].vertices[1]], &c = positions[triangles[t].vertices[2]];
+            if (std::min({a.x, b.x, c.x}) > max.x || std::max({a.x, b.x, c.x}) < min.x) { continue; }
+            if (std::min({a.y, b.y, c.y}) > max.y || std::max({a.y, b.y, c.y}) < min.y) { continue; }
+            if (std::min({a.z, b.z, c.z}) > max.z || std::max({a.z, b.z, c.z}) < min.z) { continue; }
+            visit(t);
+        }
+    }
+}
+
 std::ostream& operator<<(std::ostream &out, const RigidBodyModel &rm);
 
 #endif //PHYSICSENGINE_RIGIDBODYMODEL_H
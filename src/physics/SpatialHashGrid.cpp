@@ -0,0 +1,158 @@
+#include "SpatialHashGrid.h"
+#include "PhysicsObject.h"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHashGrid::SpatialHashGrid(real cellSize, ThreadPool& pool) : cellSize(cellSize), pool(pool), tableSize(0) {}
+
+real SpatialHashGrid::getCellSize() const { return cellSize; }
+
+void SpatialHashGrid::insert(PhysicsObject *object) {
+    objects.push_back(object);
+}
+
+bool SpatialHashGrid::remove(PhysicsObject *object) {
+    auto it = std::find(objects.begin(), objects.end(), object);
+    if (it == objects.end()) { return false; }
+    *it = objects.back();
+    objects.pop_back();
+    return true;
+}
+
+int SpatialHashGrid::cellCoordinate(real position) const {
+    return (int) std::floor(position / cellSize);
+}
+
+unsigned int SpatialHashGrid::bucketOf(int x, int y, int z) const {
+    // Multiply each coordinate by a large prime so nearby cells scatter across the table
+    return ((unsigned int) x * 73856093u ^ (unsigned int) y * 19349663u ^ (unsigned int) z * 83492791u) & (tableSize - 1);
+}
+
+void SpatialHashGrid::update() {
+    unsigned int count = objects.size();
+
+    // Keep the table at least twice the number of objects, so most buckets hold a single cell
+    unsigned int neededSize = 64;
+    while (neededSize < 2 * count) { neededSize *= 2; }
+    if (tableSize < neededSize) { tableSize = neededSize; }
+
+    unsigned int chunkCount = std::max(1u, std::min(pool.getThreadCount(), count / 1024));
+
+    centers.resize(count);
+    radii.resize(count);
+    buckets.resize(count);
+    sortedObjects.resize(count);
+    sortedCenters.resize(count);
+    sortedRadii.resize(count);
+    cellStart.assign(tableSize + 1, 0);
+    chunkOffsets.assign(chunkCount * tableSize, 0);
+
+    // Find each object's bucket, with each chunk counting how many of its objects land in each
+    pool.parallelChunks(count, chunkCount, [&](unsigned int chunk, unsigned int begin, unsigned int end) {
+        unsigned int* counts = &chunkOffsets[chunk * tableSize];
+        for (unsigned int i = begin; i < end; i++) {
+            BoundingSphere sphere = objects[i]->getBoundingSphere();
+            centers[i] = sphere.center;
+            radii[i] = sphere.radius;
+            buckets[i] = bucketOf(cellCoordinate(sphere.center.x), cellCoordinate(sphere.center.y), cellCoordinate(sphere.center.z));
+            counts[buckets[i]]++;
+        }
+    });
+
+    // Turn the counts into starting positions, ordered by bucket and then by chunk to keep the sort stable
+    unsigned int position = 0;
+    for (unsigned int bucket = 0; bucket < tableSize; bucket++) {
+        cellStart[bucket] = position;
+        for (unsigned int chunk = 0; chunk < chunkCount; chunk++) {
+            unsigned int& offset = chunkOffsets[chunk * tableSize + bucket];
+            unsigned int bucketCount = offset;
+            offset = position;
+            position += bucketCount;
+        }
+    }
+    cellStart[tableSize] = position;
+
+    pool.parallelChunks(count, chunkCount, [&](unsigned int chunk, unsigned int begin, unsigned int end) {
+        unsigned int* next = &chunkOffsets[chunk * tableSize];
+        for (unsigned int i = begin; i < end; i++) {
+            unsigned int destination = next[buckets[i]]++;
+            sortedObjects[destination] = objects[i];
+            sortedCenters[destination] = centers[i];
+            sortedRadii[destination] = radii[i];
+        }
+    });
+}
+
+unsigned int SpatialHashGrid::getPotentialContacts(std::vector<ObjectPair>& pairs) const {
+    size_t start = pairs.size();
+
+    for (unsigned int i = 0; i < sortedObjects.size(); i++) {
+        const Vector3& center = sortedCenters[i];
+        int cx = cellCoordinate(center.x), cy = cellCoordinate(center.y), cz = cellCoordinate(center.z);
+
+        // Look through the 27 cells around this one, skipping buckets
+        // that two of them hash into so no pair is reported twice
+        unsigned int visited[27];
+        unsigned int visitedCount = 0;
+        for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dz = -1; dz <= 1; dz++) {
+                    unsigned int bucket = bucketOf(cx + dx, cy + dy, cz + dz);
+                    if (std::find(visited, visited + visitedCount, bucket) != visited + visitedCount) { continue; }
+                    visited[visitedCount++] = bucket;
+
+                    // Only pair with objects later in the sorted order, so each pair is found once
+                    for (unsigned int j = std::max(cellStart[bucket], i + 1); j < cellStart[bucket + 1]; j++) {
+                        real reach = sortedRadii[i] + sortedRadii[j];
+                        if ((sortedCenters[j] - center).magnitudeSquared() <= reach*reach) {
+                            pairs.push_back({{sortedObjects[i], sortedObjects[j]}});
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return pairs.size() - start;
+}
+
+unsigned int SpatialHashGrid::getPotentialContacts(ObjectPair *pairs, unsigned int limit) const {
+    std::vector<ObjectPair> found;
+    getPotentialContacts(found);
+    unsigned int count = found.size() < limit ? found.size() : limit;
+    for (unsigned int i = 0; i < count; i++) { pairs[i] = found[i]; }
+    return count;
+}
+
+unsigned int SpatialHashGrid::getNeighbors(Vector3 center, real radius, PhysicsObject **results, unsigned int limit) const {
+    if (sortedObjects.empty()) { return 0; }
+
+    // Objects are no wider than a cell, so any that can reach the sphere
+    // have their center within half a cell of it
+    real reach = radius + cellSize / 2;
+    int minX = cellCoordinate(center.x - reach), maxX = cellCoordinate(center.x + reach);
+    int minY = cellCoordinate(center.y - reach), maxY = cellCoordinate(center.y + reach);
+    int minZ = cellCoordinate(center.z - reach), maxZ = cellCoordinate(center.z + reach);
+
+    unsigned int count = 0;
+    for (int x = minX; x <= maxX; x++) {
+        for (int y = minY; y <= maxY; y++) {
+            for (int z = minZ; z <= maxZ; z++) {
+                unsigned int bucket = bucketOf(x, y, z);
+
+                for (unsigned int j = cellStart[bucket]; j < cellStart[bucket + 1] && count < limit; j++) {
+                    const Vector3& other = sortedCenters[j];
+                    // Other cells can share the bucket; only take objects from this
+                    // cell so none are reported twice
+                    if (cellCoordinate(other.x) != x || cellCoordinate(other.y) != y || cellCoordinate(other.z) != z) { continue; }
+
+                    real distance = radius + sortedRadii[j];
+                    if ((other - center).magnitudeSquared() <= distance*distance) {
+                        results[count++] = sortedObjects[j];
+                    }
+                }
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,121 @@
+#ifndef PHYSICSENGINE_SPATIALHASHGRID_H
+#define PHYSICSENGINE_SPATIALHASHGRID_H
+
+#include <vector>
+#include "ThreadPool.h"
+#include "../math/Vector3.h"
+
+// Avoid circular dependency
+class PhysicsObject;
+
+struct ObjectPair {
+    /*
+     * Holds the objects that might be in contact.
+     */
+    PhysicsObject* objects[2];
+};
+
+/*
+ * A broad phase for large numbers of small objects, like Particles,
+ * that buckets them into a uniform grid of cubic cells.
+ *
+ * Cells are hashed into a fixed-size table, so the grid covers
+ * unbounded space. The table is rebuilt from scratch each update
+ * with a parallel counting sort over the cells, which leaves objects
+ * in the same cell next to each other in memory. Finding everything
+ * near an object then only means looking through its neighboring
+ * cells, so pair and neighbor queries take time linear in the
+ * number of objects.
+ *
+ * Pairs are only guaranteed to be found for objects whose bounding
+ * spheres are no wider than a cell.
+ */
+class SpatialHashGrid {
+private:
+    real cellSize;
+    ThreadPool& pool;
+
+    std::vector<PhysicsObject*> objects;
+
+    /*
+     * Holds the number of entries in the table, always a power of 2.
+     */
+    unsigned int tableSize;
+
+    /*
+     * Holds where each bucket's objects start in the sorted arrays,
+     * with one extra entry at the end for the total.
+     */
+    std::vector<unsigned int> cellStart;
+
+    /*
+     * The objects and their bounding spheres sorted by bucket, so a
+     * bucket's contents are contiguous.
+     */
+    std::vector<PhysicsObject*> sortedObjects;
+    std::vector<Vector3> sortedCenters;
+    std::vector<real> sortedRadii;
+
+    /*
+     * Scratch space for building, kept between builds to reuse its memory.
+     */
+    std::vector<unsigned int> buckets;
+    std::vector<Vector3> centers;
+    std::vector<real> radii;
+    std::vector<unsigned int> chunkOffsets;
+
+    /*
+     * Returns the cell coordinate a position falls into along one axis.
+     */
+    int cellCoordinate(real position) const;
+
+    /*
+     * Returns the table bucket a cell is hashed into.
+     */
+    unsigned int bucketOf(int x, int y, int z) const;
+
+public:
+    /*
+     * Creates a grid with cells of the given width, which should be
+     * at least the diameter of the largest object it will hold.
+     */
+    explicit SpatialHashGrid(real cellSize, ThreadPool& pool = ThreadPool::shared());
+
+    real getCellSize() const;
+
+    void insert(PhysicsObject* object);
+
+    /*
+     * Removes an object from the grid. Returns whether the object was found.
+     */
+    bool remove(PhysicsObject* object);
+
+    /*
+     * Re-buckets every object at its current position.
+     * Called once per step, before querying.
+     */
+    void update();
+
+    /*
+     * Appends every pair of objects whose bounding spheres overlap to
+     * the vector, growing it as needed, and returns how many were added.
+     */
+    unsigned int getPotentialContacts(std::vector<ObjectPair>& pairs) const;
+
+    /*
+     * Writes the overlapping pairs into an array and returns the
+     * number written, up to limit. Any pairs past the limit are lost,
+     * so prefer the version above, which finds them all.
+     */
+    unsigned int getPotentialContacts(ObjectPair* pairs, unsigned int limit) const;
+
+    /*
+     * Writes the objects whose bounding spheres overlap a sphere into
+     * an array and returns the number written, up to limit.
+     */
+    unsigned int getNeighbors(Vector3 center, real radius, PhysicsObject** results, unsigned int limit) const;
+
+};
+
+
+#endif //PHYSICSENGINE_SPATIALHASHGRID_H
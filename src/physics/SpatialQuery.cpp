@@ -0,0 +1,182 @@
+#include "SpatialQuery.h"
+#include "RigidBody.h"
+#include "GJK.h"
+
+#include <algorithm>
+
+/*
+ * Finds where a ray first reaches a sphere. Rays starting inside it hit straight away.
+ */
+static bool castSphere(const Vector3& center, real radius, const CastQuery& query, real& distance, Vector3& normal) {
+    Vector3 offset = query.origin - center;
+    real c = offset.magnitudeSquared() - radius*radius;
+    if (c <= 0) {
+        distance = 0;
+        normal = -query.direction;
+        return true;
+    }
+
+    real b = offset.dot(query.direction);
+    if (b > 0) { return false; }
+
+    real discriminant = b*b - c;
+    if (discriminant < 0) { return false; }
+
+    distance = -b - std::sqrt(discriminant);
+    if (distance > query.maxDistance) { return false; }
+    normal = (offset + query.direction * distance) / radius;
+    return true;
+}
+
+/*
+ * Finds where a ray first reaches a box by clipping it against the
+ * slabs between each pair of opposite faces, in the box's space.
+ */
+static bool castBox(const RigidBody* body, const Vector3& halfSize, const CastQuery& query, real& distance, Vector3& normal) {
+    const Matrix4& transform = body->getTransformMatrix();
+    Vector3 axes[3] = {Vector3(transform.getColumn(0)), Vector3(transform.getColumn(1)), Vector3(transform.getColumn(2))};
+    Vector3 offset = query.origin - body->getPosition();
+
+    real enter = 0, exit = query.maxDistance;
+    int enterAxis = -1;
+    real enterSign = 0;
+    for (int i = 0; i < 3; i++) {
+        real start = axes[i].dot(offset), speed = axes[i].dot(query.direction);
+        real half = i == 0 ? halfSize.x : i == 1 ? halfSize.y : halfSize.z;
+
+        // Parallel to the slab, so it's either always inside it or never
+        if (real_abs(speed) < (real)1e-8) {
+            if (real_abs(start) > half) { return false; }
+            continue;
+        }
+
+        real t1 = (-half - start) / speed, t2 = (half - start) / speed;
+        real sign = -1;
+        if (t1 > t2) {
+            std::swap(t1, t2);
+            sign = 1;
+        }
+        if (t1 > enter) {
+            enter = t1;
+            enterAxis = i;
+            enterSign = sign;
+        }
+        exit = std::min(exit, t2);
+        if (enter > exit) { return false; }
+    }
+
+    distance = enter;
+    normal = enterAxis < 0 ? -query.direction : axes[enterAxis] * enterSign;
+    return true;
+}
+
+/*
+ * Finds where a cast first reaches any triangle of a mesh, testing only
+ * those whose boxes overlap the box around the whole cast.
+ */
+static bool castMesh(const RigidBody* body, const CastQuery& query, real& distance, Vector3& normal) {
+    const Matrix4& transform = body->getTransformMatrix();
+    Vector3 axes[3] = {Vector3(transform.getColumn(0)), Vector3(transform.getColumn(1)), Vector3(transform.getColumn(2))};
+    Vector3 position = body->getPosition();
+    auto toBody = [&](const Vector3& point) {
+        Vector3 offset = point - position;
+        return Vector3(axes[0].dot(offset), axes[1].dot(offset), axes[2].dot(offset));
+    };
+
+    Vector3 start = toBody(query.origin), end = toBody(query.origin + query.direction * query.maxDistance);
+    Vector3 reach(query.radius, query.radius, query.radius);
+    Vector3 low = Vector3(std::min(start.x, end.x), std::min(start.y, end.y), std::min(start.z, end.z)) - reach;
+    Vector3 high = Vector3(std::max(start.x, end.x), std::max(start.y, end.y), std::max(start.z, end.z)) + reach;
+
+    auto mesh = static_cast<const TriangleMeshModel*>(body->getModel());
+    bool found = false;
+    distance = query.maxDistance;
+    mesh->forEachTriangle(low, high, [&](unsigned int t) {
+        Vector3 triangle[3];
+        mesh->getTriangle(t, triangle);
+        for (Vector3& corner : triangle) { corner = position + axes[0] * corner.x + axes[1] * corner.y + axes[2] * corner.z; }
+        real hitDistance;
+        Vector3 hitNormal;
+        if (GJK::castTriangle(triangle, query.origin, query.direction, query.radius, distance, hitDistance, hitNormal) && hitDistance <= distance) {
+            found = true;
+            distance = hitDistance;
+            normal = hitNormal;
+        }
+    });
+    return found;
+}
+
+bool SpatialQuery::castBody(const RigidBody *body, const CastQuery &query, CastHit &hit) {
+    const RigidBodyModel* model = body->getModel();
+    real distance;
+    Vector3 normal;
+    bool found;
+    if (model->getType() == RigidBodyModel::SPHERE) {
+        // A sphere cast against a sphere is a ray cast against one as big as both
+        found = castSphere(body->getPosition(), model->getMargin() + query.radius, query, distance, normal);
+    } else if (model->getType() == RigidBodyModel::BOX && query.radius == 0) {
+        found = castBox(body, static_cast<const RectangularPrismModel*>(model)->getHalfSize(), query, distance, normal);
+    } else if (model->getType() == RigidBodyModel::TRIANGLE_MESH) {
+        found = castMesh(body, query, distance, normal);
+    } else {
+        found = GJK::cast(body, query.origin, query.direction, query.radius, query.maxDistance, distance, normal);
+    }
+    if (!found) { return false; }
+
+    hit.body = const_cast<RigidBody*>(body);
+    hit.distance = distance;
+    hit.normal = normal;
+    hit.point = query.origin + query.direction * distance - normal * query.radius;
+    return true;
+}
+
+bool SpatialQuery::overlapsBody(const RigidBody *body, const BoundingSphere &sphere) {
+    const RigidBodyModel* model = body->getModel();
+    if (model->getType() == RigidBodyModel::SPHERE) {
+        real reach = model->getMargin() + sphere.radius;
+        return (body->getPosition() - sphere.center).magnitudeSquared() <= reach*reach;
+    }
+
+    // A cast that goes nowhere only hits what it starts out touching
+    real distance;
+    Vector3 normal;
+    if (model->getType() == RigidBodyModel::TRIANGLE_MESH) {
+        CastQuery query = {sphere.center, Vector3::UP, 0, sphere.radius};
+        return castMesh(body, query, distance, normal);
+    }
+    return GJK::cast(body, sphere.center, Vector3::UP, sphere.radius, 0, distance, normal);
+}
+
+void SpatialQuery::cast(const Broadphase &broadphase, const CastQuery *queries, unsigned int count, CastHit *hits, ThreadPool &pool) {
+    pool.parallelFor(count, 64, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            const CastQuery& query = queries[i];
+            CastHit& best = hits[i];
+            best.body = nullptr;
+            best.distance = query.maxDistance;
+
+            // Each hit shortens the cast, so bodies behind it aren't tested
+            broadphase.queryCast(query.origin, query.direction, query.radius, query.maxDistance, [&](RigidBody* body) {
+                CastHit hit;
+                if (castBody(body, query, hit) && hit.distance <= best.distance) { best = hit; }
+                return best.distance;
+            });
+        }
+    });
+}
+
+void SpatialQuery::overlap(const Broadphase &broadphase, const BoundingSphere *spheres, unsigned int count, RigidBody **bodies, unsigned int maxPerSphere, unsigned int *counts, ThreadPool &pool) {
+    pool.parallelFor(count, 64, [&](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) {
+            const BoundingSphere& sphere = spheres[i];
+            RigidBody** found = bodies + (size_t)i * maxPerSphere;
+            unsigned int& used = counts[i];
+            used = 0;
+
+            broadphase.queryCast(sphere.center, Vector3::UP, sphere.radius, 0, [&](RigidBody* body) {
+                if (used < maxPerSphere && overlapsBody(body, sphere)) { found[used++] = body; }
+                return (real)0;
+            });
+        }
+    });
+}
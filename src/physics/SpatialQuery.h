@@ -0,0 +1,85 @@
+#ifndef PHYSICSENGINE_SPATIALQUERY_H
+#define PHYSICSENGINE_SPATIALQUERY_H
+
+#include "Broadphase.h"
+#include "BVHTree.h"
+#include "ThreadPool.h"
+
+/*
+ * A sphere swept along a line, or a ray when its radius is 0.
+ */
+struct CastQuery {
+    Vector3 origin;
+
+    /*
+     * Holds the direction of the cast. Should be normalized.
+     */
+    Vector3 direction;
+
+    real maxDistance;
+    real radius;
+};
+
+/*
+ * Holds the first body a CastQuery hits.
+ */
+struct CastHit {
+    /*
+     * Holds the body hit, or null if the cast didn't hit anything.
+     */
+    RigidBody* body;
+
+    /*
+     * Holds how far along the cast the hit happened.
+     */
+    real distance;
+
+    /*
+     * Holds the point of the body that was hit, and the body's surface
+     * normal there, facing back along the cast (in world coordinates).
+     */
+    Vector3 point;
+    Vector3 normal;
+};
+
+/*
+ * Queries for finding bodies by where they are, like the ray casts
+ * used for line of sight, run in batches over a broad phase. Each
+ * batch is split across a ThreadPool, and every query writes its
+ * results into its own slots of the caller's arrays, so the threads
+ * never have to coordinate.
+ *
+ * Bodies are found where the broad phase last saw them, which is
+ * after they moved in the last step.
+ */
+class SpatialQuery {
+public:
+    /*
+     * Casts against a single body, filling in hit if it's hit. Rays and
+     * spheres against SphereModels and rays against RectangularPrismModels
+     * are solved directly, TriangleMeshModels are cast against each
+     * triangle near the cast, and everything else goes through GJK::cast.
+     */
+    static bool castBody(const RigidBody* body, const CastQuery& query, CastHit& hit);
+
+    /*
+     * Returns whether a sphere overlaps a body.
+     */
+    static bool overlapsBody(const RigidBody* body, const BoundingSphere& sphere);
+
+    /*
+     * Finds the first body hit by each of the queries, writing it into
+     * the matching element of hits.
+     */
+    static void cast(const Broadphase& broadphase, const CastQuery* queries, unsigned int count, CastHit* hits, ThreadPool& pool = ThreadPool::shared());
+
+    /*
+     * Finds the bodies overlapping each of the spheres. The bodies found
+     * for sphere i are written from bodies[i*maxPerSphere] onwards, up to
+     * maxPerSphere of them, and how many there are into counts[i].
+     */
+    static void overlap(const Broadphase& broadphase, const BoundingSphere* spheres, unsigned int count, RigidBody** bodies, unsigned int maxPerSphere, unsigned int* counts, ThreadPool& pool = ThreadPool::shared());
+};
+
+
+#endif //PHYSICSENGINE_SPATIALQUERY_H
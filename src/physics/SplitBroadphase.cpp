@@ -0,0 +1,75 @@
+#include "SplitBroadphase.h"
+#include "RigidBody.h"
+
+#include <algorithm>
+
+template<typename Volume>
+SplitBroadphase<Volume>::SplitBroadphase(Broadphase *dynamicBroadphase, ThreadPool &pool)
+        : dynamicBroadphase(dynamicBroadphase ? dynamicBroadphase : new BVHTree<Volume>()), pool(pool) {}
+
+template<typename Volume>
+SplitBroadphase<Volume>::~SplitBroadphase() {
+    delete dynamicBroadphase;
+}
+
+template<typename Volume>
+void SplitBroadphase<Volume>::insert(RigidBody *body) {
+    if (body->hasFiniteMass()) {
+        dynamicBroadphase->insert(body);
+        dynamicBodies.push_back(body);
+    } else {
+        staticTree.insert(body);
+    }
+}
+
+template<typename Volume>
+bool SplitBroadphase<Volume>::remove(RigidBody *body) {
+    if (dynamicBroadphase->remove(body)) {
+        dynamicBodies.erase(std::find(dynamicBodies.begin(), dynamicBodies.end(), body));
+        return true;
+    }
+    return staticTree.remove(body);
+}
+
+template<typename Volume>
+void SplitBroadphase<Volume>::update() {
+    dynamicBroadphase->update();
+    staticTree.build();
+}
+
+template<typename Volume>
+unsigned int SplitBroadphase<Volume>::getPotentialContacts(std::vector<PotentialContact> &contacts) const {
+    size_t start = contacts.size();
+    dynamicBroadphase->getPotentialContacts(contacts);
+    if (staticTree.getBodyCount() == 0) { return contacts.size() - start; }
+
+    // Only split the work up when there's enough of it to cover the overhead
+    unsigned int count = dynamicBodies.size();
+    unsigned int chunkCount = std::max(1u, std::min(pool.getThreadCount(), count / 256));
+    if (chunkCount == 1) {
+        for (RigidBody* body : dynamicBodies) { staticTree.getPotentialContacts(body, contacts); }
+        return contacts.size() - start;
+    }
+
+    // Each chunk gets its own list, joined in order afterwards
+    std::vector<std::vector<PotentialContact>> found(chunkCount);
+    pool.parallelChunks(count, chunkCount, [&](unsigned int chunk, unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++) { staticTree.getPotentialContacts(dynamicBodies[i], found[chunk]); }
+    });
+    for (const std::vector<PotentialContact>& pairs : found) {
+        contacts.insert(contacts.end(), pairs.begin(), pairs.end());
+    }
+    return contacts.size() - start;
+}
+
+template<typename Volume>
+void SplitBroadphase<Volume>::queryCast(const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, const std::function<real(RigidBody*)> &visit) const {
+    // Carry how far to look from the static tree over into the dynamic broad phase
+    maxDistance = staticTree.queryCast(origin, direction, radius, maxDistance, visit);
+    dynamicBroadphase->queryCast(origin, direction, radius, maxDistance, visit);
+}
+
+template class SplitBroadphase<BoundingSphere>;
+template class SplitBroadphase<BoundingBox>;
+template class SplitBroadphase<BoundingKDOP<14>>;
+template class SplitBroadphase<BoundingKDOP<26>>;
@@ -0,0 +1,64 @@
+#ifndef PHYSICSENGINE_SPLITBROADPHASE_H
+#define PHYSICSENGINE_SPLITBROADPHASE_H
+
+#include <vector>
+#include "Broadphase.h"
+#include "StaticBVH.h"
+#include "ThreadPool.h"
+
+/*
+ * A broad phase that keeps static bodies, those with infinite mass,
+ * apart from moving ones. Moving bodies go in another Broadphase,
+ * which finds the pairs among them as usual, while static bodies go
+ * in a StaticBVH of the given bounding volume that each moving body
+ * is then checked against. Static bodies are never paired with each
+ * other, and a large static level adds nothing to the cost of updating
+ * the moving bodies' tree.
+ *
+ * A body is sorted when it is inserted, so one whose mass changes
+ * between finite and infinite has to be removed and inserted again.
+ */
+template<typename Volume = BoundingSphere>
+class SplitBroadphase : public Broadphase {
+    Broadphase* dynamicBroadphase;
+    StaticBVH<Volume> staticTree;
+
+    /*
+     * Holds the bodies in the dynamic broad phase, to check against the static tree.
+     */
+    std::vector<RigidBody*> dynamicBodies;
+
+    ThreadPool& pool;
+
+public:
+    /*
+     * Creates a broad phase that puts moving bodies in the given one,
+     * which it then owns. Defaults to a BVHTree of the same volume.
+     */
+    explicit SplitBroadphase(Broadphase* dynamicBroadphase = nullptr, ThreadPool& pool = ThreadPool::shared());
+
+    ~SplitBroadphase() override;
+
+    void insert(RigidBody* body) override;
+
+    bool remove(RigidBody* body) override;
+
+    /*
+     * Updates the dynamic broad phase. The static tree is only
+     * rebuilt if static bodies were added or removed.
+     */
+    void update() override;
+
+    using Broadphase::getPotentialContacts;
+
+    /*
+     * Appends the pairs between moving bodies, then those between
+     * moving and static bodies, found in parallel.
+     */
+    unsigned int getPotentialContacts(std::vector<PotentialContact>& contacts) const override;
+
+    void queryCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const override;
+};
+
+
+#endif //PHYSICSENGINE_SPLITBROADPHASE_H
@@ -0,0 +1,207 @@
+#include "StaticBVH.h"
+#include "RigidBody.h"
+
+#include <algorithm>
+
+static real component(const Vector3& v, unsigned int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+template<typename Volume>
+StaticBVH<Volume>::StaticBVH() : dirty(false) {}
+
+template<typename Volume>
+void StaticBVH<Volume>::insert(RigidBody *body) {
+    entries.push_back({body, Volume()});
+    dirty = true;
+}
+
+template<typename Volume>
+bool StaticBVH<Volume>::remove(RigidBody *body) {
+    auto it = std::find_if(entries.begin(), entries.end(), [body](const Entry& e) { return e.body == body; });
+    if (it == entries.end()) { return false; }
+    *it = entries.back();
+    entries.pop_back();
+    dirty = true;
+    return true;
+}
+
+template<typename Volume>
+unsigned int StaticBVH<Volume>::getBodyCount() const { return entries.size(); }
+
+template<typename Volume>
+void StaticBVH<Volume>::build() {
+    if (!dirty) { return; }
+    dirty = false;
+
+    nodes.clear();
+    if (entries.empty()) { return; }
+    for (Entry& e : entries) { e.volume = Volume::around(e.body); }
+    nodes.reserve(2 * entries.size() - 1);
+    buildNode(0, entries.size());
+}
+
+template<typename Volume>
+unsigned int StaticBVH<Volume>::buildNode(unsigned int begin, unsigned int end) {
+    unsigned int index = nodes.size();
+    nodes.emplace_back();
+
+    // Bound the entries, and their centers for choosing a split
+    Volume volume = entries[begin].volume;
+    CollisionFilter filter = entries[begin].body->getCollisionFilter();
+    Vector3 low = volume.getCenter(), high = low;
+    for (unsigned int i = begin + 1; i < end; i++) {
+        const Volume& v = entries[i].volume;
+        Vector3 center = v.getCenter();
+        volume = Volume(volume, v);
+        filter |= entries[i].body->getCollisionFilter();
+        low = Vector3(std::min(low.x, center.x), std::min(low.y, center.y), std::min(low.z, center.z));
+        high = Vector3(std::max(high.x, center.x), std::max(high.y, center.y), std::max(high.z, center.z));
+    }
+    nodes[index].volume = volume;
+    nodes[index].filter = filter;
+
+    unsigned int count = end - begin;
+    if (count == 1) {
+        nodes[index].index = begin;
+        nodes[index].count = 1;
+        return index;
+    }
+
+    // Split along the axis the centers spread furthest over
+    Vector3 extent = high - low;
+    unsigned int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    real axisLow = component(low, axis), axisExtent = component(extent, axis);
+
+    // The chance of a query reaching a node goes with its surface area, so
+    // the expected cost of a split is the sum of each side's entries times
+    // its area, plus one traversal of this node
+    real area = volume.getSize();
+    real leafCost = count * area;
+    real bestCost = REAL_MAX;
+    unsigned int bestBin = 0;
+
+    struct Bin {
+        unsigned int count = 0;
+        Volume volume;
+    } bins[BIN_COUNT];
+
+    auto binOf = [&](const Entry& e) {
+        unsigned int bin = (component(e.volume.getCenter(), axis) - axisLow) / axisExtent * BIN_COUNT;
+        return std::min(bin, BIN_COUNT - 1);
+    };
+
+    if (axisExtent > 0) {
+        for (unsigned int i = begin; i < end; i++) {
+            Bin& bin = bins[binOf(entries[i])];
+            bin.volume = bin.count == 0 ? entries[i].volume : Volume(bin.volume, entries[i].volume);
+            bin.count++;
+        }
+
+        // Sweep from the right to find the cost of everything past each split
+        real rightCosts[BIN_COUNT];
+        Volume right;
+        unsigned int rightCount = 0;
+        for (unsigned int b = BIN_COUNT - 1; b > 0; b--) {
+            if (bins[b].count > 0) {
+                right = rightCount == 0 ? bins[b].volume : Volume(right, bins[b].volume);
+                rightCount += bins[b].count;
+            }
+            rightCosts[b] = rightCount * right.getSize();
+        }
+
+        // Then from the left, splitting before bin b
+        Volume left;
+        unsigned int leftCount = 0;
+        for (unsigned int b = 1; b < BIN_COUNT; b++) {
+            if (bins[b - 1].count > 0) {
+                left = leftCount == 0 ? bins[b - 1].volume : Volume(left, bins[b - 1].volume);
+                leftCount += bins[b - 1].count;
+            }
+            if (leftCount == 0 || leftCount == count) { continue; }
+            real cost = area + leftCount * left.getSize() + rightCosts[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestBin = b;
+            }
+        }
+    }
+
+    unsigned int middle;
+    if (bestBin > 0 && (count > MAX_LEAF_SIZE || bestCost < leafCost)) {
+        middle = std::partition(entries.begin() + begin, entries.begin() + end,
+                                [&](const Entry& e) { return binOf(e) < bestBin; }) - entries.begin();
+    } else if (count <= MAX_LEAF_SIZE) {
+        nodes[index].index = begin;
+        nodes[index].count = count;
+        return index;
+    } else {
+        // The centers are too bunched up to bin, so just halve them
+        middle = begin + count / 2;
+        std::nth_element(entries.begin() + begin, entries.begin() + middle, entries.begin() + end,
+                         [axis](const Entry& a, const Entry& b) { return component(a.volume.getCenter(), axis) < component(b.volume.getCenter(), axis); });
+    }
+
+    buildNode(begin, middle);
+    unsigned int second = buildNode(middle, end);
+    nodes[index].index = second;
+    nodes[index].count = 0;
+    return index;
+}
+
+template<typename Volume>
+void StaticBVH<Volume>::getPotentialContacts(unsigned int node, RigidBody *body, const Volume &volume, std::vector<PotentialContact> &contacts) const {
+    const Node& n = nodes[node];
+    if (!n.filter.collidesWith(body->getCollisionFilter()) || !n.volume.overlaps(&volume)) { return; }
+
+    if (n.count == 0) {
+        getPotentialContacts(node + 1, body, volume, contacts);
+        getPotentialContacts(n.index, body, volume, contacts);
+        return;
+    }
+
+    for (unsigned int i = n.index; i < n.index + n.count; i++) {
+        const Entry& e = entries[i];
+        if (e.volume.overlaps(&volume) && body->canCollideWith(e.body)) {
+            contacts.push_back({{body, e.body}});
+        }
+    }
+}
+
+template<typename Volume>
+void StaticBVH<Volume>::getPotentialContacts(RigidBody *body, std::vector<PotentialContact> &contacts) const {
+    if (nodes.empty()) { return; }
+    getPotentialContacts(0, body, Volume::around(body), contacts);
+}
+
+template<typename Volume>
+real StaticBVH<Volume>::queryCast(unsigned int node, const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, const std::function<real(RigidBody*)> &visit) const {
+    const Node& n = nodes[node];
+    if (!n.volume.overlapsCast(origin, direction, radius, maxDistance)) { return maxDistance; }
+
+    if (n.count > 0) {
+        for (unsigned int i = n.index; i < n.index + n.count; i++) {
+            if (entries[i].volume.overlapsCast(origin, direction, radius, maxDistance)) {
+                maxDistance = visit(entries[i].body);
+            }
+        }
+        return maxDistance;
+    }
+
+    // Look along the cast in order, so hits found early rule out more of the tree
+    unsigned int children[2] = {node + 1, n.index};
+    int first = (nodes[children[0]].volume.getCenter() - nodes[children[1]].volume.getCenter()).dot(direction) <= 0 ? 0 : 1;
+    maxDistance = queryCast(children[first], origin, direction, radius, maxDistance, visit);
+    return queryCast(children[1 - first], origin, direction, radius, maxDistance, visit);
+}
+
+template<typename Volume>
+real StaticBVH<Volume>::queryCast(const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, const std::function<real(RigidBody*)> &visit) const {
+    if (nodes.empty()) { return maxDistance; }
+    return queryCast(0, origin, direction, radius, maxDistance, visit);
+}
+
+template class StaticBVH<BoundingSphere>;
+template class StaticBVH<BoundingBox>;
+template class StaticBVH<BoundingKDOP<14>>;
+template class StaticBVH<BoundingKDOP<26>>;
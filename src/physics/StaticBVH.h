@@ -0,0 +1,120 @@
+#ifndef PHYSICSENGINE_STATICBVH_H
+#define PHYSICSENGINE_STATICBVH_H
+
+#include <vector>
+#include "Broadphase.h"
+#include "BVHTree.h"
+
+/*
+ * A bounding volume hierarchy over bodies that never move, like the
+ * ground or the walls of a level, with volumes of the given type like
+ * a BVHTree. It is built once, with a surface area heuristic, and
+ * never refit, so it costs nothing per step.
+ * It doesn't find pairs among its own bodies, only between them and
+ * a moving body, since two static bodies never need resolving.
+ *
+ * The tree is rebuilt the next time build is called after bodies
+ * are added or removed, so a level should add all its static bodies
+ * before the first step.
+ */
+template<typename Volume = BoundingSphere>
+class StaticBVH {
+public:
+    /*
+     * Holds the most bodies a leaf can hold.
+     */
+    static const unsigned int MAX_LEAF_SIZE = 4;
+
+    /*
+     * Holds the number of buckets body centers are sorted into along
+     * an axis when looking for the cheapest split.
+     */
+    static const unsigned int BIN_COUNT = 12;
+
+private:
+    /*
+     * A body and its bounding volume, taken when the tree was built.
+     */
+    struct Entry {
+        RigidBody* body;
+        Volume volume;
+    };
+
+    /*
+     * The nodes are stored depth first, so a branch's first
+     * child comes straight after it.
+     */
+    struct Node {
+        Volume volume;
+
+        /*
+         * Holds the CollisionFilters of the bodies under the node combined.
+         */
+        CollisionFilter filter;
+
+        /*
+         * For a branch, holds the index of its second child. For
+         * a leaf, holds the index of its first entry.
+         */
+        unsigned int index;
+
+        /*
+         * Holds the number of entries in a leaf, or 0 for a branch.
+         */
+        unsigned int count;
+    };
+
+    std::vector<Entry> entries;
+    std::vector<Node> nodes;
+
+    /*
+     * Set when bodies are added or removed, so the next build rebuilds the tree.
+     */
+    bool dirty;
+
+    /*
+     * Builds the subtree over the entries from begin to end,
+     * reordering them, and returns the index of its root.
+     */
+    unsigned int buildNode(unsigned int begin, unsigned int end);
+
+    void getPotentialContacts(unsigned int node, RigidBody* body, const Volume& volume, std::vector<PotentialContact>& contacts) const;
+
+    /*
+     * Runs a cast query from node down. Returns how far along the cast
+     * to keep looking afterwards.
+     */
+    real queryCast(unsigned int node, const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const;
+
+public:
+    StaticBVH();
+
+    void insert(RigidBody* body);
+
+    /*
+     * Removes a body. Returns whether the body was found.
+     */
+    bool remove(RigidBody* body);
+
+    /*
+     * Rebuilds the tree if bodies were added or removed since the last build.
+     */
+    void build();
+
+    unsigned int getBodyCount() const;
+
+    /*
+     * Appends a potential contact for each static body that a moving
+     * body might be touching, with the moving body first.
+     */
+    void getPotentialContacts(RigidBody* body, std::vector<PotentialContact>& contacts) const;
+
+    /*
+     * Works like Broadphase::queryCast, returning how far along
+     * the cast to keep looking afterwards.
+     */
+    real queryCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const;
+};
+
+
+#endif //PHYSICSENGINE_STATICBVH_H
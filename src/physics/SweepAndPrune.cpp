@@ -0,0 +1,168 @@
+#include "SweepAndPrune.h"
+#include "RigidBody.h"
+
+#include <algorithm>
+
+SweepAndPrune::SweepAndPrune() : inserted(0) {}
+
+uint64_t SweepAndPrune::pairKey(unsigned int proxy1, unsigned int proxy2) {
+    if (proxy1 > proxy2) { std::swap(proxy1, proxy2); }
+    return (uint64_t) proxy1 << 32 | proxy2;
+}
+
+bool SweepAndPrune::overlaps(const Proxy &p1, const Proxy &p2) const {
+    for (unsigned int axis = 0; axis < 3; axis++) {
+        if (p1.min[axis] > p2.max[axis] || p2.min[axis] > p1.max[axis]) { return false; }
+    }
+    return true;
+}
+
+void SweepAndPrune::insert(RigidBody *body) {
+    unsigned int index = proxies.size();
+    proxies.push_back({body, {0, 0, 0}, {0, 0, 0}});
+    Proxy& proxy = proxies.back();
+    setBounds(proxy);
+    indices[body] = index;
+
+    // Past the end of the lists the box overlaps nothing, which matches it having no
+    // pairs yet, so sorting its ends into place adds its pairs like any other move
+    for (unsigned int axis = 0; axis < 3; axis++) {
+        endpoints[axis].push_back({proxy.min[axis], index << 1});
+        endpoints[axis].push_back({proxy.max[axis], index << 1 | 1});
+    }
+    inserted++;
+}
+
+bool SweepAndPrune::remove(RigidBody *body) {
+    auto found = indices.find(body);
+    if (found == indices.end()) { return false; }
+    unsigned int index = found->second, last = proxies.size() - 1;
+    indices.erase(found);
+
+    // The last proxy moves into the gap, so its endpoints and pairs are renumbered.
+    // Dropping the removed proxy's endpoints leaves the rest sorted.
+    for (std::vector<Endpoint>& axis : endpoints) {
+        unsigned int kept = 0;
+        for (Endpoint e : axis) {
+            if (e.getProxy() == index) { continue; }
+            if (e.getProxy() == last) { e.data = index << 1 | (e.data & 1); }
+            axis[kept++] = e;
+        }
+        axis.resize(kept);
+    }
+
+    // Proxies only have pairs with those their boxes overlap, so testing the
+    // boxes finds the pairs to drop without going through every pair
+    for (unsigned int other = 0; other < proxies.size(); other++) {
+        if (other != index && overlaps(proxies[index], proxies[other])) { pairs.erase(pairKey(index, other)); }
+    }
+    if (index != last) {
+        for (unsigned int other = 0; other < last; other++) {
+            if (other != index && overlaps(proxies[last], proxies[other]) && pairs.erase(pairKey(last, other))) {
+                pairs.insert(pairKey(index, other));
+            }
+        }
+    }
+
+    proxies[index] = proxies.back();
+    proxies.pop_back();
+    if (index != last) { indices[proxies[index].body] = index; }
+    return true;
+}
+
+void SweepAndPrune::setBounds(Proxy &proxy) {
+    BoundingSphere sphere = proxy.body->getSweptBoundingSphere();
+    proxy.min[0] = sphere.center.x - sphere.radius; proxy.max[0] = sphere.center.x + sphere.radius;
+    proxy.min[1] = sphere.center.y - sphere.radius; proxy.max[1] = sphere.center.y + sphere.radius;
+    proxy.min[2] = sphere.center.z - sphere.radius; proxy.max[2] = sphere.center.z + sphere.radius;
+}
+
+void SweepAndPrune::updateBounds() {
+    for (Proxy& proxy : proxies) { setBounds(proxy); }
+    for (unsigned int axis = 0; axis < 3; axis++) {
+        for (Endpoint& e : endpoints[axis]) {
+            const Proxy& proxy = proxies[e.getProxy()];
+            e.value = e.isMax() ? proxy.max[axis] : proxy.min[axis];
+        }
+    }
+}
+
+void SweepAndPrune::rebuild() {
+    for (std::vector<Endpoint>& axis : endpoints) { std::sort(axis.begin(), axis.end()); }
+
+    // Sweep along the first axis, keeping track of the boxes we're inside of
+    pairs.clear();
+    active.clear();
+    activeSlots.resize(proxies.size());
+    for (const Endpoint& e : endpoints[0]) {
+        unsigned int proxy = e.getProxy();
+        if (e.isMax()) {
+            // The last active box takes the place of the one being left
+            unsigned int slot = activeSlots[proxy];
+            active[slot] = active.back();
+            activeSlots[active[slot]] = slot;
+            active.pop_back();
+        } else {
+            for (unsigned int other : active) {
+                if (overlaps(proxies[proxy], proxies[other])) { pairs.insert(pairKey(proxy, other)); }
+            }
+            activeSlots[proxy] = active.size();
+            active.push_back(proxy);
+        }
+    }
+}
+
+void SweepAndPrune::sortAxis(unsigned int axis) {
+    std::vector<Endpoint>& list = endpoints[axis];
+    for (unsigned int i = 1; i < list.size(); i++) {
+        Endpoint e = list[i];
+        unsigned int j = i;
+        for (; j > 0 && e < list[j-1]; j--) {
+            const Endpoint& passed = list[j-1];
+
+            if (!e.isMax() && passed.isMax()) {
+                // A lower end moved below an upper end, so the boxes may have started overlapping
+                if (overlaps(proxies[e.getProxy()], proxies[passed.getProxy()])) {
+                    pairs.insert(pairKey(e.getProxy(), passed.getProxy()));
+                }
+            } else if (e.isMax() && !passed.isMax()) {
+                // An upper end moved below a lower end, so the boxes have separated
+                pairs.erase(pairKey(e.getProxy(), passed.getProxy()));
+            }
+            list[j] = passed;
+        }
+        list[j] = e;
+    }
+}
+
+void SweepAndPrune::update() {
+    updateBounds();
+
+    // Sorting in a lot of new ends, like when a scene is loaded, costs more than sorting from scratch
+    if (inserted * 2 > proxies.size()) { rebuild(); }
+    else {
+        for (unsigned int axis = 0; axis < 3; axis++) { sortAxis(axis); }
+    }
+    inserted = 0;
+}
+
+unsigned int SweepAndPrune::getPotentialContacts(std::vector<PotentialContact>& contacts) const {
+    size_t start = contacts.size();
+    for (uint64_t key : pairs) {
+        RigidBody* body1 = proxies[key >> 32].body;
+        RigidBody* body2 = proxies[key & 0xffffffff].body;
+        // Overlapping pairs are tracked regardless, so filter changes don't need a rebuild
+        if (!body1->canCollideWith(body2)) { continue; }
+        contacts.push_back({{body1, body2}});
+    }
+    return contacts.size() - start;
+}
+
+void SweepAndPrune::queryCast(const Vector3 &origin, const Vector3 &direction, real radius, real maxDistance, const std::function<real(RigidBody*)> &visit) const {
+    // The axes are sorted for finding pairs, not for following a cast, so check every body
+    for (const Proxy& proxy : proxies) {
+        if (proxy.body->getSweptBoundingSphere().overlapsCast(origin, direction, radius, maxDistance)) {
+            maxDistance = visit(proxy.body);
+        }
+    }
+}
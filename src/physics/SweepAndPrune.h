@@ -0,0 +1,125 @@
+#ifndef PHYSICSENGINE_SWEEPANDPRUNE_H
+#define PHYSICSENGINE_SWEEPANDPRUNE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "Broadphase.h"
+#include "../math/precision.h"
+
+/*
+ * A "sweep and prune" broad phase, which keeps the ends of every
+ * body's bounding box sorted along each axis.
+ *
+ * Bodies that move only a little each step barely change the order,
+ * so the lists are re-sorted with an insertion sort that costs almost
+ * nothing for settled scenes like stacks. Each time two ends swap
+ * places, the pair they belong to either starts or stops overlapping
+ * on that axis, and the set of overlapping pairs is updated to match.
+ */
+class SweepAndPrune : public Broadphase {
+private:
+    struct Proxy {
+        RigidBody* body;
+
+        /*
+         * The body's bounding box, taken from its bounding sphere.
+         */
+        real min[3], max[3];
+    };
+
+    struct Endpoint {
+        real value;
+
+        /*
+         * Holds the proxy's index shifted left one bit, with the
+         * low bit set if this is the upper end of the box.
+         */
+        unsigned int data;
+
+        unsigned int getProxy() const { return data >> 1; }
+        bool isMax() const { return data & 1; }
+
+        /*
+         * Orders endpoints by value. Lower ends go first on ties,
+         * so boxes that just touch count as overlapping.
+         */
+        bool operator<(const Endpoint& other) const {
+            return value < other.value || (value == other.value && !isMax() && other.isMax());
+        }
+    };
+
+    std::vector<Proxy> proxies;
+    std::vector<Endpoint> endpoints[3];
+
+    /*
+     * Holds the index of each body's proxy.
+     */
+    std::unordered_map<RigidBody*, unsigned int> indices;
+
+    /*
+     * Holds every pair of overlapping proxies, with the lower index in the high bits.
+     */
+    std::unordered_set<uint64_t> pairs;
+
+    /*
+     * Holds how many bodies were added since the last update. Their
+     * ends are appended to the lists, and the next update sorts them
+     * into place, unless there are so many that rebuilding is faster.
+     */
+    unsigned int inserted;
+
+    /*
+     * Hold the proxies whose boxes the sweep in rebuild is inside of,
+     * and each proxy's place in that list, so leaving a box doesn't
+     * have to search for it. Kept between rebuilds to reuse their memory.
+     */
+    std::vector<unsigned int> active, activeSlots;
+
+    static uint64_t pairKey(unsigned int proxy1, unsigned int proxy2);
+
+    bool overlaps(const Proxy& p1, const Proxy& p2) const;
+
+    /*
+     * Copies a body's current bounds into its proxy.
+     */
+    static void setBounds(Proxy& proxy);
+
+    /*
+     * Copies the bodies' current bounds into their proxies and endpoints.
+     */
+    void updateBounds();
+
+    /*
+     * Sorts every axis from scratch and finds all overlapping pairs with a single sweep.
+     */
+    void rebuild();
+
+    /*
+     * Insertion sorts one axis, adding and removing pairs as endpoints pass each other.
+     */
+    void sortAxis(unsigned int axis);
+
+public:
+    SweepAndPrune();
+
+    void insert(RigidBody* body) override;
+
+    bool remove(RigidBody* body) override;
+
+    /*
+     * Re-sorts the endpoints to match the bodies' current positions.
+     */
+    void update() override;
+
+    using Broadphase::getPotentialContacts;
+
+    unsigned int getPotentialContacts(std::vector<PotentialContact>& contacts) const override;
+
+    void queryCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const override;
+
+};
+
+
+#endif //PHYSICSENGINE_SWEEPANDPRUNE_H
@@ -0,0 +1,103 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdint>
+
+// Whether the current thread is running a task, to keep nested loops from deadlocking
+static thread_local bool insideTask = false;
+
+ThreadPool::ThreadPool(unsigned int threads) : task(nullptr), taskCount(0), chunkSize(1), nextChunk(0), busyWorkers(0), generation(0), stopping(false) {
+    // The calling thread does its share of the work too
+    for (unsigned int i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (std::thread& worker : workers) { worker.join(); }
+}
+
+unsigned int ThreadPool::getThreadCount() const {
+    return workers.size() + 1;
+}
+
+void ThreadPool::workerLoop() {
+    unsigned long seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) { return; }
+            seenGeneration = generation;
+        }
+
+        runChunks();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busyWorkers == 0) { workDone.notify_one(); }
+    }
+}
+
+void ThreadPool::runChunks() {
+    insideTask = true;
+    unsigned int begin;
+    while ((begin = nextChunk.fetch_add(1) * chunkSize) < taskCount) {
+        (*task)(begin, std::min(begin + chunkSize, taskCount));
+    }
+    insideTask = false;
+}
+
+void ThreadPool::parallelFor(unsigned int count, unsigned int minChunk, const std::function<void(unsigned int, unsigned int)>& task) {
+    if (count == 0) { return; }
+
+    // Run small loops, and loops started from inside a task or while
+    // another thread's loop has the workers, on this thread
+    std::unique_lock<std::mutex> loopLock(loopMutex, std::defer_lock);
+    if (workers.empty() || insideTask || count <= minChunk || !loopLock.try_lock()) {
+        task(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        taskCount = count;
+        // Aim for a few chunks per thread so uneven chunks balance out
+        unsigned int threads = getThreadCount();
+        chunkSize = std::max(std::max(minChunk, 1u), (count + 4*threads - 1) / (4*threads));
+        nextChunk = 0;
+        busyWorkers = workers.size();
+        generation++;
+    }
+    workReady.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [&] { return busyWorkers == 0; });
+    this->task = nullptr;
+}
+
+void ThreadPool::parallelChunks(unsigned int count, unsigned int chunks, const std::function<void(unsigned int, unsigned int, unsigned int)>& task) {
+    // A lambda capturing three references is too big for std::function to hold
+    // without allocating, so they are gathered up and captured as one
+    struct ChunkTask {
+        unsigned int count, chunks;
+        const std::function<void(unsigned int, unsigned int, unsigned int)>& task;
+    } chunkTask = {count, chunks, task};
+    parallelFor(chunks, 1, [&chunkTask](unsigned int first, unsigned int last) {
+        for (unsigned int chunk = first; chunk < last; chunk++) {
+            chunkTask.task(chunk, (uint64_t) chunkTask.count * chunk / chunkTask.chunks, (uint64_t) chunkTask.count * (chunk + 1) / chunkTask.chunks);
+        }
+    });
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,92 @@
+#ifndef PHYSICSENGINE_THREADPOOL_H
+#define PHYSICSENGINE_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * A fixed set of worker threads for splitting loops over
+ * many bodies or pairs across the CPU's cores.
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workReady, workDone;
+
+    /*
+     * Held by the thread whose loop the workers are running,
+     * so only one caller hands them work at a time.
+     */
+    std::mutex loopMutex;
+
+    /*
+     * The loop currently being run, split into chunks
+     * that threads claim one at a time.
+     */
+    const std::function<void(unsigned int, unsigned int)>* task;
+    unsigned int taskCount, chunkSize;
+    std::atomic<unsigned int> nextChunk;
+
+    /*
+     * Counts the workers still running chunks of the current loop.
+     */
+    unsigned int busyWorkers;
+
+    /*
+     * Incremented for each loop, so workers can tell new work from a spurious wakeup.
+     */
+    unsigned long generation;
+
+    bool stopping;
+
+    void workerLoop();
+
+    /*
+     * Claims and runs chunks of the current loop until there are none left.
+     */
+    void runChunks();
+
+public:
+    /*
+     * Creates a pool that runs loops on the given number of threads,
+     * counting the calling thread. Defaults to one per core.
+     */
+    explicit ThreadPool(unsigned int threads = std::thread::hardware_concurrency());
+
+    ~ThreadPool();
+
+    /*
+     * Returns the number of threads loops are split across.
+     */
+    unsigned int getThreadCount() const;
+
+    /*
+     * Calls task(begin, end) on ranges covering [0, count), each holding
+     * at least minChunk elements, spread across the pool's threads. Returns
+     * once every range has run. Safe to call from several threads at once:
+     * calls made while the workers are busy with another loop, including
+     * calls from inside a task, run serially on the calling thread.
+     */
+    void parallelFor(unsigned int count, unsigned int minChunk, const std::function<void(unsigned int, unsigned int)>& task);
+
+    /*
+     * Splits [0, count) into exactly chunks even ranges and calls
+     * task(chunk, begin, end) on each, in parallel. Useful when each
+     * range needs its own slot in a scratch array, eg. for histograms.
+     */
+    void parallelChunks(unsigned int count, unsigned int chunks, const std::function<void(unsigned int, unsigned int, unsigned int)>& task);
+
+    /*
+     * Returns a pool shared by the whole engine.
+     */
+    static ThreadPool& shared();
+};
+
+
+#endif //PHYSICSENGINE_THREADPOOL_H
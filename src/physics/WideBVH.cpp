@@ -0,0 +1,169 @@
+#include "WideBVH.h"
+#include "RigidBody.h"
+
+template<unsigned int N>
+WideBVH<N>::WideBVH(MortonPrecision precision, ThreadPool& pool) : LinearBVH(precision, pool) {}
+
+template<unsigned int N>
+void WideBVH<N>::update() {
+    LinearBVH::update();
+
+    wideNodes.clear();
+    if (leafCount > 1) { collapse(0); }
+}
+
+template<unsigned int N>
+int WideBVH<N>::collapse(unsigned int index) {
+    // Start with the binary node's children, then keep opening up the
+    // largest internal child until the node is full or only bodies are left
+    unsigned int slots[N];
+    unsigned int slotCount = 2;
+    slots[0] = nodes[index].children[0];
+    slots[1] = nodes[index].children[1];
+
+    while (slotCount < N) {
+        int largest = -1;
+        for (unsigned int i = 0; i < slotCount; i++) {
+            if (!isLeaf(slots[i]) && (largest < 0 || nodes[slots[i]].volume.radius > nodes[slots[largest]].volume.radius)) {
+                largest = i;
+            }
+        }
+        if (largest < 0) { break; }
+
+        const Node& opened = nodes[slots[largest]];
+        slots[largest] = opened.children[0];
+        slots[slotCount++] = opened.children[1];
+    }
+
+    // Claim this node's index before its children claim theirs
+    int wideIndex = wideNodes.size();
+    wideNodes.emplace_back();
+    int children[N];
+    for (unsigned int i = 0; i < slotCount; i++) {
+        children[i] = isLeaf(slots[i]) ? ~(int) nodes[slots[i]].children[0] : collapse(slots[i]);
+    }
+
+    WideNode& node = wideNodes[wideIndex];
+    node.childCount = slotCount;
+    for (unsigned int i = 0; i < N; i++) {
+        if (i < slotCount) {
+            node.centers.set(i, nodes[slots[i]].volume.center);
+            node.radii[i] = nodes[slots[i]].volume.radius;
+            node.filters[i] = nodes[slots[i]].filter;
+            node.children[i] = children[i];
+        } else {
+            // Empty lanes are placed infinitely far away, so they never overlap
+            node.centers.set(i, Vector3(REAL_MAX, REAL_MAX, REAL_MAX));
+            node.radii[i] = 0;
+            node.filters[i] = CollisionFilter(0, 0);
+            node.children[i] = 0;
+        }
+    }
+    return wideIndex;
+}
+
+template<unsigned int N>
+unsigned int WideBVH<N>::overlapChildren(const WideNode& node, const BoundingSphere& volume) {
+    return BatchMath::overlapSphereBlock<N>(volume.center, volume.radius, node.centers, node.radii);
+}
+
+template<unsigned int N>
+unsigned int WideBVH<N>::filterChildren(const WideNode& node, const CollisionFilter& filter) {
+    unsigned int mask = 0;
+    for (unsigned int i = 0; i < N; i++) {
+        if (node.filters[i].collidesWith(filter)) { mask |= 1u << i; }
+    }
+    return mask;
+}
+
+template<unsigned int N>
+void WideBVH<N>::getPotentialContacts(int index, std::vector<PotentialContact>& contacts) const {
+    const WideNode& node = wideNodes[index];
+
+    // Check each pair of children against each other
+    for (unsigned int i = 0; i + 1 < node.childCount; i++) {
+        BoundingSphere volume(node.centers.get(i), node.radii[i]);
+        // Only the children after i, since the earlier ones were already checked against it
+        unsigned int overlaps = overlapChildren(node, volume) & filterChildren(node, node.filters[i]) & (~0u << (i + 1));
+
+        for (; overlaps; overlaps &= overlaps - 1) {
+            unsigned int j = __builtin_ctz(overlaps);
+            getPotentialContactsBetween(node.children[i], volume, node.filters[i], node.children[j], BoundingSphere(node.centers.get(j), node.radii[j]), node.filters[j], contacts);
+        }
+    }
+
+    // Then within each child, skipping those where no body collides with any other
+    for (unsigned int i = 0; i < node.childCount; i++) {
+        if (node.children[i] >= 0 && node.filters[i].collidesWith(node.filters[i])) {
+            getPotentialContacts(node.children[i], contacts);
+        }
+    }
+}
+
+template<unsigned int N>
+void WideBVH<N>::getPotentialContactsBetween(int child1, const BoundingSphere& volume1, const CollisionFilter& filter1, int child2, const BoundingSphere& volume2, const CollisionFilter& filter2, std::vector<PotentialContact>& contacts) const {
+    bool body1 = child1 < 0, body2 = child2 < 0;
+    // If we've reached 2 bodies that overlap, they might be in contact
+    if (body1 && body2) {
+        if (!bodies[~child1]->canCollideWith(bodies[~child2])) {return;}
+        contacts.push_back({{bodies[~child1], bodies[~child2]}});
+        return;
+    }
+
+    // Pick one node to descend into: either the non-body, or
+    // the larger one if they're both nodes
+    bool descendIntoFirst = body2 || (!body1 && volume1.radius >= volume2.radius);
+    const WideNode& splitNode = wideNodes[descendIntoFirst ? child1 : child2];
+    int other = descendIntoFirst ? child2 : child1;
+    const BoundingSphere& otherVolume = descendIntoFirst ? volume2 : volume1;
+    const CollisionFilter& otherFilter = descendIntoFirst ? filter2 : filter1;
+
+    for (unsigned int overlaps = overlapChildren(splitNode, otherVolume) & filterChildren(splitNode, otherFilter); overlaps; overlaps &= overlaps - 1) {
+        unsigned int i = __builtin_ctz(overlaps);
+        getPotentialContactsBetween(splitNode.children[i], BoundingSphere(splitNode.centers.get(i), splitNode.radii[i]), splitNode.filters[i], other, otherVolume, otherFilter, contacts);
+    }
+}
+
+template<unsigned int N>
+unsigned int WideBVH<N>::getPotentialContacts(std::vector<PotentialContact>& contacts) const {
+    if (wideNodes.empty()) { return 0; }
+    size_t start = contacts.size();
+    getPotentialContacts(0, contacts);
+    return contacts.size() - start;
+}
+
+template<unsigned int N>
+real WideBVH<N>::queryCast(int index, const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const {
+    const WideNode& node = wideNodes[index];
+    real distances[N];
+    unsigned int hits = BatchMath::overlapCastBlock<N>(origin, direction, radius, maxDistance, node.centers, node.radii, distances);
+    hits &= (1u << node.childCount) - 1;
+
+    // Look along the cast in order, so hits found early rule out more of the tree
+    unsigned int order[N], count = 0;
+    for (; hits; hits &= hits - 1) {
+        unsigned int i = __builtin_ctz(hits), j = count++;
+        for (; j > 0 && distances[order[j-1]] > distances[i]; j--) { order[j] = order[j-1]; }
+        order[j] = i;
+    }
+
+    real tested = maxDistance;
+    for (unsigned int k = 0; k < count; k++) {
+        unsigned int i = order[k];
+        // A hit may have shortened the cast so it no longer reaches this child
+        if (maxDistance < tested && !BoundingSphere(node.centers.get(i), node.radii[i]).overlapsCast(origin, direction, radius, maxDistance)) { continue; }
+        int child = node.children[i];
+        maxDistance = child < 0 ? visit(bodies[~child]) : queryCast(child, origin, direction, radius, maxDistance, visit);
+    }
+    return maxDistance;
+}
+
+template<unsigned int N>
+void WideBVH<N>::queryCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const {
+    // A single body has no wide nodes
+    if (wideNodes.empty()) { LinearBVH::queryCast(origin, direction, radius, maxDistance, visit); }
+    else { queryCast(0, origin, direction, radius, maxDistance, visit); }
+}
+
+template class WideBVH<4>;
+template class WideBVH<8>;
@@ -0,0 +1,98 @@
+#ifndef PHYSICSENGINE_WIDEBVH_H
+#define PHYSICSENGINE_WIDEBVH_H
+
+#include <vector>
+#include "LinearBVH.h"
+#include "../math/BatchMath.h"
+
+/*
+ * A LinearBVH whose binary hierarchy is collapsed into nodes with
+ * up to N children after every build, for N = 4 or 8.
+ *
+ * Each node stores its children's bounding spheres as a structure
+ * of arrays, so a sphere can be tested against all of them with one
+ * batch of SIMD instructions. The tree is a quarter or a third as
+ * deep as the binary one, and each node's bounds share cache lines,
+ * which cuts down on the memory stalls that dominate traversal.
+ */
+template<unsigned int N>
+class WideBVH : public LinearBVH {
+private:
+    struct WideNode {
+        Vec3xN<N> centers;
+        alignas(N * sizeof(real)) real radii[N];
+
+        /*
+         * Holds each child's combined CollisionFilter. Empty lanes
+         * have one that collides with nothing.
+         */
+        CollisionFilter filters[N];
+
+        /*
+         * Holds the index of each child node, or the bitwise
+         * complement of the body's index for a body.
+         */
+        int children[N];
+
+        unsigned int childCount;
+    };
+
+    /*
+     * The root is at 0. Kept between builds to reuse its memory.
+     */
+    std::vector<WideNode> wideNodes;
+
+    /*
+     * Creates a wide node from the binary internal node at index,
+     * pulling up grandchildren until it has N children, and returns its index.
+     */
+    int collapse(unsigned int index);
+
+    void getPotentialContacts(int node, std::vector<PotentialContact>& contacts) const;
+
+    /*
+     * Finds the potential contacts between two children, which
+     * can be either bodies or nodes, given their bounding spheres.
+     */
+    void getPotentialContactsBetween(int child1, const BoundingSphere& volume1, const CollisionFilter& filter1, int child2, const BoundingSphere& volume2, const CollisionFilter& filter2, std::vector<PotentialContact>& contacts) const;
+
+    /*
+     * Returns a bitmask of the children of a node that overlap a sphere.
+     */
+    static unsigned int overlapChildren(const WideNode& node, const BoundingSphere& volume);
+
+    /*
+     * Returns a bitmask of the children of a node whose filters collide with a filter.
+     */
+    static unsigned int filterChildren(const WideNode& node, const CollisionFilter& filter);
+
+    /*
+     * Visits the bodies under a node that a cast may hit, nearest
+     * first, and returns how far along the cast to keep looking.
+     */
+    real queryCast(int index, const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const;
+
+public:
+    explicit WideBVH(MortonPrecision precision = BITS_30, ThreadPool& pool = ThreadPool::shared());
+
+    /*
+     * Rebuilds the binary hierarchy, then collapses it into wide nodes.
+     */
+    void update() override;
+
+    using Broadphase::getPotentialContacts;
+
+    unsigned int getPotentialContacts(std::vector<PotentialContact>& contacts) const override;
+
+    /*
+     * Tests the cast against all of a node's children at once.
+     */
+    void queryCast(const Vector3& origin, const Vector3& direction, real radius, real maxDistance, const std::function<real(RigidBody*)>& visit) const override;
+
+};
+
+typedef WideBVH<4> BVH4;
+typedef WideBVH<8> BVH8;
+
+
+#endif //PHYSICSENGINE_WIDEBVH_H
@@ -26,7 +26,9 @@ bool MainWindow::initSDL() {
 }
 
 MainWindow::MainWindow(int width, int height, real nearClippingPlane, real farClippingPlane, real fieldOfView, real movementSpeed, real mouseSensitivity)
-: windowWidth(width),windowHeight(height),camera{nearClippingPlane, farClippingPlane, fieldOfView} {
+: windowWidth(width),windowHeight(height),
+  positionBuffer(VERTEX_BUFFER_LENGTH*2), colorBuffer(VERTEX_BUFFER_LENGTH), indexBuffer(INDEX_BUFFER_LENGTH),
+  camera{nearClippingPlane, farClippingPlane, fieldOfView} {
     view.movementSpeed = movementSpeed;
     view.mouseSensitivity = mouseSensitivity;
 }
@@ -157,9 +159,9 @@ void MainWindow::setUniforms(GLuint program) {
     // View matrix
     GLuint viewMatrixLoc = glGetUniformLocation(program,"viewMatrix");
     Matrix4 viewMatrix = Matrix4::viewMatrix(view.pos,view.azimuth,view.elevation,0);
-    GLfloat* viewMatrixArr = viewMatrix.toGLFloatArray();
+    GLfloat viewMatrixArr[16];
+    viewMatrix.writeGLFloatArray(viewMatrixArr);
     glUniformMatrix4fv(viewMatrixLoc,1,GL_TRUE,viewMatrixArr);
-    delete[] viewMatrixArr;
 
     //std::cout << "pos: " << view.pos << std::endl;
     //std::cout << "View: " << Vector3::fromAngles(view.azimuth,view.elevation,1) << std::endl;
@@ -167,9 +169,9 @@ void MainWindow::setUniforms(GLuint program) {
     // Projection matrix
     GLuint projMatrixLoc = glGetUniformLocation(program,"projectionMatrix");
     Matrix4 projMatrix = Matrix4::perspectiveProjectionMatrix(camera.fieldOfView,camera.nearClippingPlane,camera.farClippingPlane,(real)windowWidth/windowHeight);
-    GLfloat* projMatrixArr = projMatrix.toGLFloatArray();
+    GLfloat projMatrixArr[16];
+    projMatrix.writeGLFloatArray(projMatrixArr);
     glUniformMatrix4fv(projMatrixLoc,1,GL_TRUE,projMatrixArr);
-    delete[] projMatrixArr;
 
     //std::cout << "pos of (0,0,3): " << /*projMatrix.multiply(*/viewMatrix.multiply(Vector4(0,0,3,1)) << std::endl;
 
@@ -179,17 +181,6 @@ void MainWindow::setUniforms(GLuint program) {
 
 }
 
-void MainWindow::writeShape(Shape s, Matrix4 transform, bool flatShaded, bool initialWrite, Vector3* positions, VertexColor* colors, GLuint* indices, int &vertexIdx, int &indexIdx) {
-    if (s.isFlatShaded() ^ flatShaded) {return;}
-    s.writeVertexPositionsAndNormals(positions + vertexIdx*2,transform);
-    if (initialWrite) {
-        s.writeVertexColors(colors + vertexIdx);
-        s.writeIndices(indices + indexIdx, vertexIdx);
-    }
-    vertexIdx += s.numVertices();
-    indexIdx += s.numIndices();
-}
-
 void MainWindow::render(PhysicsWorld &world, bool initialWrite) {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -199,15 +190,16 @@ void MainWindow::render(PhysicsWorld &world, bool initialWrite) {
 
     if (numVertices > VERTEX_BUFFER_LENGTH || numIndices > INDEX_BUFFER_LENGTH) {
         std::cout << "Error: Exceeded maximum buffer length! Rendering incomplete scene\n";
-    }
 
-    Vector3* positions = new Vector3[numVertices*2];
-    VertexColor* colors;
-    GLuint* indices;
-    if (initialWrite) {
-        colors = new VertexColor[numVertices];
-        indices = new GLuint[numIndices];
+        // Grow the staging buffers so writing the scene stays in bounds
+        if (positionBuffer.size() < numVertices*2) { positionBuffer.resize(numVertices*2); }
+        if (colorBuffer.size() < numVertices) { colorBuffer.resize(numVertices); }
+        if (indexBuffer.size() < numIndices) { indexBuffer.resize(numIndices); }
     }
+
+    Vector3* positions = positionBuffer.data();
+    VertexColor* colors = colorBuffer.data();
+    GLuint* indices = indexBuffer.data();
     int vertexIdx = 0, indexIdx = 0;
     world.writeObjectData(false, initialWrite, positions, colors, indices, vertexIdx, indexIdx);
     unsigned int flatShadingStart = indexIdx;
@@ -229,12 +221,6 @@ void MainWindow::render(PhysicsWorld &world, bool initialWrite) {
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, INDEX_BUFFER_LENGTH * sizeof(GLuint), indices, GL_STATIC_DRAW);
     }
 
-    delete[] positions;
-    if (initialWrite) {
-        delete[] colors;
-        delete[] indices;
-    }
-
     glUseProgram(smoothShadingProgram);
     setUniforms(smoothShadingProgram);
     glDrawElements(GL_TRIANGLES,flatShadingStart,GL_UNSIGNED_INT,(GLvoid*)0);
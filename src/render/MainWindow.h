@@ -5,6 +5,7 @@
 
 #include <SDL.h>
 #include <SDL_opengl.h>
+#include <vector>
 
 #include "../math/Vector3.h"
 #include "../physics/PhysicsWorld.h"
@@ -32,6 +33,15 @@ private:
     GLuint smoothShadingProgram,flatShadingProgram;
     GLuint vao, vbo[2], ebo;
 
+    /*
+     * Staging buffers for the vertex data, kept between frames so
+     * rendering doesn't allocate. They only grow if a scene exceeds
+     * the OpenGL buffer sizes.
+     */
+    std::vector<Vector3> positionBuffer;
+    std::vector<VertexColor> colorBuffer;
+    std::vector<GLuint> indexBuffer;
+
     /*
      * Compiles a shader program from the GLSL source code
      */
@@ -84,8 +94,6 @@ public:
     void updateView(real deltaTime);
 
     void handleEvent(SDL_Event& e);
-
-    static void writeShape(Shape s, Matrix4 transform, bool flatShaded, bool initialWrite, Vector3 *positions, VertexColor *colors, GLuint *indices, int &vertexIdx, int &indexIdx);
 };
 
 
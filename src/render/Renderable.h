@@ -3,9 +3,15 @@
 
 #include "Shape.h"
 
+/*
+ * Something that isn't a PhysicsObject but still gets drawn.
+ * Like PhysicsObjects, the shape is kept around and only its
+ * transform changes between frames.
+ */
 class Renderable {
 public:
-    virtual Shape getShape() const = 0;
+    virtual const Shape& getShape() const = 0;
+    virtual Matrix4 getShapeMatrix() const = 0;
 };
 
 #endif //PHYSICSENGINE_RENDERABLE_H
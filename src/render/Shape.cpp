@@ -100,10 +100,29 @@ const Vector3* Shape::getVertexPositions() const {return vertexPositionArr;}
 const VertexColor* Shape::getVertexColors() const {return vertexColorArr;}
 const GLuint* Shape::getIndices() const {return indexArr;}
 
-void Shape::writeVertexPositionsAndNormals(Vector3* arr, Matrix4 transform) const {
+void Shape::writeVertexPositionsAndNormals(Vector3* arr, const Matrix4& transform) const {
+    Vector3 axes[3];
+    for (int i = 0; i < 3; i++) {axes[i] = Vector3(transform.getColumn(i));}
+
+    // Rotations and uniform scales keep normals perpendicular, and the shader
+    // normalizes them, so only other transforms, like a cylinder stretched
+    // along its axis, need the inverse transpose. Its cofactor matrix points
+    // the same way without a division, so a flattened shape doesn't get NaNs.
+    real scale = axes[0].magnitudeSquared(), tolerance = scale * (real)1e-4;
+    bool uniform = real_abs(axes[1].magnitudeSquared() - scale) <= tolerance && real_abs(axes[2].magnitudeSquared() - scale) <= tolerance &&
+            real_abs(axes[0].dot(axes[1])) <= tolerance && real_abs(axes[1].dot(axes[2])) <= tolerance && real_abs(axes[2].dot(axes[0])) <= tolerance;
+    Vector3 normalAxes[3] = {axes[0], axes[1], axes[2]};
+    if (!uniform) {
+        real sign = axes[0].dot(axes[1].cross(axes[2])) < 0 ? -1 : 1;
+        normalAxes[0] = axes[1].cross(axes[2]) * sign;
+        normalAxes[1] = axes[2].cross(axes[0]) * sign;
+        normalAxes[2] = axes[0].cross(axes[1]) * sign;
+    }
+
     for (int i = 0; i < vertexCount; i++) {
+        const Vector3& normal = vertexNormalArr[i];
         arr[2*i] = Vector3(transform.multiply(vertexPositionArr[i],1));
-        arr[2*i+1] = Vector3(transform.multiply(vertexNormalArr[i],0));
+        arr[2*i+1] = normalAxes[0] * normal.x + normalAxes[1] * normal.y + normalAxes[2] * normal.z;
     }
 }
 void Shape::writeVertexColors(VertexColor* arr) const {
@@ -115,6 +134,17 @@ void Shape::writeIndices(GLuint* arr, int offset) const {
     }
 }
 
+void Shape::write(const Matrix4& transform, bool flatShaded, bool initialWrite, Vector3* positions, VertexColor* colors, GLuint* indices, int &vertexIdx, int &indexIdx) const {
+    if (isFlatShaded() ^ flatShaded) {return;}
+    writeVertexPositionsAndNormals(positions + vertexIdx*2,transform);
+    if (initialWrite) {
+        writeVertexColors(colors + vertexIdx);
+        writeIndices(indices + indexIdx, vertexIdx);
+    }
+    vertexIdx += numVertices();
+    indexIdx += numIndices();
+}
+
 GLuint Shape::getOrMakeMidpoint(GLuint offset, GLuint& numNewVertices, Vector3 *positionArr, VertexColor *colorArr, GLuint v1,
                                 GLuint v2, GLuint *idxArr1, GLuint *idxArr2) {
     GLuint temp = std::max(v1,v2);
@@ -325,10 +355,21 @@ Shape Shape::icosphere(Vector3 pos, GLfloat radius, VertexColor color, int itera
     return s;
 }
 
+Shape Shape::capsule(Vector3 pos, GLfloat radius, GLfloat height, VertexColor color, int iterations) {
+    Shape s = icosphere(Vector3(), radius, color, iterations);
+
+    for (int v = 0; v < s.vertexCount; v++) {
+        s.vertexPositionArr[v].y += s.vertexPositionArr[v].y < 0 ? -height/2 : height/2;
+        s.vertexPositionArr[v] += pos;
+    }
+    s.generateVertexNormals();
+
+    return s;
+}
+
 Shape Shape::cylinder(Vector3 p1, Vector3 p2, GLfloat radius, VertexColor color, int circleVertices, bool flatShading) {
-    Vector3 axis = p2-p1;
     // Transformation from the unit cylinder to this cylinder
-    Matrix4 transformMat = Matrix4().translate(p1).rotate(M_PI_2 - axis.azimuth(), M_PI_2 - axis.elevation(), 0).scale(radius, axis.magnitude(), radius);
+    Matrix4 transformMat = cylinderTransform(p1, p2, radius);
 
     Vector3 positions[2*circleVertices+2];
     VertexColor colors[2*circleVertices+2];
@@ -382,3 +423,7 @@ Shape Shape::cylinder(Vector3 p1, Vector3 p2, GLfloat radius, VertexColor color,
     return Shape(circleVertices*2+2,positions,colors,circleVertices*4*3,indices,flatShading);
 }
 
+Matrix4 Shape::cylinderTransform(Vector3 p1, Vector3 p2, GLfloat radius) {
+    Vector3 axis = p2-p1;
+    return Matrix4().translate(p1).rotate(M_PI_2 - axis.azimuth(), M_PI_2 - axis.elevation(), 0).scale(radius, axis.magnitude(), radius);
+}
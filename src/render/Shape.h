@@ -48,10 +48,18 @@ public:
     const VertexColor* getVertexColors() const;
     const GLuint* getIndices() const;
 
-    void writeVertexPositionsAndNormals(Vector3* arr, Matrix4 transform) const;
+    void writeVertexPositionsAndNormals(Vector3* arr, const Matrix4& transform) const;
     void writeVertexColors(VertexColor* arr) const;
     void writeIndices(GLuint* arr, int offset) const;
 
+    /*
+     * Writes the shape into the vertex and index arrays at vertexIdx
+     * and indexIdx, and moves them past it. Skips the shape unless
+     * its shading matches flatShaded. Colors and indices are only
+     * written when initialWrite is set, since they don't change.
+     */
+    void write(const Matrix4& transform, bool flatShaded, bool initialWrite, Vector3* positions, VertexColor* colors, GLuint* indices, int &vertexIdx, int &indexIdx) const;
+
     /* Creates a new shape where every face of the original
      * has been split into 4 new faces. Does not work well
      * with most flat-shaded shapes */
@@ -60,9 +68,16 @@ public:
     static Shape rectangularPrism(Vector3 pos, GLfloat sideLengthX, GLfloat sideLengthY, GLfloat sideLengthZ, VertexColor color, bool flatShading);
     static Shape icosahedron(Vector3 pos, GLfloat radius, VertexColor color, bool flatShading);
     static Shape icosphere(Vector3 pos, GLfloat radius, VertexColor color, int iterations);
+    /* A capsule along the y axis, made by pulling the halves of
+     * an icosphere apart to the ends of its core segment */
+    static Shape capsule(Vector3 pos, GLfloat radius, GLfloat height, VertexColor color, int iterations);
     static Shape tiledFloor(Vector3 pos, real sideLength, real tileSideLength, VertexColor color1, VertexColor color2);
     static Shape cylinder(Vector3 p1, Vector3 p2, GLfloat radius, VertexColor color, int circleVertices, bool flatShading);
 
+    /* Returns the transform that takes a cylinder of radius 1 running
+     * from the origin to (0,1,0) onto the given cylinder */
+    static Matrix4 cylinderTransform(Vector3 p1, Vector3 p2, GLfloat radius);
+
     bool isFlatShaded() const;
 };
 
@@ -0,0 +1,106 @@
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <vector>
+
+#include "../physics/PhysicsWorld.h"
+#include "../physics/RigidBody.h"
+
+#define WARM_UP_FRAMES 300
+#define TEST_FRAMES 300
+#define UPDATES_PER_FRAME 4
+
+/*
+ * Checks that once a scene has settled, stepping the world and writing
+ * its vertex data into staging buffers, the way MainWindow::render does,
+ * doesn't touch the heap. Every allocation goes through the replaced
+ * operator new below, which counts it.
+ */
+
+static std::atomic<unsigned long> allocations(0);
+
+void* operator new(std::size_t size) {
+    allocations++;
+    if (void* p = std::malloc(size ? size : 1)) { return p; }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+int main() {
+    PhysicsWorld world(2000);
+    world.setContactResolver(new ImpulseContactResolver(10));
+    ConvexContactGenerator narrowphase(0.2);
+    world.setNarrowphase(&narrowphase);
+    world.addHalfSpace(Vector3::UP, 0, 0.2);
+    world.setParticleCollisions(true);
+
+    UniformGravityForce* gravity;
+    world.addForceGenerator(gravity = new UniformGravityForce(Vector3(0,-9.8,0)));
+
+    // A few stacks and rows of resting bodies, plus a particle on a spring
+    RigidBodyModel* cube = new RectangularPrismModel(0.5,0.5,0.5);
+    RigidBodyModel* ball = new SphereModel(0.3);
+    for (int x = 0; x < 4; x++) {
+        for (int y = 0; y < 4; y++) {
+            RigidBody* body = new RigidBody(Vector3(x*2.0f, 0.25f + y*0.5f, 0), Vector3(), Quaternion(), Vector3(), 1, true, cube, C_RED);
+            world.addObject(body);
+            world.applyForceToObject(body, gravity);
+        }
+        RigidBody* body = new RigidBody(Vector3(x*2.0f, 0.3f, 2), Vector3(), Quaternion(), Vector3(), 1, true, ball, C_BLUE);
+        world.addObject(body);
+        world.applyForceToObject(body, gravity);
+    }
+
+    Particle* anchor = new Particle(Vector3(0,5,4), Vector3(), 0, false, C_BLACK);
+    Particle* weight = new Particle(Vector3(1,4,4), Vector3(), 1, true, C_GREEN);
+    world.addObject(anchor);
+    world.addObject(weight);
+    SpringForce* spring;
+    world.addForceGenerator(spring = new SpringForce(anchor, Vector3(), weight, Vector3(), 10.0f, 1.0f, false));
+    world.applyForceToObject(weight, spring);
+    world.applyForceToObject(weight, gravity);
+
+    // The staging buffers are sized once, like MainWindow's
+    unsigned int numVertices, numIndices;
+    world.writeVertexAndIndexCounts(numVertices, numIndices);
+    std::vector<Vector3> positions(numVertices*2);
+    std::vector<VertexColor> colors(numVertices);
+    std::vector<GLuint> indices(numIndices);
+
+    auto frame = [&](bool initialWrite) {
+        for (int i = 0; i < UPDATES_PER_FRAME; i++) { world.update(1.0f / (60 * UPDATES_PER_FRAME)); }
+
+        int vertexIdx = 0, indexIdx = 0;
+        world.writeVertexAndIndexCounts(numVertices, numIndices);
+        world.writeObjectData(false, initialWrite, positions.data(), colors.data(), indices.data(), vertexIdx, indexIdx);
+        world.writeObjectData(true, initialWrite, positions.data(), colors.data(), indices.data(), vertexIdx, indexIdx);
+    };
+
+    frame(true);
+    for (int i = 0; i < WARM_UP_FRAMES; i++) { frame(false); }
+
+    int failures = 0;
+    for (int i = 0; i < TEST_FRAMES; i++) {
+        unsigned long before = allocations;
+        frame(false);
+        unsigned long allocated = allocations - before;
+        if (allocated > 0) {
+            std::cout << "Frame " << i << " made " << allocated << " allocations\n";
+            failures++;
+        }
+    }
+
+    if (failures > 0) {
+        std::cout << failures << " of " << TEST_FRAMES << " frames allocated\n";
+        return 1;
+    }
+    std::cout << "No allocations in " << TEST_FRAMES << " frames\n";
+    return 0;
+}